@@ -0,0 +1,115 @@
+/**
+ * @file clock_bench.cpp
+ * @brief Cost of one clock read for each POSIX clock source
+ *
+ * Times hal_millis()/hal_micros() under every hal_clock_source_t the
+ * platform accepts, next to the raw clock_gettime() calls they replace.
+ * Also reports how far the default HAL clock drifts from CLOCK_MONOTONIC
+ * over a short interval, and how much a plain and a precise 100 us delay
+ * overshoot.
+ */
+
+#include <time.h>
+
+#include <cstdio>
+
+#include "v4/hal.h"
+
+constexpr int ITERATIONS = 5000000;
+
+static uint64_t now_ns(clockid_t clock)
+{
+  struct timespec ts;
+  clock_gettime(clock, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+}
+
+// Runs read() ITERATIONS times and prints the average cost per call
+template <typename Read>
+static void bench(const char* name, Read read)
+{
+  volatile uint64_t sink = 0;
+  uint64_t start = now_ns(CLOCK_MONOTONIC);
+  for (int i = 0; i < ITERATIONS; i++)
+    sink = sink + read();
+  uint64_t elapsed = now_ns(CLOCK_MONOTONIC) - start;
+  printf("  %-38s %6.1f ns/call\n", name, static_cast<double>(elapsed) / ITERATIONS);
+}
+
+int main(void)
+{
+  printf("V4-hal Clock Benchmark (%d reads per source)\n", ITERATIONS);
+  printf("============================================\n\n");
+
+  bench("clock_gettime(CLOCK_MONOTONIC)", [] { return now_ns(CLOCK_MONOTONIC); });
+#ifdef CLOCK_MONOTONIC_COARSE
+  bench("clock_gettime(CLOCK_MONOTONIC_COARSE)",
+        [] { return now_ns(CLOCK_MONOTONIC_COARSE); });
+#endif
+  bench("hal_micros() before hal_init()", [] { return hal_micros(); });
+
+  int ret = hal_init();
+  if (ret != HAL_OK)
+  {
+    printf("Error: Failed to initialize HAL (error %d)\n", ret);
+    return 1;
+  }
+  hal_clock_source_t initial = hal_timer_get_source();
+
+  static const struct
+  {
+    hal_clock_source_t source;
+    const char* name;
+  } sources[] = {
+      {HAL_CLOCK_MONOTONIC, "MONOTONIC"},
+      {HAL_CLOCK_COARSE, "COARSE"},
+      {HAL_CLOCK_RAW, "RAW"},
+      {HAL_CLOCK_TSC, "TSC"},
+  };
+
+  for (const auto& s : sources)
+  {
+    char name[48];
+    printf("\n");
+    if (hal_timer_set_source(s.source) != HAL_OK)
+    {
+      printf("  %-38s unsupported\n", s.name);
+      continue;
+    }
+    snprintf(name, sizeof(name), "hal_millis() [%s]", s.name);
+    bench(name, [] { return uint64_t{hal_millis()}; });
+    snprintf(name, sizeof(name), "hal_micros() [%s]", s.name);
+    bench(name, [] { return hal_micros(); });
+  }
+  hal_timer_set_source(initial);
+
+  // Compare elapsed time against CLOCK_MONOTONIC over 200 ms
+  uint64_t hal_start = hal_micros();
+  uint64_t mono_start = now_ns(CLOCK_MONOTONIC);
+  hal_delay_ms(200);
+  long long hal_elapsed = static_cast<long long>(hal_micros() - hal_start);
+  long long mono_elapsed =
+      static_cast<long long>((now_ns(CLOCK_MONOTONIC) - mono_start) / 1000);
+  printf("\n  drift vs CLOCK_MONOTONIC over %lld us: %lld us\n", mono_elapsed,
+         hal_elapsed - mono_elapsed);
+
+  // Overshoot of a 100 us delay, plain sleep vs sleep-then-spin
+  uint64_t plain = 0, precise = 0;
+  for (int i = 0; i < 200; i++)
+  {
+    uint64_t start = hal_micros();
+    hal_delay_us(100);
+    plain += hal_micros() - start - 100;
+
+    start = hal_micros();
+    hal_delay_us_precise(100, 60);
+    precise += hal_micros() - start - 100;
+  }
+  printf("  hal_delay_us(100) mean overshoot:             %llu us\n",
+         static_cast<unsigned long long>(plain / 200));
+  printf("  hal_delay_us_precise(100, 60) mean overshoot: %llu us\n",
+         static_cast<unsigned long long>(precise / 200));
+
+  hal_deinit();
+  return 0;
+}
@@ -0,0 +1,120 @@
+/**
+ * @file trace_bench.cpp
+ * @brief Cost and loss of the POSIX GPIO waveform recorder
+ *
+ * Toggles one pin ITERATIONS times with recording off and on in each
+ * format, and reports the producer thread's CPU time per hal_gpio_write()
+ * (so time spent in the background writer is not charged to it) together
+ * with the number of transitions the per-thread buffer had to drop. The
+ * cost of one hal_micros() read, which every recorded call pays, is
+ * printed for reference.
+ */
+
+#include <time.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+
+#include "v4/hal.h"
+#include "v4/hal_sim.h"
+
+constexpr int ITERATIONS = 2000000;
+constexpr int ROUNDS = 5;
+constexpr int PIN = 5;
+
+static uint64_t thread_cpu_ns()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+}
+
+// Writes alternating levels ITERATIONS times; returns CPU ns per write
+static double toggle_loop()
+{
+  uint64_t start = thread_cpu_ns();
+  for (int i = 0; i < ITERATIONS; i++)
+    hal_gpio_write(PIN, (i & 1) ? HAL_GPIO_LOW : HAL_GPIO_HIGH);
+  return static_cast<double>(thread_cpu_ns() - start) / ITERATIONS;
+}
+
+int main(void)
+{
+  printf("V4-hal GPIO Recorder Benchmark (%d writes, best of %d)\n", ITERATIONS, ROUNDS);
+  printf("==========================================================\n\n");
+
+  int ret = hal_init();
+  if (ret != HAL_OK)
+  {
+    printf("Error: Failed to initialize HAL (error %d)\n", ret);
+    return 1;
+  }
+  hal_gpio_mode(PIN, HAL_GPIO_OUTPUT);
+
+  char path[] = "/tmp/v4_trace_bench_XXXXXX";
+  int fd = mkstemp(path);
+  if (fd < 0)
+  {
+    printf("Error: Cannot create a temporary file\n");
+    return 1;
+  }
+  close(fd);
+
+  static struct
+  {
+    hal_sim_trace_format_t format;
+    const char* name;
+    double best;
+    hal_sim_trace_stats_t worst;  // Round with the most drops
+  } formats[] = {
+      {HAL_SIM_TRACE_BINARY, "binary", 0, {}},
+      {HAL_SIM_TRACE_VCD, "VCD", 0, {}},
+  };
+
+  double off = 0;
+  for (int round = 0; round < ROUNDS; round++)
+  {
+    double ns = toggle_loop();
+    off = (round == 0 || ns < off) ? ns : off;
+
+    for (auto& f : formats)
+    {
+      if (hal_sim_gpio_record_start(path, f.format) != HAL_OK)
+      {
+        printf("Error: Cannot start recording\n");
+        return 1;
+      }
+      ns = toggle_loop();
+      hal_sim_trace_stats_t stats = {};
+      hal_sim_gpio_record_stop(&stats);
+      f.best = (round == 0 || ns < f.best) ? ns : f.best;
+      if (round == 0 || stats.dropped > f.worst.dropped)
+        f.worst = stats;
+    }
+  }
+
+  printf("  %-38s %6.1f ns/write\n", "hal_gpio_write(), recording off", off);
+  for (const auto& f : formats)
+  {
+    char name[48];
+    snprintf(name, sizeof(name), "hal_gpio_write(), recording %s", f.name);
+    printf("\n  %-38s %6.1f ns/write (+%.1f)\n", name, f.best, f.best - off);
+    printf("  %-38s %llu written, %llu dropped, %llu bytes\n", "worst round:",
+           static_cast<unsigned long long>(f.worst.events),
+           static_cast<unsigned long long>(f.worst.dropped),
+           static_cast<unsigned long long>(f.worst.bytes));
+  }
+
+  // The recorder's hot path reads the clock once per call
+  uint64_t start = thread_cpu_ns();
+  volatile uint64_t sink = 0;
+  for (int i = 0; i < ITERATIONS; i++)
+    sink = sink + hal_micros();
+  printf("\n  %-38s %6.1f ns/call\n", "hal_micros() (one per recorded call)",
+         static_cast<double>(thread_cpu_ns() - start) / ITERATIONS);
+
+  unlink(path);
+  hal_deinit();
+  return 0;
+}
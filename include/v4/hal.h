@@ -53,6 +53,64 @@ extern "C"
    */
   void hal_deinit(void);
 
+  /* ========================================================================= */
+  /* Context API                                                               */
+  /* ========================================================================= */
+
+  /**
+   * @brief Create an independent simulated board
+   *
+   * A context holds its own GPIO levels, modes and interrupt handlers,
+   * critical section and UART port table, so one process can run many
+   * VMs side by side. HAL calls act on the context bound to the calling
+   * thread (hal_context_bind()), or on the default context when none is.
+   * GPIO interrupt handlers and software timer callbacks run bound to
+   * the context they were attached or created in. Time, the console and
+   * the UART host backends are shared by all contexts.
+   *
+   * @return New context, or NULL if out of memory or the platform
+   *         simulates a single board
+   */
+  hal_context_t* hal_context_create(void);
+
+  /**
+   * @brief Destroy a context
+   *
+   * Stops the context's interrupt dispatch and any GPIO recording or
+   * stimulus replay running in it, and closes the UART handles its VMs
+   * opened with UART_INIT. Fails while any thread (or one of its
+   * interrupt handlers) is bound to it, or other UART handles opened or
+   * software timers created in it exist; a deleted timer holds the
+   * context until a callback still running returns.
+   *
+   * @param ctx Context from hal_context_create()
+   * @return HAL_OK on success, HAL_ERR_PARAM if ctx is NULL,
+   *         HAL_ERR_BUSY if ctx is bound to a thread or UART handles or
+   *         software timers created in it still exist,
+   *         HAL_ERR_NOTSUP if the platform has no contexts
+   */
+  int hal_context_destroy(hal_context_t* ctx);
+
+  /**
+   * @brief Bind the calling thread to a context
+   *
+   * The binding keeps ctx alive (hal_context_destroy() returns
+   * HAL_ERR_BUSY) until the thread binds another context, so rebind
+   * before the thread exits. A critical section entered before the
+   * rebind stays the one that nested enters and hal_critical_exit() use.
+   *
+   * @param ctx Context to act on, or NULL for the default context
+   * @return Previously bound context (NULL = default)
+   */
+  hal_context_t* hal_context_bind(hal_context_t* ctx);
+
+  /**
+   * @brief Get the context bound to the calling thread
+   *
+   * @return Bound context, or NULL for the default context
+   */
+  hal_context_t* hal_context_current(void);
+
   /* ========================================================================= */
   /* GPIO API                                                                  */
   /* ========================================================================= */
@@ -89,14 +147,76 @@ extern "C"
   /**
    * @brief Toggle GPIO pin value
    *
-   * Reads current pin state and writes the opposite value.
-   * Pin must be configured as output.
+   * Inverts the output level. Platforms with a native toggle do this in
+   * one atomic step. Pin must be configured as output.
    *
    * @param pin GPIO pin number
    * @return HAL_OK on success, negative error code on failure
    */
   int hal_gpio_toggle(int pin);
 
+  /**
+   * @brief Set and clear several output pins in one operation
+   *
+   * Bit n of each mask selects pin n (bank 0, see hal_gpio_write_bank()).
+   * Pins in neither mask keep their level. All selected pins must be
+   * configured as outputs.
+   *
+   * @param set_mask   Pins to drive high
+   * @param clear_mask Pins to drive low (must not overlap set_mask)
+   * @return HAL_OK on success, negative error code on failure
+   */
+  int hal_gpio_write_mask(uint64_t set_mask, uint64_t clear_mask);
+
+  /**
+   * @brief Read the level of every GPIO pin in one operation
+   *
+   * @param value Receives pin levels (bit n = pin n)
+   * @return HAL_OK on success, negative error code on failure
+   */
+  int hal_gpio_read_port(uint64_t* value);
+
+  /**
+   * @brief Configure several GPIO pins with the same mode
+   *
+   * @param mask Pins to configure (bit n = pin n)
+   * @param mode Pin mode
+   * @return HAL_OK on success, negative error code on failure
+   */
+  int hal_gpio_mode_mask(uint64_t mask, hal_gpio_mode_t mode);
+
+  /**
+   * @brief Set and clear several output pins of one 64-pin bank
+   *
+   * Bank n covers pins 64*n .. 64*n+63; bit b of each mask selects pin
+   * 64*n + b. Bank 0 is equivalent to hal_gpio_write_mask().
+   *
+   * @param bank       Bank index
+   * @param set_mask   Pins to drive high
+   * @param clear_mask Pins to drive low (must not overlap set_mask)
+   * @return HAL_OK on success, HAL_ERR_PARAM for an invalid bank or mask
+   */
+  int hal_gpio_write_bank(int bank, uint64_t set_mask, uint64_t clear_mask);
+
+  /**
+   * @brief Read the level of every pin of one 64-pin bank
+   *
+   * @param bank  Bank index
+   * @param value Receives pin levels (bit b = pin 64*bank + b)
+   * @return HAL_OK on success, HAL_ERR_PARAM for an invalid bank
+   */
+  int hal_gpio_read_bank(int bank, uint64_t* value);
+
+  /**
+   * @brief Configure several pins of one 64-pin bank with the same mode
+   *
+   * @param bank Bank index
+   * @param mask Pins to configure (bit b = pin 64*bank + b)
+   * @param mode Pin mode
+   * @return HAL_OK on success, HAL_ERR_PARAM for an invalid bank or mask
+   */
+  int hal_gpio_mode_bank(int bank, uint64_t mask, hal_gpio_mode_t mode);
+
   /* ========================================================================= */
   /* GPIO Interrupt API (Tier 1)                                              */
   /* ========================================================================= */
@@ -170,6 +290,30 @@ extern "C"
    */
   int hal_uart_write(hal_handle_t handle, const uint8_t* buf, size_t len);
 
+  /**
+   * @brief Gather-write data to UART
+   *
+   * Writes the segments in order as one logical write, so framed
+   * messages (header, payload, CRC) need no staging copy.
+   *
+   * @param handle UART handle
+   * @param iov    Array of segments to write
+   * @param iovcnt Number of segments
+   * @return Number of bytes written on success, negative error code on failure
+   */
+  int hal_uart_writev(hal_handle_t handle, const hal_iovec_t* iov, size_t iovcnt);
+
+  /**
+   * @brief Flush buffered UART transmit data
+   *
+   * Blocks until all data accepted by hal_uart_write() has been handed to
+   * the device (see hal_uart_tx_mode_t for the buffering policy).
+   *
+   * @param handle UART handle
+   * @return HAL_OK on success, negative error code on failure
+   */
+  int hal_uart_flush(hal_handle_t handle);
+
   /**
    * @brief Read data from UART
    *
@@ -183,6 +327,81 @@ extern "C"
    */
   int hal_uart_read(hal_handle_t handle, uint8_t* buf, size_t len);
 
+  /**
+   * @brief Read data from UART, waiting up to a timeout
+   *
+   * Blocks until len bytes have been received or timeout_us elapses,
+   * without busy polling. A timeout of 0 behaves like hal_uart_read().
+   * The timeout runs on the HAL clock, so under HAL_CLOCK_VIRTUAL it is
+   * virtual time and the waiting thread is a virtual-time participant.
+   *
+   * @param handle     UART handle
+   * @param buf        Destination buffer
+   * @param len        Bytes to read
+   * @param timeout_us Timeout in microseconds, or HAL_UART_WAIT_FOREVER
+   * @return Number of bytes read (less than len on timeout), negative error
+   *         code on failure
+   */
+  int hal_uart_read_timeout(hal_handle_t handle, uint8_t* buf, size_t len,
+                            uint32_t timeout_us);
+
+  /**
+   * @brief Read data from UART up to and including a delimiter
+   *
+   * Blocks until the delimiter is received, buf is full, or timeout_us
+   * elapses. Bytes after the delimiter stay in the receive buffer.
+   * The caller can test buf[ret - 1] == delimiter to tell a complete
+   * record from a timeout or full buffer. The timeout runs on the HAL
+   * clock, as for hal_uart_read_timeout().
+   *
+   * @param handle     UART handle
+   * @param buf        Destination buffer
+   * @param len        Size of buf
+   * @param delimiter  Byte that ends the read (e.g. '\n')
+   * @param timeout_us Timeout in microseconds, or HAL_UART_WAIT_FOREVER
+   * @return Number of bytes read, negative error code on failure
+   */
+  int hal_uart_read_until(hal_handle_t handle, uint8_t* buf, size_t len,
+                          uint8_t delimiter, uint32_t timeout_us);
+
+  /**
+   * @brief Scatter-read data from UART
+   *
+   * Fills the segments in order with available data (non-blocking).
+   * Stops at the first segment that cannot be filled completely.
+   *
+   * @param handle UART handle
+   * @param iov    Array of destination segments
+   * @param iovcnt Number of segments
+   * @return Number of bytes read on success, negative error code on failure
+   */
+  int hal_uart_readv(hal_handle_t handle, const hal_iovec_t* iov, size_t iovcnt);
+
+  /**
+   * @brief Borrow a view of received data without copying
+   *
+   * Points *data at the oldest received byte and sets *len to the number
+   * of bytes readable there contiguously (0 if nothing is pending). The
+   * view stays valid until hal_uart_rx_consume(), hal_uart_read() or
+   * hal_uart_readv() is called on the same handle. Data that wraps around
+   * the end of the receive buffer is returned by the next peek.
+   *
+   * @param handle UART handle
+   * @param data   Receives pointer to received data
+   * @param len    Receives number of contiguous bytes at *data
+   * @return HAL_OK on success, negative error code on failure
+   */
+  int hal_uart_rx_peek(hal_handle_t handle, const uint8_t** data, size_t* len);
+
+  /**
+   * @brief Release bytes previously returned by hal_uart_rx_peek()
+   *
+   * @param handle UART handle
+   * @param len    Number of bytes to release (at most the peeked length)
+   * @return HAL_OK on success, negative error code on failure
+   */
+  int hal_uart_rx_consume(hal_handle_t handle, size_t len);
+
   /**
    * @brief Get number of bytes available in UART receive buffer
    *
@@ -227,6 +446,96 @@ extern "C"
    */
   void hal_delay_us(uint32_t us);
 
+  /**
+   * @brief Precise blocking delay in microseconds
+   *
+   * Sleeps for all but the last spin_us microseconds, then busy-waits
+   * until the delay has elapsed. Use for bit-banged timing on hosts whose
+   * sleeps overshoot (Linux timer slack is typically 50 us).
+   *
+   * @param us      Microseconds to delay
+   * @param spin_us Busy-wait tail in microseconds (0 = plain sleep)
+   */
+  void hal_delay_us_precise(uint32_t us, uint32_t spin_us);
+
+  /**
+   * @brief Block until hal_micros() reaches an absolute deadline
+   *
+   * Advancing the deadline by a fixed period keeps periodic loops free of
+   * drift. Returns immediately if the deadline has already passed.
+   *
+   * @param deadline_us Absolute deadline in hal_micros() time
+   */
+  void hal_delay_until_us(uint64_t deadline_us);
+
+  /**
+   * @brief Select the clock source behind hal_millis() and hal_micros()
+   *
+   * Lets time-stamping code trade precision for cost, e.g.
+   * HAL_CLOCK_COARSE makes hal_millis() a few-ns read of the kernel tick
+   * while hal_micros() keeps full precision. Switching continues from the
+   * old source's reading, so neither hal_millis() nor hal_micros() steps
+   * backwards; they may step forward by up to one tick of the coarser
+   * source.
+   *
+   * @param source Clock source
+   * @return HAL_OK on success, HAL_ERR_PARAM for an unknown source,
+   *         HAL_ERR_NOTSUP if the platform cannot provide it
+   */
+  int hal_timer_set_source(hal_clock_source_t source);
+
+  /**
+   * @brief Get the clock source behind hal_millis() and hal_micros()
+   *
+   * @return Current clock source
+   */
+  hal_clock_source_t hal_timer_get_source(void);
+
+  /* ========================================================================= */
+  /* Software Timer API                                                        */
+  /* ========================================================================= */
+
+  /**
+   * @brief Create a software timer
+   *
+   * Timers are kept in a hierarchical timer wheel: starting and stopping
+   * are O(1) regardless of how many timers exist. Expiry resolution is
+   * V4_HAL_TIMER_TICK_US (default 1000 us); timers never fire early.
+   *
+   * @param callback  Function called on expiry
+   * @param user_data User context passed to callback
+   * @return Timer handle, or NULL if the platform has no timer service
+   */
+  hal_handle_t hal_timer_create(hal_timer_callback_t callback, void* user_data);
+
+  /**
+   * @brief Start (or restart) a software timer
+   *
+   * @param timer      Timer handle
+   * @param timeout_us Delay until the first expiry
+   * @param period_us  Interval of later expiries (0 = one-shot)
+   * @return HAL_OK on success, HAL_ERR_PARAM on invalid handle
+   */
+  int hal_timer_start(hal_handle_t timer, uint64_t timeout_us, uint64_t period_us);
+
+  /**
+   * @brief Stop a software timer
+   *
+   * A callback already running on the timer service keeps running.
+   *
+   * @param timer Timer handle
+   * @return HAL_OK on success, HAL_ERR_PARAM on invalid handle
+   */
+  int hal_timer_stop(hal_handle_t timer);
+
+  /**
+   * @brief Stop and free a software timer
+   *
+   * @param timer Timer handle (invalid after this call)
+   * @return HAL_OK on success, HAL_ERR_PARAM on invalid handle
+   */
+  int hal_timer_delete(hal_handle_t timer);
+
   /* ========================================================================= */
   /* Interrupt Control API                                                     */
   /* ========================================================================= */
@@ -241,7 +550,7 @@ extern "C"
    * - FreeRTOS: portENTER_CRITICAL()
    * - ARM Cortex-M: __disable_irq()
    * - RISC-V: clear mstatus.MIE bit
-   * - POSIX: pthread_mutex_lock()
+   * - POSIX: recursive lock (one CAS uncontended, spin-then-futex otherwise)
    *
    * Example:
    * @code
@@ -257,11 +566,134 @@ extern "C"
    * @brief Exit critical section (enable interrupts)
    *
    * Re-enables interrupts after a critical section.
-   * Must be paired with hal_critical_enter().
+   * Must be paired with hal_critical_enter() on the same thread.
    * Supports nesting - interrupts only re-enabled when all pairs are balanced.
    */
   void hal_critical_exit(void);
 
+  /**
+   * @brief Read critical section contention counters
+   *
+   * @param stats Receives the counters since startup or the last reset
+   * @return HAL_OK on success, HAL_ERR_PARAM if stats is NULL,
+   *         HAL_ERR_NOTSUP if the platform does not count contention
+   */
+  int hal_critical_stats(hal_critical_stats_t* stats);
+
+  /**
+   * @brief List the call sites that contended for the critical section
+   *
+   * Sites are return addresses of hal_critical_enter() callers (resolve
+   * them with addr2line), most contended first. Sites beyond the
+   * platform's table size are summed into one entry with a NULL site.
+   *
+   * @param sites Output array
+   * @param max   Capacity of sites
+   * @return Number of entries written (0 if the platform does not count)
+   */
+  size_t hal_critical_sites(hal_critical_site_t* sites, size_t max);
+
+  /**
+   * @brief Clear the contention counters and call sites
+   */
+  void hal_critical_stats_reset(void);
+
+  /* ========================================================================= */
+  /* Queue API                                                                 */
+  /* ========================================================================= */
+
+  /**
+   * @brief Initialize a bounded lock-free queue
+   *
+   * The queue never locks or allocates, so hal_queue_push() is safe from
+   * GPIO interrupt handlers. Elements are copied in and out by value.
+   *
+   * Example:
+   * @code
+   * static uint8_t storage[HAL_QUEUE_STORAGE_SIZE(sizeof(event_t), 64)];
+   * static hal_queue_t events;
+   * hal_queue_init(&events, HAL_QUEUE_MPSC, storage, sizeof(event_t), 64);
+   * @endcode
+   *
+   * @param queue     Queue to initialize
+   * @param mode      HAL_QUEUE_SPSC or HAL_QUEUE_MPSC
+   * @param storage   HAL_QUEUE_STORAGE_SIZE(elem_size, capacity) bytes,
+   *                  4-byte aligned, owned by the caller
+   * @param elem_size Bytes per element
+   * @param capacity  Number of elements (power of two, at least 2)
+   * @return HAL_OK on success, HAL_ERR_PARAM on invalid arguments
+   */
+  int hal_queue_init(hal_queue_t* queue, hal_queue_mode_t mode, void* storage,
+                     size_t elem_size, size_t capacity);
+
+  /**
+   * @brief Append an element
+   *
+   * SPSC queues allow one pushing context, MPSC queues any number.
+   *
+   * @param queue Queue
+   * @param item  Element to copy in (elem_size bytes)
+   * @return 1 if pushed, 0 if the queue is full, HAL_ERR_PARAM on invalid
+   *         arguments
+   */
+  int hal_queue_push(hal_queue_t* queue, const void* item);
+
+  /**
+   * @brief Remove the oldest element (single consumer)
+   *
+   * @param queue Queue
+   * @param item  Receives the element (elem_size bytes)
+   * @return 1 if popped, 0 if the queue is empty, HAL_ERR_PARAM on invalid
+   *         arguments
+   */
+  int hal_queue_pop(hal_queue_t* queue, void* item);
+
+  /**
+   * @brief Number of queued elements
+   *
+   * @param queue Queue
+   * @return Elements queued (MPSC: including ones still being written)
+   */
+  size_t hal_queue_size(const hal_queue_t* queue);
+
+  /* ========================================================================= */
+  /* Lock API                                                                  */
+  /* ========================================================================= */
+
+  /**
+   * @brief Initialize a lock
+   *
+   * Locks protect one subsystem's data without serializing on the global
+   * critical section. They nest: the owner may acquire again and must
+   * release as often as it acquired.
+   *
+   * Platform implementations:
+   * - FreeRTOS: per-lock portMUX_TYPE spinlock (portENTER_CRITICAL())
+   * - POSIX: per-lock futex (one CAS uncontended)
+   * - Others: fall back to the global critical section
+   *
+   * @param lock Lock to initialize
+   * @param name Name for diagnostics (may be NULL; not copied)
+   * @return HAL_OK on success, HAL_ERR_PARAM if lock is NULL
+   */
+  int hal_lock_init(hal_lock_t* lock, const char* name);
+
+  /**
+   * @brief Acquire a lock, waiting while another thread holds it
+   *
+   * @param lock Initialized lock
+   */
+  void hal_lock_acquire(hal_lock_t* lock);
+
+  /**
+   * @brief Release a lock
+   *
+   * Must be paired with hal_lock_acquire() on the same thread.
+   *
+   * @param lock Lock held by the caller
+   */
+  void hal_lock_release(hal_lock_t* lock);
+
   /* ========================================================================= */
   /* Console I/O API                                                           */
   /* ========================================================================= */
@@ -270,7 +702,8 @@ extern "C"
    * @brief Write data to console output
    *
    * Writes bytes to the standard console output (typically stdout or UART0).
-   * Blocks until all data is written.
+   * Blocks until all data is written, or in HAL_CONSOLE_BUFFERED mode until
+   * it has been copied into the console ring.
    *
    * @param buf Data buffer
    * @param len Number of bytes to write
@@ -282,14 +715,42 @@ extern "C"
    * @brief Read data from console input
    *
    * Reads up to len bytes from the standard console input (typically stdin or UART0).
-   * Blocking: waits until at least one byte is available.
+   * Blocking: waits until at least one byte is available. On POSIX, stdin
+   * has one consumer: an open HAL_UART_BACKEND_STDIO port owns it.
    *
    * @param buf Destination buffer
    * @param len Maximum bytes to read
-   * @return Number of bytes read on success, negative error code on failure
+   * @return Number of bytes read on success, HAL_ERR_BUSY while a STDIO
+   *         UART port owns stdin, negative error code on failure
    */
   int hal_console_read(uint8_t* buf, size_t len);
 
+  /**
+   * @brief Select the console output mode
+   *
+   * In HAL_CONSOLE_BUFFERED mode hal_console_write() copies into a
+   * lock-free ring that a background context (POSIX: a thread, ESP32: a
+   * FreeRTOS task) drains to the device, so a write is a memcpy unless the
+   * ring is full. Output reaches the device within a few milliseconds;
+   * hal_console_read() and hal_deinit() flush first. Switching back to
+   * HAL_CONSOLE_DIRECT flushes pending output.
+   *
+   * @param mode Output mode
+   * @return HAL_OK on success, HAL_ERR_NOTSUP if the platform has no
+   *         buffered console, HAL_ERR_NOMEM if the flusher cannot start
+   */
+  int hal_console_set_mode(hal_console_mode_t mode);
+
+  /**
+   * @brief Flush buffered console output
+   *
+   * Blocks until everything accepted by hal_console_write() has been
+   * handed to the device. Returns immediately in HAL_CONSOLE_DIRECT mode.
+   *
+   * @return HAL_OK on success, negative error code on failure
+   */
+  int hal_console_flush(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -14,10 +14,12 @@
  * - Move semantics for resource handles
  */
 
+#include <cassert>
 #include <stdexcept>
 #include <string>
 
 #include "v4/hal.h"
+#include "v4/hal_capabilities.h"
 #include "v4/hal_error.h"
 #include "v4/hal_types.h"
 
@@ -125,6 +127,131 @@ class HalSystem
   }
 };
 
+/* ========================================================================= */
+/* Contexts                                                                  */
+/* ========================================================================= */
+
+/**
+ * @brief RAII wrapper for a simulated-board context
+ *
+ * Creates the context on construction and destroys it on destruction.
+ * Non-copyable but movable. Close the UART handles, delete the timers
+ * and end the bindings made in it before it is destroyed: a destroy
+ * that returns HAL_ERR_BUSY asserts, and leaks the context under NDEBUG.
+ *
+ * Example:
+ * @code
+ * v4::hal::Context board;
+ * std::thread vm([&]() {
+ *   v4::hal::ContextBinding bind(board);  // This thread drives board
+ *   run_vm();
+ * });
+ * @endcode
+ */
+class Context
+{
+ public:
+  /**
+   * @brief Create context
+   * @throws Error HAL_ERR_NOTSUP if the platform has no contexts,
+   *         HAL_ERR_NOMEM if it is out of memory
+   */
+  Context()
+  {
+    ctx_ = hal_context_create();
+    if (!ctx_)
+      throw Error(hal_get_capabilities()->has_contexts ? HAL_ERR_NOMEM : HAL_ERR_NOTSUP);
+  }
+
+  /**
+   * @brief Destroy context
+   */
+  ~Context()
+  {
+    destroy(ctx_);
+  }
+
+  // Non-copyable
+  Context(const Context&) = delete;
+  Context& operator=(const Context&) = delete;
+
+  // Movable
+  Context(Context&& other) noexcept : ctx_(other.ctx_)
+  {
+    other.ctx_ = nullptr;
+  }
+
+  Context& operator=(Context&& other) noexcept
+  {
+    if (this != &other)
+    {
+      destroy(ctx_);
+      ctx_ = other.ctx_;
+      other.ctx_ = nullptr;
+    }
+    return *this;
+  }
+
+  /**
+   * @brief Get raw context
+   * @return Context handle
+   */
+  hal_context_t* get() const
+  {
+    return ctx_;
+  }
+
+ private:
+  static void destroy(hal_context_t* ctx)
+  {
+    if (ctx)
+    {
+      int ret = hal_context_destroy(ctx);
+      assert(ret == HAL_OK && "context still bound or holding UART handles or timers");
+      (void)ret;
+    }
+  }
+
+  hal_context_t* ctx_;
+};
+
+/**
+ * @brief RAII guard binding the calling thread to a context
+ *
+ * Binds on construction and restores the previous binding on
+ * destruction.
+ */
+class ContextBinding
+{
+ public:
+  /**
+   * @brief Bind context
+   * @param ctx Context to act on (NULL = default context)
+   */
+  explicit ContextBinding(hal_context_t* ctx) : previous_(hal_context_bind(ctx)) {}
+
+  /**
+   * @brief Bind context
+   * @param ctx Context object
+   */
+  explicit ContextBinding(Context& ctx) : ContextBinding(ctx.get()) {}
+
+  /**
+   * @brief Restore previous binding
+   */
+  ~ContextBinding()
+  {
+    hal_context_bind(previous_);
+  }
+
+  // Non-copyable
+  ContextBinding(const ContextBinding&) = delete;
+  ContextBinding& operator=(const ContextBinding&) = delete;
+
+ private:
+  hal_context_t* previous_;
+};
+
 /* ========================================================================= */
 /* GPIO                                                                      */
 /* ========================================================================= */
@@ -199,6 +326,77 @@ class GpioPin
   int pin_;
 };
 
+/**
+ * @brief Set and clear several output pins in one operation
+ * @param set_mask Pins to drive high (bit n = pin n)
+ * @param clear_mask Pins to drive low
+ * @throws Error if write fails
+ */
+inline void gpio_write_mask(uint64_t set_mask, uint64_t clear_mask)
+{
+  check(hal_gpio_write_mask(set_mask, clear_mask));
+}
+
+/**
+ * @brief Read the level of every GPIO pin
+ * @return Pin levels (bit n = pin n)
+ * @throws Error if read fails
+ */
+inline uint64_t gpio_read_port()
+{
+  uint64_t value;
+  check(hal_gpio_read_port(&value));
+  return value;
+}
+
+/**
+ * @brief Configure several GPIO pins with the same mode
+ * @param mask Pins to configure (bit n = pin n)
+ * @param mode Pin mode
+ * @throws Error if configuration fails
+ */
+inline void gpio_mode_mask(uint64_t mask, hal_gpio_mode_t mode)
+{
+  check(hal_gpio_mode_mask(mask, mode));
+}
+
+/**
+ * @brief Set and clear several output pins of one 64-pin bank
+ * @param bank Bank index (bit b = pin 64*bank + b)
+ * @param set_mask Pins to drive high
+ * @param clear_mask Pins to drive low
+ * @throws Error if write fails
+ */
+inline void gpio_write_bank(int bank, uint64_t set_mask, uint64_t clear_mask)
+{
+  check(hal_gpio_write_bank(bank, set_mask, clear_mask));
+}
+
+/**
+ * @brief Read the level of every pin of one 64-pin bank
+ * @param bank Bank index
+ * @return Pin levels (bit b = pin 64*bank + b)
+ * @throws Error if read fails
+ */
+inline uint64_t gpio_read_bank(int bank)
+{
+  uint64_t value;
+  check(hal_gpio_read_bank(bank, &value));
+  return value;
+}
+
+/**
+ * @brief Configure several pins of one 64-pin bank with the same mode
+ * @param bank Bank index
+ * @param mask Pins to configure (bit b = pin 64*bank + b)
+ * @param mode Pin mode
+ * @throws Error if configuration fails
+ */
+inline void gpio_mode_bank(int bank, uint64_t mask, hal_gpio_mode_t mode)
+{
+  check(hal_gpio_mode_bank(bank, mask, mode));
+}
+
 /* ========================================================================= */
 /* UART                                                                      */
 /* ========================================================================= */
@@ -281,6 +479,30 @@ class Uart
     return ret;
   }
 
+  /**
+   * @brief Gather-write data to UART
+   * @param iov Segment array
+   * @param iovcnt Number of segments
+   * @return Number of bytes written
+   * @throws Error if write fails
+   */
+  int writev(const hal_iovec_t* iov, size_t iovcnt)
+  {
+    int ret = hal_uart_writev(handle_, iov, iovcnt);
+    if (ret < 0)
+      throw Error(ret);
+    return ret;
+  }
+
+  /**
+   * @brief Flush buffered transmit data
+   * @throws Error if flush fails
+   */
+  void flush()
+  {
+    check(hal_uart_flush(handle_));
+  }
+
   /**
    * @brief Read data from UART
    * @param buf Destination buffer
@@ -296,6 +518,75 @@ class Uart
     return ret;
   }
 
+  /**
+   * @brief Read data from UART, waiting up to a timeout
+   * @param buf Destination buffer
+   * @param len Bytes to read
+   * @param timeout_us Timeout in microseconds, or HAL_UART_WAIT_FOREVER
+   * @return Number of bytes read (less than len on timeout)
+   * @throws Error if read fails
+   */
+  int read_timeout(uint8_t* buf, size_t len, uint32_t timeout_us)
+  {
+    int ret = hal_uart_read_timeout(handle_, buf, len, timeout_us);
+    if (ret < 0)
+      throw Error(ret);
+    return ret;
+  }
+
+  /**
+   * @brief Read data from UART up to and including a delimiter
+   * @param buf Destination buffer
+   * @param len Size of buf
+   * @param delimiter Byte that ends the read
+   * @param timeout_us Timeout in microseconds, or HAL_UART_WAIT_FOREVER
+   * @return Number of bytes read
+   * @throws Error if read fails
+   */
+  int read_until(uint8_t* buf, size_t len, uint8_t delimiter, uint32_t timeout_us)
+  {
+    int ret = hal_uart_read_until(handle_, buf, len, delimiter, timeout_us);
+    if (ret < 0)
+      throw Error(ret);
+    return ret;
+  }
+
+  /**
+   * @brief Scatter-read data from UART
+   * @param iov Segment array
+   * @param iovcnt Number of segments
+   * @return Number of bytes read
+   * @throws Error if read fails
+   */
+  int readv(const hal_iovec_t* iov, size_t iovcnt)
+  {
+    int ret = hal_uart_readv(handle_, iov, iovcnt);
+    if (ret < 0)
+      throw Error(ret);
+    return ret;
+  }
+
+  /**
+   * @brief Borrow a view of received data without copying
+   * @param data Receives pointer to received data
+   * @param len Receives number of contiguous bytes (0 if none)
+   * @throws Error if peek fails
+   */
+  void rx_peek(const uint8_t** data, size_t* len)
+  {
+    check(hal_uart_rx_peek(handle_, data, len));
+  }
+
+  /**
+   * @brief Release bytes previously returned by rx_peek()
+   * @param len Number of bytes to release
+   * @throws Error if len exceeds the received data
+   */
+  void rx_consume(size_t len)
+  {
+    check(hal_uart_rx_consume(handle_, len));
+  }
+
   /**
    * @brief Get number of bytes available in receive buffer
    * @return Number of bytes available
@@ -353,6 +644,136 @@ inline void delay_us(uint32_t us)
   hal_delay_us(us);
 }
 
+/**
+ * @brief Precise blocking delay in microseconds
+ * @param us Microseconds to delay
+ * @param spin_us Busy-wait tail in microseconds
+ */
+inline void delay_us_precise(uint32_t us, uint32_t spin_us)
+{
+  hal_delay_us_precise(us, spin_us);
+}
+
+/**
+ * @brief Block until micros() reaches an absolute deadline
+ * @param deadline_us Absolute deadline in micros() time
+ */
+inline void delay_until_us(uint64_t deadline_us)
+{
+  hal_delay_until_us(deadline_us);
+}
+
+/**
+ * @brief Select the clock source behind millis() and micros()
+ * @param source Clock source
+ * @throws Error if the source is unknown or unsupported
+ */
+inline void timer_set_source(hal_clock_source_t source)
+{
+  check(hal_timer_set_source(source));
+}
+
+/**
+ * @brief Get the clock source behind millis() and micros()
+ * @return Current clock source
+ */
+inline hal_clock_source_t timer_get_source()
+{
+  return hal_timer_get_source();
+}
+
+/**
+ * @brief RAII wrapper for a software timer
+ *
+ * Creates the timer on construction and deletes it on destruction.
+ * Non-copyable but movable.
+ *
+ * Example:
+ * @code
+ * v4::hal::SoftTimer blink([](hal_handle_t, void*) { hal_gpio_toggle(2); }, nullptr);
+ * blink.start(500000, 500000);  // Every 500 ms
+ * @endcode
+ */
+class SoftTimer
+{
+ public:
+  /**
+   * @brief Create timer
+   * @param callback Function called on expiry (timer service context)
+   * @param user_data User context passed to callback
+   * @throws Error if the platform has no timer service
+   */
+  SoftTimer(hal_timer_callback_t callback, void* user_data)
+  {
+    handle_ = hal_timer_create(callback, user_data);
+    if (!handle_)
+      throw Error(HAL_ERR_NOTSUP);
+  }
+
+  /**
+   * @brief Delete timer
+   */
+  ~SoftTimer()
+  {
+    if (handle_)
+    {
+      hal_timer_delete(handle_);
+    }
+  }
+
+  // Non-copyable
+  SoftTimer(const SoftTimer&) = delete;
+  SoftTimer& operator=(const SoftTimer&) = delete;
+
+  // Movable
+  SoftTimer(SoftTimer&& other) noexcept : handle_(other.handle_)
+  {
+    other.handle_ = nullptr;
+  }
+
+  SoftTimer& operator=(SoftTimer&& other) noexcept
+  {
+    if (this != &other)
+    {
+      if (handle_)
+        hal_timer_delete(handle_);
+      handle_ = other.handle_;
+      other.handle_ = nullptr;
+    }
+    return *this;
+  }
+
+  /**
+   * @brief Start or restart the timer
+   * @param timeout_us Delay until the first expiry
+   * @param period_us Interval of later expiries (0 = one-shot)
+   */
+  void start(uint64_t timeout_us, uint64_t period_us = 0)
+  {
+    check(hal_timer_start(handle_, timeout_us, period_us));
+  }
+
+  /**
+   * @brief Stop the timer
+   */
+  void stop()
+  {
+    check(hal_timer_stop(handle_));
+  }
+
+  /**
+   * @brief Get raw handle
+   * @return Timer handle
+   */
+  hal_handle_t handle() const
+  {
+    return handle_;
+  }
+
+ private:
+  hal_handle_t handle_;
+};
+
 /* ========================================================================= */
 /* Console I/O utilities                                                     */
 /* ========================================================================= */
@@ -387,6 +808,29 @@ inline int console_read(uint8_t* buf, size_t len)
   return ret;
 }
 
+/**
+ * @brief Select the console output mode
+ * @param mode HAL_CONSOLE_DIRECT or HAL_CONSOLE_BUFFERED
+ * @throws Error if the mode is not supported
+ */
+inline void console_set_mode(hal_console_mode_t mode)
+{
+  int ret = hal_console_set_mode(mode);
+  if (ret != HAL_OK)
+    throw Error(ret);
+}
+
+/**
+ * @brief Flush buffered console output
+ * @throws Error if flush fails
+ */
+inline void console_flush()
+{
+  int ret = hal_console_flush();
+  if (ret != HAL_OK)
+    throw Error(ret);
+}
+
 /* ========================================================================= */
 /* Interrupt Control utilities                                               */
 /* ========================================================================= */
@@ -421,6 +865,18 @@ inline void critical_exit()
   hal_critical_exit();
 }
 
+/**
+ * @brief Read critical section contention counters
+ * @return Counters since startup or the last hal_critical_stats_reset()
+ * @throws Error if the platform does not count contention
+ */
+inline hal_critical_stats_t critical_stats()
+{
+  hal_critical_stats_t stats;
+  check(hal_critical_stats(&stats));
+  return stats;
+}
+
 /**
  * @brief RAII wrapper for critical section
  *
@@ -459,5 +915,98 @@ class CriticalSection
   CriticalSection& operator=(const CriticalSection&) = delete;
 };
 
+/**
+ * @brief Lock owned by one subsystem
+ *
+ * Initializes a hal_lock_t on construction. Use with ScopedLock, or pass
+ * get() to the C API. Non-copyable and non-movable, since the lock's
+ * address is its identity.
+ */
+class Lock
+{
+ public:
+  /**
+   * @brief Initialize lock
+   * @param name Name for diagnostics (not copied)
+   */
+  explicit Lock(const char* name = nullptr)
+  {
+    hal_lock_init(&lock_, name);
+  }
+
+  Lock(const Lock&) = delete;
+  Lock& operator=(const Lock&) = delete;
+
+  void acquire()
+  {
+    hal_lock_acquire(&lock_);
+  }
+
+  void release()
+  {
+    hal_lock_release(&lock_);
+  }
+
+  /**
+   * @brief Get underlying C lock
+   * @return Lock object
+   */
+  hal_lock_t* get()
+  {
+    return &lock_;
+  }
+
+ private:
+  hal_lock_t lock_;
+};
+
+/**
+ * @brief RAII guard for a hal_lock_t
+ *
+ * Acquires the lock on construction and releases it on destruction.
+ *
+ * Example:
+ * @code
+ * static v4::hal::Lock queue_lock("queue");
+ * {
+ *   v4::hal::ScopedLock guard(queue_lock);
+ *   queue.push(item);
+ * }
+ * @endcode
+ */
+class ScopedLock
+{
+ public:
+  /**
+   * @brief Acquire lock
+   * @param lock Initialized lock
+   */
+  explicit ScopedLock(hal_lock_t& lock) : lock_(&lock)
+  {
+    hal_lock_acquire(lock_);
+  }
+
+  /**
+   * @brief Acquire lock
+   * @param lock Lock object
+   */
+  explicit ScopedLock(Lock& lock) : ScopedLock(*lock.get()) {}
+
+  /**
+   * @brief Release lock
+   */
+  ~ScopedLock()
+  {
+    hal_lock_release(lock_);
+  }
+
+  // Non-copyable
+  ScopedLock(const ScopedLock&) = delete;
+  ScopedLock& operator=(const ScopedLock&) = delete;
+
+ private:
+  hal_lock_t* lock_;
+};
+
 }  // namespace hal
 }  // namespace v4
@@ -26,18 +26,19 @@ extern "C"
    */
   typedef struct
   {
-    uint8_t gpio_count; /**< Number of GPIO pins */
-    uint8_t uart_count; /**< Number of UART ports */
-    uint8_t spi_count;  /**< Number of SPI buses */
-    uint8_t i2c_count;  /**< Number of I2C buses */
+    uint16_t gpio_count; /**< Number of GPIO pins */
+    uint8_t uart_count;  /**< Number of UART ports */
+    uint8_t spi_count;   /**< Number of SPI buses */
+    uint8_t i2c_count;   /**< Number of I2C buses */
 
     /** Feature flags (bitfield) */
     uint8_t has_adc : 1;  /**< ADC available */
     uint8_t has_dac : 1;  /**< DAC available */
     uint8_t has_pwm : 1;  /**< PWM available */
     uint8_t has_rtc : 1;  /**< RTC available */
-    uint8_t has_dma : 1;  /**< DMA available */
-    uint8_t reserved : 3; /**< Reserved for future use */
+    uint8_t has_dma : 1;      /**< DMA available */
+    uint8_t has_contexts : 1; /**< hal_context_create() can create boards */
+    uint8_t reserved : 2;     /**< Reserved for future use */
   } hal_capabilities_t;
 
   /**
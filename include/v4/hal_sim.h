@@ -0,0 +1,207 @@
+#ifndef V4_HAL_SIM_H
+#define V4_HAL_SIM_H
+
+/**
+ * @file hal_sim.h
+ * @brief Simulation-only API for V4 HAL
+ *
+ * Lets host-side test benches drive the simulated hardware of the POSIX
+ * platform. These functions are not available on hardware platforms.
+ * They act on the context bound to the calling thread (see
+ * hal_context_bind()); recording and replay stay with the context that
+ * started them.
+ */
+
+#include "hal_types.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+  /* ========================================================================= */
+  /* GPIO Stimulus                                                             */
+  /* ========================================================================= */
+
+  /**
+   * @brief Drive the external level of a simulated input pin
+   *
+   * Changes the value hal_gpio_read() returns for the pin and raises any
+   * matching GPIO interrupt, as if the level had changed on the wire.
+   * May be called from any thread.
+   *
+   * @param pin   GPIO pin number
+   * @param value New input level
+   * @return HAL_OK on success, HAL_ERR_PARAM if pin is invalid or an output
+   */
+  int hal_sim_gpio_input(int pin, hal_gpio_value_t value);
+
+  /* ========================================================================= */
+  /* GPIO Recording                                                            */
+  /* ========================================================================= */
+
+  /**
+   * @brief GPIO trace file format
+   *
+   * HAL_SIM_TRACE_BINARY files start with a 16-byte header: "V4GT", a
+   * version byte (1), a reserved byte, the pin count (uint16 LE) and the
+   * hal_micros() time recording started at (uint64 LE). Then follow
+   * records of two unsigned LEB128 varints: microseconds since the
+   * previous record (the first since the start time) and
+   * pin << 2 | kind, kind being 0 = low, 1 = high, 2 = input, 3 = output.
+   * Recording starts with one level and one direction record per pin.
+   *
+   * HAL_SIM_TRACE_VCD files are Value Change Dumps (timescale 1us, time 0
+   * = start) with a pinN wire for each level and pinN_out for direction.
+   */
+  typedef enum
+  {
+    HAL_SIM_TRACE_BINARY = 0, /**< Compact varint records */
+    HAL_SIM_TRACE_VCD,        /**< Value Change Dump */
+  } hal_sim_trace_format_t;
+
+  /**
+   * @brief GPIO recording statistics
+   */
+  typedef struct
+  {
+    uint64_t events;  /**< Transitions written to the file */
+    uint64_t dropped; /**< Transitions lost to full per-thread buffers */
+    uint64_t bytes;   /**< Final file size */
+  } hal_sim_trace_stats_t;
+
+  /**
+   * @brief Start recording GPIO transitions to a file
+   *
+   * Every level change (writes, toggles, bank writes, hal_sim_gpio_input())
+   * and direction change is logged with its hal_micros() time. The
+   * changing thread appends to its own lock-free buffer, and a background
+   * thread merges the buffers by time and streams them into the
+   * memory-mapped file. Recording stops at process exit if not before.
+   *
+   * Each recorded call costs one hal_micros() read plus about 15 ns of
+   * encoding (see examples/trace_bench). A transition that finds its
+   * thread's buffer full is dropped and counted in
+   * hal_sim_trace_stats_t::dropped.
+   *
+   * @param path   File to create (truncated if it exists)
+   * @param format File format
+   * @return HAL_OK on success, HAL_ERR_BUSY if already recording,
+   *         HAL_ERR_PARAM on bad arguments, HAL_ERR_IO if the file cannot
+   *         be created, HAL_ERR_NOMEM if the writer thread cannot start
+   */
+  int hal_sim_gpio_record_start(const char* path, hal_sim_trace_format_t format);
+
+  /**
+   * @brief Stop recording and finish the trace file
+   *
+   * @param stats Receives recording statistics (may be NULL)
+   * @return HAL_OK on success, HAL_ERR_PARAM if not recording,
+   *         HAL_ERR_IO if the file could not be written
+   */
+  int hal_sim_gpio_record_stop(hal_sim_trace_stats_t* stats);
+
+  /* ========================================================================= */
+  /* Stimulus Replay                                                           */
+  /* ========================================================================= */
+
+  /**
+   * @brief Stimulus replay statistics
+   */
+  typedef struct
+  {
+    uint64_t gpio_events; /**< Pin levels applied */
+    uint64_t uart_bytes;  /**< Bytes delivered to UART RX rings */
+    uint64_t ignored;     /**< Pin records for output or absent pins */
+    uint64_t dropped;     /**< UART bytes with no open port or ring space */
+    uint64_t max_late_us; /**< Worst delay of an event past its time */
+  } hal_sim_stimulus_stats_t;
+
+  /**
+   * @brief Start replaying a stimulus file
+   *
+   * Stimulus files use the HAL_SIM_TRACE_BINARY layout with the magic
+   * "V4SI": a 16-byte header (magic, version 1, reserved byte, pin count
+   * and start time, the last two informational), then records of a
+   * varint delta in microseconds and a varint code. Code pin << 2 | 0 or
+   * pin << 2 | 1 drives an input pin low or high; port << 2 | 2 is
+   * followed by a varint length and that many bytes received on a UART
+   * port. Kind 3 is reserved. A "V4GT" recording is accepted as well; its
+   * direction records are skipped.
+   *
+   * File time 0 is the hal_micros() time of this call. A background
+   * thread applies each record when its time is reached: pin levels as by
+   * hal_sim_gpio_input(), raising GPIO interrupts, and UART bytes into
+   * the RX ring of the handle open on the port. The file is memory-mapped
+   * a window at a time, so files of any size replay in constant memory.
+   * Under HAL_CLOCK_VIRTUAL the replay thread is a virtual-time
+   * participant and events fire at their exact time.
+   *
+   * @param path Stimulus file
+   * @return HAL_OK on success, HAL_ERR_BUSY if a replay was started and
+   *         not stopped, HAL_ERR_PARAM if path is NULL, HAL_ERR_IO if the
+   *         file cannot be opened or has no valid header, HAL_ERR_NOMEM if
+   *         the replay thread cannot start
+   */
+  int hal_sim_stimulus_start(const char* path);
+
+  /**
+   * @brief Wait for the replay to reach the end of the file
+   *
+   * Waits in real time; a virtual-time participant should detach first.
+   *
+   * @param timeout_ms Maximum wait in milliseconds
+   * @return HAL_OK if the replay has finished, HAL_ERR_TIMEOUT otherwise,
+   *         HAL_ERR_PARAM if no replay was started
+   */
+  int hal_sim_stimulus_wait(uint32_t timeout_ms);
+
+  /**
+   * @brief Stop the replay (if still running) and close the file
+   *
+   * @param stats Receives replay statistics (may be NULL)
+   * @return HAL_OK on success, HAL_ERR_PARAM if no replay was started,
+   *         HAL_ERR_IO if the replay ended on a malformed record
+   */
+  int hal_sim_stimulus_stop(hal_sim_stimulus_stats_t* stats);
+
+  /* ========================================================================= */
+  /* Virtual Time                                                              */
+  /* ========================================================================= */
+
+  /**
+   * @brief Advance the virtual clock
+   *
+   * Moves HAL_CLOCK_VIRTUAL time forward as if that much time had passed,
+   * waking delays and software timers that fall due. Lets a test bench
+   * drive time without sleeping in a HAL delay itself.
+   *
+   * @param us Microseconds to advance
+   * @return HAL_OK on success, HAL_ERR_NOTSUP if virtual time is not selected
+   */
+  int hal_sim_time_advance(uint64_t us);
+
+  /**
+   * @brief Make the calling thread a virtual-time participant
+   *
+   * Virtual time only advances while every participant waits in a HAL
+   * delay. Threads join automatically on their first virtual-time delay;
+   * attaching earlier keeps the clock from moving while the thread
+   * starts up.
+   */
+  void hal_sim_time_attach(void);
+
+  /**
+   * @brief Stop the calling thread from holding virtual time
+   *
+   * Call before blocking outside the HAL (e.g. joining a thread), or the
+   * clock stalls until V4_HAL_POSIX_VIRTUAL_STALL_US of real time passes.
+   * The next virtual-time delay attaches the thread again.
+   */
+  void hal_sim_time_detach(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // V4_HAL_SIM_H
@@ -0,0 +1,131 @@
+#ifndef V4_HAL_SYS_H
+#define V4_HAL_SYS_H
+
+/**
+ * @file hal_sys.h
+ * @brief Table-driven SYS instruction dispatch for V4 HAL
+ *
+ * hal_sys_table maps every SYS id to a handler and its stack effect, so a
+ * VM dispatches SYS with one indirect call and applies the stack effect
+ * in bulk instead of hand-writing a switch:
+ *
+ *   const hal_sys_entry_t* e = &hal_sys_table[id];
+ *   if (!e->fn || depth < e->in || room < e->out - e->in)
+ *     ... unknown id or stack error ...
+ *   sp -= e->in;
+ *   e->fn(sp);
+ *   sp += e->out;
+ *
+ * A handler reads its arguments from args[0..in-1] (args[0] was pushed
+ * first) and writes its results to args[0..out-1] in push order, so args
+ * must have room for the larger of in and out. SYS ids come from
+ * hal_sys.def, which a VM may also include to build computed-goto labels.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+  /**
+   * @brief VM data stack cell
+   */
+  typedef int32_t hal_sys_cell_t;
+
+  /**
+   * @brief SYS handler
+   *
+   * @param args Arguments on entry, results on return
+   */
+  typedef void (*hal_sys_fn_t)(hal_sys_cell_t* args);
+
+  /**
+   * @brief SYS dispatch table entry
+   *
+   * Unassigned ids have fn == NULL and in == out == 0.
+   */
+  typedef struct
+  {
+    hal_sys_fn_t fn;    /**< Handler */
+    uint8_t in;         /**< Cells popped */
+    uint8_t out;        /**< Cells pushed */
+    const char* name;   /**< Operation name, e.g. "GPIO_INIT" */
+    const char* effect; /**< Stack effect, e.g. "( pin mode -- err )" */
+  } hal_sys_entry_t;
+
+  // Define SYS ids using X-macro
+#define HAL_SYS(name, id, in, out, effect) HAL_SYS_##name = id,
+  enum
+  {
+#include "hal_sys.def"
+  };
+#undef HAL_SYS
+
+  /**
+   * @brief Largest number of cells any SYS operation pops or pushes
+   */
+#define HAL_SYS_MAX_CELLS 2
+
+  /**
+   * @brief One operation of a hal_submit_batch() sequence
+   *
+   * Example: { HAL_SYS_GPIO_WRITE, { 3, 1 } } drives pin 3 high.
+   */
+  typedef struct
+  {
+    uint8_t sys;                             /**< SYS id */
+    hal_sys_cell_t args[HAL_SYS_MAX_CELLS]; /**< Arguments, args[0] pushed first */
+  } hal_op_t;
+
+  /**
+   * @brief SYS dispatch table, indexed by SYS id
+   */
+  extern const hal_sys_entry_t hal_sys_table[256];
+
+  /**
+   * @brief Run one SYS operation
+   *
+   * Convenience wrapper around hal_sys_table for VMs that check the stack
+   * themselves.
+   *
+   * @param id   SYS id
+   * @param args Arguments on entry, results on return
+   * @return HAL_OK if the handler ran, HAL_ERR_NOTSUP if id is unassigned
+   */
+  int hal_sys_call(uint8_t id, hal_sys_cell_t* args);
+
+  /**
+   * @brief Run a sequence of SYS operations in one call
+   *
+   * Runs ops in order, e.g. "write pin 3 high, delay 5us, write pin 3
+   * low, read pin 4" for a bit-banged protocol, appending each
+   * operation's pushed cells to results in push order. Ops are checked
+   * before any runs, so an unassigned id runs nothing. An operation that
+   * fails reports its error in results and the sequence continues.
+   *
+   * Where the platform's critical section is a lock that may be held
+   * across blocking calls (POSIX), the sequence runs inside
+   * hal_critical_enter()/hal_critical_exit(), so the operations between
+   * two delays are atomic with respect to other critical sections.
+   * DELAY_MS/DELAY_US release the section for their duration (unless the
+   * caller already holds it). Elsewhere each operation does its own
+   * locking.
+   *
+   * @param ops     Operations
+   * @param n       Number of operations
+   * @param results Receives the pushed cells; room for the sum of
+   *                hal_sys_table[ops[i].sys].out
+   * @return Number of cells written to results on success,
+   *         HAL_ERR_PARAM if ops or results is null,
+   *         HAL_ERR_NOTSUP if an op has an unassigned id
+   */
+  int hal_submit_batch(const hal_op_t* ops, size_t n, hal_sys_cell_t* results);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // V4_HAL_SYS_H
@@ -28,6 +28,13 @@ extern "C"
    */
   typedef void* hal_handle_t;
 
+  /**
+   * @brief Opaque simulated-board context
+   *
+   * See hal_context_create(). NULL stands for the default context.
+   */
+  typedef struct hal_context hal_context_t;
+
   /* ------------------------------------------------------------------------- */
   /* GPIO types                                                                */
   /* ------------------------------------------------------------------------- */
@@ -75,17 +82,178 @@ extern "C"
   /* UART types                                                                */
   /* ------------------------------------------------------------------------- */
 
+  /**
+   * @brief Timeout value that waits indefinitely
+   */
+#define HAL_UART_WAIT_FOREVER UINT32_MAX
+
+  /**
+   * @brief I/O vector segment for scatter-gather transfers
+   *
+   * Same layout as POSIX struct iovec.
+   */
+  typedef struct
+  {
+    void* base; /**< Segment start */
+    size_t len; /**< Segment length in bytes */
+  } hal_iovec_t;
+
+  /**
+   * @brief UART host backend (simulation platforms)
+   *
+   * Selects what a simulated UART port is connected to. Hardware
+   * platforms only accept HAL_UART_BACKEND_DEFAULT.
+   */
+  typedef enum
+  {
+    HAL_UART_BACKEND_DEFAULT = 0, /**< Platform default (POSIX: stdio on port 0) */
+    HAL_UART_BACKEND_NONE,        /**< Unconnected: TX discarded, RX empty */
+    HAL_UART_BACKEND_STDIO,       /**< TX to stdout, RX from stdin (first port open) */
+    HAL_UART_BACKEND_PTY,         /**< Pseudo-terminal; path links to the slave */
+    HAL_UART_BACKEND_SOCKET,      /**< Unix domain socket listening on path */
+    HAL_UART_BACKEND_FIFO,        /**< Named pipes path.rx (RX) and path.tx (TX) */
+  } hal_uart_backend_t;
+
+  /**
+   * @brief UART transmit buffering policy
+   *
+   * Platforms that coalesce writes flush the buffer when it fills, when
+   * hal_uart_flush() is called, or when tx_flush_us elapses after the
+   * first buffered byte, whichever comes first.
+   */
+  typedef enum
+  {
+    HAL_UART_TX_DEFAULT = 0, /**< Platform default (POSIX: line buffered) */
+    HAL_UART_TX_UNBUFFERED,  /**< Every write goes straight to the device */
+    HAL_UART_TX_LINE,        /**< Also flush when a newline is written */
+    HAL_UART_TX_BLOCK,       /**< Flush only on size, deadline or hal_uart_flush() */
+  } hal_uart_tx_mode_t;
+
   /**
    * @brief UART configuration structure
+   *
+   * Fields after parity may be left zero-initialized for defaults.
    */
   typedef struct
   {
-    int baudrate;  /**< Baud rate (e.g., 9600, 115200) */
-    int data_bits; /**< Data bits: 5, 6, 7, or 8 */
-    int stop_bits; /**< Stop bits: 1 or 2 */
-    int parity;    /**< Parity: 0=none, 1=odd, 2=even */
+    int baudrate;               /**< Baud rate (e.g., 9600, 115200) */
+    int data_bits;              /**< Data bits: 5, 6, 7, or 8 */
+    int stop_bits;              /**< Stop bits: 1 or 2 */
+    int parity;                 /**< Parity: 0=none, 1=odd, 2=even */
+    hal_uart_backend_t backend; /**< Host backend (simulation platforms) */
+    const char* path;           /**< Backend filesystem path (PTY/SOCKET/FIFO) */
+    hal_uart_tx_mode_t tx_mode; /**< Transmit buffering policy */
+    uint32_t tx_flush_us;       /**< Max latency of buffered TX data (0 = default) */
   } hal_uart_config_t;
 
+  /**
+   * @brief Console output mode
+   */
+  typedef enum
+  {
+    HAL_CONSOLE_DIRECT = 0, /**< Every write goes straight to the device */
+    HAL_CONSOLE_BUFFERED,   /**< Writes are copied to a ring drained in the background */
+  } hal_console_mode_t;
+
+  /**
+   * @brief Software timer callback
+   *
+   * Runs in the platform's timer service context (POSIX: a dedicated
+   * thread, ESP32: the esp_timer task). May start, stop or delete timers,
+   * including its own.
+   *
+   * @param timer     Timer that expired
+   * @param user_data User-provided context pointer
+   */
+  typedef void (*hal_timer_callback_t)(hal_handle_t timer, void* user_data);
+
+  /**
+   * @brief Clock source behind hal_millis() / hal_micros()
+   *
+   * Every platform supports HAL_CLOCK_MONOTONIC; the others are optional.
+   */
+  typedef enum
+  {
+    HAL_CLOCK_MONOTONIC = 0, /**< Full-precision monotonic clock */
+    HAL_CLOCK_COARSE,        /**< Tick-granular hal_millis(), precise hal_micros() */
+    HAL_CLOCK_RAW,           /**< Hardware rate, no NTP adjustment */
+    HAL_CLOCK_TSC,           /**< Calibrated CPU cycle counter */
+    HAL_CLOCK_VIRTUAL,       /**< Simulated time advanced by delays (host only) */
+  } hal_clock_source_t;
+
+  /**
+   * @brief Critical section contention counters
+   */
+  typedef struct
+  {
+    uint64_t contended;     /**< Enters that found the section held by another thread */
+    uint64_t spin_acquired; /**< Contended enters that succeeded while spinning */
+    uint64_t sleeps;        /**< Times a waiter blocked in the kernel */
+    uint32_t max_depth;     /**< Deepest nesting seen */
+  } hal_critical_stats_t;
+
+  /**
+   * @brief Lock object for hal_lock_acquire() / hal_lock_release()
+   *
+   * Treat as opaque and initialize with hal_lock_init() before use. Each
+   * lock is independent, so unrelated subsystems do not contend.
+   */
+  typedef struct
+  {
+    uint32_t impl[4];   /**< Platform lock state */
+    uint32_t contended; /**< Acquisitions that had to wait (0 if not counted) */
+    const char* name;   /**< Name given to hal_lock_init() */
+  } hal_lock_t;
+
+  /**
+   * @brief Queue discipline for hal_queue_init()
+   */
+  typedef enum
+  {
+    HAL_QUEUE_SPSC = 0, /**< One producer, one consumer */
+    HAL_QUEUE_MPSC,     /**< Any number of producers, one consumer */
+  } hal_queue_mode_t;
+
+  /**
+   * @brief Bounded lock-free queue of fixed-size elements
+   *
+   * Treat as opaque and initialize with hal_queue_init(). The producer
+   * and consumer indices are 64 bytes apart so they never share a cache
+   * line.
+   */
+  typedef struct
+  {
+    uint32_t head; /**< Producer index */
+    uint8_t pad_head[60];
+    uint32_t tail; /**< Consumer index */
+    uint8_t pad_tail[60];
+    uint8_t* slots;         /**< Caller-provided storage */
+    uint32_t slot_size;     /**< Bytes per slot (sequence number + element) */
+    uint32_t elem_size;     /**< Bytes per element */
+    uint32_t mask;          /**< Capacity - 1 */
+    hal_queue_mode_t mode;  /**< SPSC or MPSC */
+  } hal_queue_t;
+
+/**
+ * @brief Bytes of storage per queue slot for elements of elem_size bytes
+ */
+#define HAL_QUEUE_SLOT_SIZE(elem_size) (4u + (((elem_size) + 3u) & ~3u))
+
+/**
+ * @brief Bytes of storage hal_queue_init() needs for capacity elements
+ */
+#define HAL_QUEUE_STORAGE_SIZE(elem_size, capacity) \
+  ((capacity) * HAL_QUEUE_SLOT_SIZE(elem_size))
+
+  /**
+   * @brief Contended enters attributed to one call site
+   */
+  typedef struct
+  {
+    const void* site;   /**< Return address of the enter call (NULL = others) */
+    uint64_t contended; /**< Contended enters from this site */
+  } hal_critical_site_t;
+
 #ifdef __cplusplus
 }
 #endif
@@ -9,13 +9,27 @@
 
 // ESP-IDF includes
 #ifdef HAL_PLATFORM_ESP32
+#include <atomic>
 #include <cstdio>
+#include <cstring>
 
+#include "../../src/internal/ring_buffer.hpp"
 #include "driver/gpio.h"
 #include "driver/uart.h"
 #include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
 #include "freertos/task.h"
+#include "soc/gpio_reg.h"
+#include "soc/soc.h"
+#endif
+
+#ifndef V4_HAL_ESP32_CONSOLE_RING_SIZE
+#define V4_HAL_ESP32_CONSOLE_RING_SIZE 4096
+#endif
+
+#ifndef V4_HAL_ESP32_CONSOLE_FLUSH_MS
+#define V4_HAL_ESP32_CONSOLE_FLUSH_MS 10
 #endif
 
 namespace v4
@@ -29,13 +43,11 @@ namespace hal
 /* GPIO Implementation                                                       */
 /* ========================================================================= */
 
-int Esp32Platform::gpio_mode_impl(int pin, hal_gpio_mode_t mode)
+// Apply one mode to every pin in mask with a single gpio_config() call
+static int gpio_configure(uint64_t mask, hal_gpio_mode_t mode)
 {
-  if (pin < 0 || pin >= GPIO_NUM_MAX)
-    return HAL_ERR_PARAM;
-
   gpio_config_t io_conf = {};
-  io_conf.pin_bit_mask = (1ULL << pin);
+  io_conf.pin_bit_mask = mask;
   io_conf.intr_type = GPIO_INTR_DISABLE;
 
   switch (mode)
@@ -80,6 +92,14 @@ int Esp32Platform::gpio_mode_impl(int pin, hal_gpio_mode_t mode)
   return HAL_OK;
 }
 
+int Esp32Platform::gpio_mode_impl(int pin, hal_gpio_mode_t mode)
+{
+  if (pin < 0 || pin >= GPIO_NUM_MAX)
+    return HAL_ERR_PARAM;
+
+  return gpio_configure(1ULL << pin, mode);
+}
+
 int Esp32Platform::gpio_write_impl(int pin, hal_gpio_value_t value)
 {
   if (pin < 0 || pin >= GPIO_NUM_MAX)
@@ -104,6 +124,69 @@ int Esp32Platform::gpio_read_impl(int pin, hal_gpio_value_t* value)
   return HAL_OK;
 }
 
+int Esp32Platform::gpio_toggle_impl(int pin)
+{
+  if (pin < 0 || pin >= GPIO_NUM_MAX)
+    return HAL_ERR_PARAM;
+
+  // Use the output latch: gpio_get_level() reads the input path, which is
+  // disabled on pins configured as plain outputs
+  uint32_t bit = 1u << (pin % 32);
+#if SOC_GPIO_PIN_COUNT > 32
+  if (pin >= 32)
+  {
+    REG_WRITE((REG_READ(GPIO_OUT1_REG) & bit) ? GPIO_OUT1_W1TC_REG : GPIO_OUT1_W1TS_REG,
+              bit);
+    return HAL_OK;
+  }
+#endif
+  REG_WRITE((REG_READ(GPIO_OUT_REG) & bit) ? GPIO_OUT_W1TC_REG : GPIO_OUT_W1TS_REG, bit);
+  return HAL_OK;
+}
+
+// All ESP32 pins fit in bank 0, the only bank GpioBase lets through
+int Esp32Platform::gpio_write_bank_impl(int, uint64_t set_mask, uint64_t clear_mask)
+{
+  if ((set_mask | clear_mask) & ~static_cast<uint64_t>(SOC_GPIO_VALID_OUTPUT_GPIO_MASK))
+    return HAL_ERR_PARAM;
+
+  // Write-1-to-set/clear registers update the whole bank in one store.
+  // Register addresses rather than the GPIO struct: its field types differ
+  // between the Xtensa and RISC-V chips
+  if (set_mask & 0xFFFFFFFFULL)
+    REG_WRITE(GPIO_OUT_W1TS_REG, static_cast<uint32_t>(set_mask));
+  if (clear_mask & 0xFFFFFFFFULL)
+    REG_WRITE(GPIO_OUT_W1TC_REG, static_cast<uint32_t>(clear_mask));
+#if SOC_GPIO_PIN_COUNT > 32
+  if (set_mask >> 32)
+    REG_WRITE(GPIO_OUT1_W1TS_REG, static_cast<uint32_t>(set_mask >> 32));
+  if (clear_mask >> 32)
+    REG_WRITE(GPIO_OUT1_W1TC_REG, static_cast<uint32_t>(clear_mask >> 32));
+#endif
+
+  return HAL_OK;
+}
+
+int Esp32Platform::gpio_read_bank_impl(int, uint64_t* value)
+{
+  uint64_t levels = REG_READ(GPIO_IN_REG);
+#if SOC_GPIO_PIN_COUNT > 32
+  levels |= static_cast<uint64_t>(REG_READ(GPIO_IN1_REG)) << 32;
+#endif
+  *value = levels;
+  return HAL_OK;
+}
+
+int Esp32Platform::gpio_mode_bank_impl(int, uint64_t mask, hal_gpio_mode_t mode)
+{
+  if (mask & ~static_cast<uint64_t>(SOC_GPIO_VALID_GPIO_MASK))
+    return HAL_ERR_PARAM;
+  if (!mask)
+    return HAL_OK;
+
+  return gpio_configure(mask, mode);
+}
+
 /* ========================================================================= */
 /* UART Implementation                                                       */
 /* ========================================================================= */
@@ -115,6 +198,41 @@ int Esp32Platform::gpio_read_impl(int pin, hal_gpio_value_t* value)
 // Track which UARTs have been initialized
 static bool uart_init_flags[3] = {false, false, false};
 
+// The driver keeps its RX ring private and only copies out through
+// uart_read_bytes(), so rx_peek stages data in a per-port window. Bytes in
+// the window are always older than bytes still in the driver.
+#define UART_RX_PEEK_SIZE 256
+
+struct UartRxWindow
+{
+  uint8_t buf[UART_RX_PEEK_SIZE];
+  size_t head; /**< Offset of the oldest staged byte */
+  size_t len;  /**< Number of staged bytes */
+};
+
+static UartRxWindow uart_rx_windows[3];
+
+// Non-blocking read that drains the peek window before the driver
+static int uart_rx_take(int port, uint8_t* buf, size_t len)
+{
+  UartRxWindow& w = uart_rx_windows[port];
+  size_t staged = (len < w.len) ? len : w.len;
+  if (staged != 0)
+  {
+    std::memcpy(buf, &w.buf[w.head], staged);
+    w.head += staged;
+    w.len -= staged;
+  }
+  if (staged == len)
+    return static_cast<int>(staged);
+
+  int bytes_read =
+      uart_read_bytes(static_cast<uart_port_t>(port), buf + staged, len - staged, 0);
+  if (bytes_read < 0)
+    return (staged != 0) ? static_cast<int>(staged) : HAL_ERR_IO;
+  return static_cast<int>(staged) + bytes_read;
+}
+
 hal_handle_t Esp32Platform::uart_open_impl(int port, const hal_uart_config_t* config)
 {
   if (port < 0 || port >= max_uart_ports())
@@ -122,6 +240,10 @@ hal_handle_t Esp32Platform::uart_open_impl(int port, const hal_uart_config_t* co
   if (!config)
     return nullptr;
 
+  // Host backends (PTY, socket, FIFO) only exist on simulation platforms
+  if (config->backend != HAL_UART_BACKEND_DEFAULT)
+    return nullptr;
+
   // Skip re-initialization
   if (uart_init_flags[port])
   {
@@ -153,6 +275,8 @@ hal_handle_t Esp32Platform::uart_open_impl(int port, const hal_uart_config_t* co
     return nullptr;
 
   uart_init_flags[port] = true;
+  uart_rx_windows[port].head = 0;
+  uart_rx_windows[port].len = 0;
 
   // Return port number as handle (cast to pointer)
   return reinterpret_cast<hal_handle_t>(static_cast<uintptr_t>(port + 1));
@@ -197,9 +321,10 @@ int Esp32Platform::uart_write_impl(hal_handle_t handle, const uint8_t* buf, size
   return (written >= 0) ? written : HAL_ERR_IO;
 }
 
-int Esp32Platform::uart_read_impl(hal_handle_t handle, uint8_t* buf, size_t len)
+int Esp32Platform::uart_writev_impl(hal_handle_t handle, const hal_iovec_t* iov,
+                                    size_t iovcnt)
 {
-  if (!handle || !buf)
+  if (!handle)
     return HAL_ERR_PARAM;
 
   int port = static_cast<int>(reinterpret_cast<uintptr_t>(handle)) - 1;
@@ -211,9 +336,162 @@ int Esp32Platform::uart_read_impl(hal_handle_t handle, uint8_t* buf, size_t len)
 
   uart_port_t uart_num = static_cast<uart_port_t>(port);
 
+  // Chain segments straight into the driver; no staging copy
+  int total = 0;
+  for (size_t i = 0; i < iovcnt; i++)
+  {
+    int written = uart_write_bytes(uart_num, iov[i].base, iov[i].len);
+    if (written < 0)
+      return (total > 0) ? total : HAL_ERR_IO;
+    total += written;
+  }
+  return total;
+}
+
+int Esp32Platform::uart_flush_impl(hal_handle_t handle)
+{
+  if (!handle)
+    return HAL_ERR_PARAM;
+
+  int port = static_cast<int>(reinterpret_cast<uintptr_t>(handle)) - 1;
+  if (port < 0 || port >= max_uart_ports())
+    return HAL_ERR_PARAM;
+
+  if (!uart_init_flags[port])
+    return HAL_ERR_NODEV;
+
+  uart_port_t uart_num = static_cast<uart_port_t>(port);
+
+  // Wait for the hardware FIFO to drain
+  if (uart_wait_tx_done(uart_num, portMAX_DELAY) != ESP_OK)
+    return HAL_ERR_IO;
+
+  return HAL_OK;
+}
+
+int Esp32Platform::uart_read_impl(hal_handle_t handle, uint8_t* buf, size_t len)
+{
+  if (!handle || !buf)
+    return HAL_ERR_PARAM;
+
+  int port = static_cast<int>(reinterpret_cast<uintptr_t>(handle)) - 1;
+  if (port < 0 || port >= max_uart_ports())
+    return HAL_ERR_PARAM;
+
+  if (!uart_init_flags[port])
+    return HAL_ERR_NODEV;
+
   // Non-blocking read with 0 timeout
-  int bytes_read = uart_read_bytes(uart_num, buf, len, 0);
-  return (bytes_read >= 0) ? bytes_read : HAL_ERR_IO;
+  return uart_rx_take(port, buf, len);
+}
+
+int Esp32Platform::uart_read_timeout_impl(hal_handle_t handle, uint8_t* buf, size_t len,
+                                          uint32_t timeout_us)
+{
+  if (!handle || !buf)
+    return HAL_ERR_PARAM;
+
+  int port = static_cast<int>(reinterpret_cast<uintptr_t>(handle)) - 1;
+  if (port < 0 || port >= max_uart_ports())
+    return HAL_ERR_PARAM;
+
+  if (!uart_init_flags[port])
+    return HAL_ERR_NODEV;
+
+  int staged = uart_rx_take(port, buf, len);
+  if (staged < 0 || static_cast<size_t>(staged) == len || timeout_us == 0)
+    return staged;
+
+  // The driver blocks the task on its RX queue; round up to whole ticks
+  TickType_t ticks = portMAX_DELAY;
+  if (timeout_us != HAL_UART_WAIT_FOREVER)
+  {
+    uint32_t ms = timeout_us / 1000 + (timeout_us % 1000 != 0);
+    ticks = (ms + portTICK_PERIOD_MS - 1) / portTICK_PERIOD_MS;
+  }
+
+  int bytes_read = uart_read_bytes(static_cast<uart_port_t>(port), buf + staged,
+                                   len - static_cast<size_t>(staged), ticks);
+  if (bytes_read < 0)
+    return (staged > 0) ? staged : HAL_ERR_IO;
+  return staged + bytes_read;
+}
+
+int Esp32Platform::uart_readv_impl(hal_handle_t handle, const hal_iovec_t* iov,
+                                   size_t iovcnt)
+{
+  if (!handle)
+    return HAL_ERR_PARAM;
+
+  int port = static_cast<int>(reinterpret_cast<uintptr_t>(handle)) - 1;
+  if (port < 0 || port >= max_uart_ports())
+    return HAL_ERR_PARAM;
+
+  if (!uart_init_flags[port])
+    return HAL_ERR_NODEV;
+
+  // Non-blocking reads into each segment until one comes up short
+  int total = 0;
+  for (size_t i = 0; i < iovcnt; i++)
+  {
+    int bytes_read = uart_rx_take(port, static_cast<uint8_t*>(iov[i].base), iov[i].len);
+    if (bytes_read < 0)
+      return (total > 0) ? total : HAL_ERR_IO;
+    total += bytes_read;
+    if (static_cast<size_t>(bytes_read) < iov[i].len)
+      break;
+  }
+  return total;
+}
+
+int Esp32Platform::uart_rx_peek_impl(hal_handle_t handle, const uint8_t** data,
+                                     size_t* len)
+{
+  if (!handle)
+    return HAL_ERR_PARAM;
+
+  int port = static_cast<int>(reinterpret_cast<uintptr_t>(handle)) - 1;
+  if (port < 0 || port >= max_uart_ports())
+    return HAL_ERR_PARAM;
+
+  if (!uart_init_flags[port])
+    return HAL_ERR_NODEV;
+
+  // Refill the window only once the caller has consumed all of it
+  UartRxWindow& w = uart_rx_windows[port];
+  if (w.len == 0)
+  {
+    int bytes_read =
+        uart_read_bytes(static_cast<uart_port_t>(port), w.buf, sizeof(w.buf), 0);
+    if (bytes_read < 0)
+      return HAL_ERR_IO;
+    w.head = 0;
+    w.len = static_cast<size_t>(bytes_read);
+  }
+
+  *data = &w.buf[w.head];
+  *len = w.len;
+  return HAL_OK;
+}
+
+int Esp32Platform::uart_rx_consume_impl(hal_handle_t handle, size_t len)
+{
+  if (!handle)
+    return HAL_ERR_PARAM;
+
+  int port = static_cast<int>(reinterpret_cast<uintptr_t>(handle)) - 1;
+  if (port < 0 || port >= max_uart_ports())
+    return HAL_ERR_PARAM;
+
+  if (!uart_init_flags[port])
+    return HAL_ERR_NODEV;
+
+  UartRxWindow& w = uart_rx_windows[port];
+  if (len > w.len)
+    return HAL_ERR_PARAM;
+  w.head += len;
+  w.len -= len;
+  return HAL_OK;
 }
 
 int Esp32Platform::uart_available_impl(hal_handle_t handle)
@@ -234,7 +512,7 @@ int Esp32Platform::uart_available_impl(hal_handle_t handle)
   if (uart_get_buffered_data_len(uart_num, &available) != ESP_OK)
     return HAL_ERR_IO;
 
-  return static_cast<int>(available);
+  return static_cast<int>(available + uart_rx_windows[port].len);
 }
 
 /* ========================================================================= */
@@ -279,25 +557,215 @@ void Esp32Platform::delay_us_impl(uint32_t us)
   }
 }
 
+void Esp32Platform::delay_until_us_impl(uint64_t deadline_us)
+{
+  int64_t deadline = static_cast<int64_t>(deadline_us);
+  int64_t now = esp_timer_get_time();
+  if (deadline <= now)
+    return;
+
+  // vTaskDelay(n) returns on the n-th tick boundary from now, at most n
+  // ticks away, so it never oversleeps; sleep until less than one tick
+  // is left and spin only that final partial tick
+  constexpr int64_t tick_us = 1000000 / configTICK_RATE_HZ;
+  for (int64_t left = deadline - now; left >= tick_us;
+       left = deadline - esp_timer_get_time())
+    vTaskDelay(static_cast<TickType_t>(left / tick_us));
+
+  while (esp_timer_get_time() < deadline)
+  {
+    // Busy wait
+  }
+}
+
+/* ========================================================================= */
+/* Software Timer Driver                                                     */
+/* ========================================================================= */
+
+// One one-shot esp_timer runs the software timer service from the
+// esp_timer task and re-arms itself for the deadline the service returns
+static esp_timer_handle_t sw_timer_driver = nullptr;
+static uint64_t (*sw_timer_service)() = nullptr;
+
+static void sw_timer_driver_cb(void*)
+{
+  uint64_t deadline = sw_timer_service();
+  if (deadline == UINT64_MAX)
+    return;
+
+  uint64_t now = static_cast<uint64_t>(esp_timer_get_time());
+  // Fails with ESP_ERR_INVALID_STATE if a kick re-armed the timer in the
+  // meantime; that pending run computes the deadline again
+  esp_timer_start_once(sw_timer_driver, deadline > now ? deadline - now : 0);
+}
+
+int Esp32Platform::timer_service_start_impl(uint64_t (*service)())
+{
+  sw_timer_service = service;
+
+  esp_timer_create_args_t args = {};
+  args.callback = sw_timer_driver_cb;
+  args.name = "hal_timer";
+  return (esp_timer_create(&args, &sw_timer_driver) == ESP_OK) ? HAL_OK : HAL_ERR_NOMEM;
+}
+
+void Esp32Platform::timer_service_kick_impl()
+{
+  esp_timer_stop(sw_timer_driver);  // ESP_ERR_INVALID_STATE when idle is fine
+  esp_timer_start_once(sw_timer_driver, 0);
+}
+
 /* ========================================================================= */
 /* Console I/O Implementation                                                */
 /* ========================================================================= */
 
+/**
+ * Buffered console (HAL_CONSOLE_BUFFERED). Writers serialize on a FreeRTOS
+ * mutex (they may block for space, so not on a spinlock) and memcpy into
+ * an SPSC ring that a low-priority task drains to UART0. The task polls
+ * every V4_HAL_ESP32_CONSOLE_FLUSH_MS while output keeps arriving; after
+ * an empty poll it sets `idle` and blocks on its task notification, which
+ * the next writer gives. Buffered writes must not come from an ISR.
+ */
+struct ConsoleBuffer
+{
+  SpscByteRing<V4_HAL_ESP32_CONSOLE_RING_SIZE> ring;
+  std::atomic<bool> buffered{false};
+  std::atomic<bool> idle{false};  // Task blocked until notified
+  SemaphoreHandle_t writer = nullptr;
+  TaskHandle_t task = nullptr;
+};
+
+static ConsoleBuffer console;
+
+static void console_flusher_task(void*)
+{
+  TickType_t poll = pdMS_TO_TICKS(V4_HAL_ESP32_CONSOLE_FLUSH_MS);
+  if (poll == 0)
+    poll = 1;
+
+  bool active = true;  // Output drained since the last poll
+  for (;;)
+  {
+    const uint8_t* p;
+    while (size_t n = console.ring.peek(&p))
+    {
+      int written = uart_write_bytes(UART_NUM_0, p, n);
+      // Bytes the driver refuses are dropped rather than stalling writers
+      console.ring.consume(written > 0 ? static_cast<size_t>(written) : n);
+      active = true;
+    }
+
+    if (active)
+    {
+      ulTaskNotifyTake(pdTRUE, poll);
+      active = false;
+      continue;
+    }
+
+    // Pairs with the fence in console_push(); a notification given before
+    // the task blocks is latched, so none is lost
+    console.idle.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (console.ring.size() == 0)
+      ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    console.idle.store(false, std::memory_order_relaxed);
+  }
+}
+
+// Block until the task has handed every byte in the ring to the driver
+static void console_wait_drained()
+{
+  while (console.ring.size())
+  {
+    xTaskNotifyGive(console.task);
+    vTaskDelay(1);
+  }
+}
+
+// Called with the writer mutex held
+static void console_push(const uint8_t* buf, size_t len)
+{
+  size_t done = console.ring.push(buf, len);
+  while (done < len)
+  {
+    console_wait_drained();
+    done += console.ring.push(buf + done, len - done);
+  }
+
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (console.idle.load(std::memory_order_relaxed))
+    xTaskNotifyGive(console.task);
+}
+
 int Esp32Platform::console_write_impl(const uint8_t* buf, size_t len)
 {
   if (!buf)
     return HAL_ERR_PARAM;
 
+  if (console.buffered.load(std::memory_order_acquire))
+  {
+    xSemaphoreTake(console.writer, portMAX_DELAY);
+    // Re-check under the mutex: switching to direct mode holds it
+    bool buffered = console.buffered.load(std::memory_order_relaxed);
+    if (buffered)
+      console_push(buf, len);
+    xSemaphoreGive(console.writer);
+    if (buffered)
+      return static_cast<int>(len);
+  }
+
   // Use UART0 for console output
   int written = uart_write_bytes(UART_NUM_0, buf, len);
   return (written >= 0) ? written : HAL_ERR_IO;
 }
 
+int Esp32Platform::console_set_mode_impl(hal_console_mode_t mode)
+{
+  if (!console.writer)
+  {
+    // First call; create the mutex and task before any buffered write
+    console.writer = xSemaphoreCreateMutex();
+    if (!console.writer)
+      return HAL_ERR_NOMEM;
+  }
+
+  int ret = HAL_OK;
+  xSemaphoreTake(console.writer, portMAX_DELAY);
+  if (mode == HAL_CONSOLE_BUFFERED)
+  {
+    if (!console.task && xTaskCreate(console_flusher_task, "hal_console", 2048, nullptr,
+                                     tskIDLE_PRIORITY + 1, &console.task) != pdPASS)
+    {
+      console.task = nullptr;
+      ret = HAL_ERR_NOMEM;
+    }
+    if (ret == HAL_OK)
+      console.buffered.store(true, std::memory_order_release);
+  }
+  else if (console.buffered.load(std::memory_order_relaxed))
+  {
+    console_wait_drained();
+    console.buffered.store(false, std::memory_order_release);
+  }
+  xSemaphoreGive(console.writer);
+  return ret;
+}
+
+int Esp32Platform::console_flush_impl()
+{
+  if (console.buffered.load(std::memory_order_acquire))
+    console_wait_drained();
+  return HAL_OK;
+}
+
 int Esp32Platform::console_read_impl(uint8_t* buf, size_t len)
 {
   if (!buf)
     return HAL_ERR_PARAM;
 
+  console_flush_impl();
+
   // Blocking read from UART0
   int bytes_read = uart_read_bytes(UART_NUM_0, buf, len, portMAX_DELAY);
   return (bytes_read >= 0) ? bytes_read : HAL_ERR_IO;
@@ -323,6 +791,31 @@ void Esp32Platform::critical_exit_impl()
   portEXIT_CRITICAL(&critical_spinlock);
 }
 
+// Each hal_lock_t holds its own spinlock, so locks on different cores
+// only spin against holders of the same lock
+static_assert(sizeof(portMUX_TYPE) <= sizeof(static_cast<hal_lock_t*>(nullptr)->impl),
+              "hal_lock_t too small for portMUX_TYPE");
+
+static portMUX_TYPE* mux_of(hal_lock_t* lock)
+{
+  return reinterpret_cast<portMUX_TYPE*>(lock->impl);
+}
+
+void Esp32Platform::lock_init_impl(hal_lock_t* lock)
+{
+  portMUX_INITIALIZE(mux_of(lock));
+}
+
+void Esp32Platform::lock_acquire_impl(hal_lock_t* lock)
+{
+  portENTER_CRITICAL(mux_of(lock));
+}
+
+void Esp32Platform::lock_release_impl(hal_lock_t* lock)
+{
+  portEXIT_CRITICAL(mux_of(lock));
+}
+
 #else  // !HAL_PLATFORM_ESP32
 
 /* Stub implementations for non-ESP32 builds */
@@ -339,6 +832,22 @@ int Esp32Platform::gpio_read_impl(int, hal_gpio_value_t*)
 {
   return HAL_ERR_NOTSUP;
 }
+int Esp32Platform::gpio_toggle_impl(int)
+{
+  return HAL_ERR_NOTSUP;
+}
+int Esp32Platform::gpio_write_bank_impl(int, uint64_t, uint64_t)
+{
+  return HAL_ERR_NOTSUP;
+}
+int Esp32Platform::gpio_read_bank_impl(int, uint64_t*)
+{
+  return HAL_ERR_NOTSUP;
+}
+int Esp32Platform::gpio_mode_bank_impl(int, uint64_t, hal_gpio_mode_t)
+{
+  return HAL_ERR_NOTSUP;
+}
 hal_handle_t Esp32Platform::uart_open_impl(int, const hal_uart_config_t*)
 {
   return nullptr;
@@ -351,10 +860,34 @@ int Esp32Platform::uart_write_impl(hal_handle_t, const uint8_t*, size_t)
 {
   return HAL_ERR_NOTSUP;
 }
+int Esp32Platform::uart_writev_impl(hal_handle_t, const hal_iovec_t*, size_t)
+{
+  return HAL_ERR_NOTSUP;
+}
+int Esp32Platform::uart_flush_impl(hal_handle_t)
+{
+  return HAL_ERR_NOTSUP;
+}
 int Esp32Platform::uart_read_impl(hal_handle_t, uint8_t*, size_t)
 {
   return HAL_ERR_NOTSUP;
 }
+int Esp32Platform::uart_read_timeout_impl(hal_handle_t, uint8_t*, size_t, uint32_t)
+{
+  return HAL_ERR_NOTSUP;
+}
+int Esp32Platform::uart_readv_impl(hal_handle_t, const hal_iovec_t*, size_t)
+{
+  return HAL_ERR_NOTSUP;
+}
+int Esp32Platform::uart_rx_peek_impl(hal_handle_t, const uint8_t**, size_t*)
+{
+  return HAL_ERR_NOTSUP;
+}
+int Esp32Platform::uart_rx_consume_impl(hal_handle_t, size_t)
+{
+  return HAL_ERR_NOTSUP;
+}
 int Esp32Platform::uart_available_impl(hal_handle_t)
 {
   return HAL_ERR_NOTSUP;
@@ -369,6 +902,12 @@ uint64_t Esp32Platform::micros_impl()
 }
 void Esp32Platform::delay_ms_impl(uint32_t) {}
 void Esp32Platform::delay_us_impl(uint32_t) {}
+void Esp32Platform::delay_until_us_impl(uint64_t) {}
+int Esp32Platform::timer_service_start_impl(uint64_t (*)())
+{
+  return HAL_ERR_NOTSUP;
+}
+void Esp32Platform::timer_service_kick_impl() {}
 int Esp32Platform::console_write_impl(const uint8_t*, size_t)
 {
   return HAL_ERR_NOTSUP;
@@ -377,8 +916,19 @@ int Esp32Platform::console_read_impl(uint8_t*, size_t)
 {
   return HAL_ERR_NOTSUP;
 }
+int Esp32Platform::console_set_mode_impl(hal_console_mode_t mode)
+{
+  return mode == HAL_CONSOLE_DIRECT ? HAL_OK : HAL_ERR_NOTSUP;
+}
+int Esp32Platform::console_flush_impl()
+{
+  return HAL_OK;
+}
 void Esp32Platform::critical_enter_impl() {}
 void Esp32Platform::critical_exit_impl() {}
+void Esp32Platform::lock_init_impl(hal_lock_t*) {}
+void Esp32Platform::lock_acquire_impl(hal_lock_t*) {}
+void Esp32Platform::lock_release_impl(hal_lock_t*) {}
 
 #endif  // HAL_PLATFORM_ESP32
 
@@ -60,6 +60,10 @@ struct Esp32Platform
   static int gpio_mode_impl(int pin, hal_gpio_mode_t mode);
   static int gpio_write_impl(int pin, hal_gpio_value_t value);
   static int gpio_read_impl(int pin, hal_gpio_value_t* value);
+  static int gpio_toggle_impl(int pin);
+  static int gpio_write_bank_impl(int bank, uint64_t set_mask, uint64_t clear_mask);
+  static int gpio_read_bank_impl(int bank, uint64_t* value);
+  static int gpio_mode_bank_impl(int bank, uint64_t mask, hal_gpio_mode_t mode);
 
   /* ======================================================================= */
   /* UART Implementation                                                     */
@@ -68,7 +72,14 @@ struct Esp32Platform
   static hal_handle_t uart_open_impl(int port, const hal_uart_config_t* config);
   static int uart_close_impl(hal_handle_t handle);
   static int uart_write_impl(hal_handle_t handle, const uint8_t* buf, size_t len);
+  static int uart_writev_impl(hal_handle_t handle, const hal_iovec_t* iov, size_t iovcnt);
+  static int uart_flush_impl(hal_handle_t handle);
   static int uart_read_impl(hal_handle_t handle, uint8_t* buf, size_t len);
+  static int uart_read_timeout_impl(hal_handle_t handle, uint8_t* buf, size_t len,
+                                    uint32_t timeout_us);
+  static int uart_readv_impl(hal_handle_t handle, const hal_iovec_t* iov, size_t iovcnt);
+  static int uart_rx_peek_impl(hal_handle_t handle, const uint8_t** data, size_t* len);
+  static int uart_rx_consume_impl(hal_handle_t handle, size_t len);
   static int uart_available_impl(hal_handle_t handle);
 
   /* ======================================================================= */
@@ -79,6 +90,9 @@ struct Esp32Platform
   static uint64_t micros_impl();
   static void delay_ms_impl(uint32_t ms);
   static void delay_us_impl(uint32_t us);
+  static void delay_until_us_impl(uint64_t deadline_us);
+  static int timer_service_start_impl(uint64_t (*service)());
+  static void timer_service_kick_impl();
 
   /* ======================================================================= */
   /* Console I/O Implementation                                              */
@@ -86,6 +100,8 @@ struct Esp32Platform
 
   static int console_write_impl(const uint8_t* buf, size_t len);
   static int console_read_impl(uint8_t* buf, size_t len);
+  static int console_set_mode_impl(hal_console_mode_t mode);
+  static int console_flush_impl();
 
   /* ======================================================================= */
   /* Interrupt Control Implementation                                        */
@@ -93,6 +109,9 @@ struct Esp32Platform
 
   static void critical_enter_impl();
   static void critical_exit_impl();
+  static void lock_init_impl(hal_lock_t* lock);
+  static void lock_acquire_impl(hal_lock_t* lock);
+  static void lock_release_impl(hal_lock_t* lock);
 };
 
 }  // namespace hal
@@ -1,202 +1,4061 @@
 #include "platform_posix.hpp"
 
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
 #include <pthread.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <termios.h>
 #include <time.h>
 #include <unistd.h>
 
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/epoll.h>
+#include <sys/syscall.h>
+#else
+#include <sched.h>
+#endif
+
+#if V4_HAL_POSIX_TSC_CLOCK
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
 #include <cstdio>
 #include <cstring>
+#include <new>
+#include <vector>
 
+#include "../../src/internal/pin_bank.hpp"
+#include "../../src/internal/ring_buffer.hpp"
+#include "../../src/internal/varint.hpp"
 #include "v4/hal_capabilities.h"
 #include "v4/hal_error.h"
+#include "v4/hal_sim.h"
 
 namespace v4
 {
 namespace hal
 {
 
+// macOS cannot bind condition variables to the monotonic clock
+#ifdef __APPLE__
+static constexpr clockid_t kCondClock = CLOCK_REALTIME;
+#else
+static constexpr clockid_t kCondClock = CLOCK_MONOTONIC;
+#endif
+
+// Absolute condition variable deadline timeout_us from now
+static struct timespec cond_deadline(uint64_t timeout_us)
+{
+  struct timespec ts;
+  clock_gettime(kCondClock, &ts);
+  uint64_t ns = static_cast<uint64_t>(ts.tv_nsec) + 1000ULL * timeout_us;
+  ts.tv_sec += static_cast<time_t>(ns / 1000000000ULL);
+  ts.tv_nsec = static_cast<long>(ns % 1000000000ULL);
+  return ts;
+}
+
 /* ========================================================================= */
 /* GPIO Simulation State                                                     */
 /* ========================================================================= */
 
-static uint32_t gpio_states = 0;  // Pin values (0 or 1)
-static uint32_t gpio_modes = 0;   // Pin modes (0=input, 1=output)
+static_assert(PosixPlatform::max_gpio_pins() > 0 &&
+                  PosixPlatform::max_gpio_pins() <= 65535,
+              "V4_HAL_POSIX_GPIO_PINS must be between 1 and 65535");
+
+/**
+ * Pin levels and modes live in PinBank bitmaps sized by max_gpio_pins().
+ * Both are only changed with single atomic RMW operations on one 64-bit
+ * word, so concurrent pin traffic from several host threads needs no
+ * lock. The value returned by each RMW is the exact prior state of that
+ * word, which is what edge detection compares against.
+ */
+using GpioBank = PinBank<PosixPlatform::max_gpio_pins()>;
+using GpioWord = GpioBank::Word;
 
 /* ========================================================================= */
-/* GPIO Implementation                                                       */
+/* GPIO Interrupt Engine                                                     */
 /* ========================================================================= */
 
-int PosixPlatform::gpio_mode_impl(int pin, hal_gpio_mode_t mode)
+/**
+ * Level changes are compared against per-edge enable masks; matching pins
+ * are OR-ed into the context's pending bitmask, and on a word's empty ->
+ * non-empty transition the context is appended to the queue of one
+ * process-wide dispatch thread. The dispatcher serves queued contexts in
+ * turn, taking each pending word in one exchange and walking its set
+ * bits, so a burst on N pins costs O(popcount) handler lookups rather
+ * than a scan of every pin, and thousands of boards cost one thread. A
+ * handler that blocks delays the interrupts of every board.
+ */
+struct PosixContext;
+
+struct GpioIrqSlot
 {
-  // Simulate mode configuration by setting bit in gpio_modes
-  if (mode == HAL_GPIO_OUTPUT || mode == HAL_GPIO_OUTPUT_OD)
+  hal_gpio_irq_handler_t handler;
+  void* user_data;
+};
+
+struct GpioIrqEngine
+{
+  pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;      // Guards slots
+  pthread_mutex_t run_lock = PTHREAD_MUTEX_INITIALIZER;  // Held while a handler runs
+  GpioBank attached;  // Pins with a handler
+  GpioBank enabled;   // Unmasked pins
+  GpioBank rising;    // Pins triggering on rising edges
+  GpioBank falling;   // Pins triggering on falling edges
+  GpioBank pending;   // Fired, not yet dispatched
+  GpioIrqSlot slots[PosixPlatform::max_gpio_pins()];
+  PosixContext* next_queued = nullptr;  // Dispatcher queue link (dispatcher lock)
+  bool queued = false;                  // On the dispatcher queue (dispatcher lock)
+};
+
+struct GpioIrqDispatcher
+{
+  pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;  // Guards the queue and startup
+  pthread_cond_t cond = PTHREAD_COND_INITIALIZER;    // Signalled when a context queues
+  pthread_cond_t served = PTHREAD_COND_INITIALIZER;  // Signalled after each context
+  pthread_t thread;
+  std::atomic<bool> started{false};
+  PosixContext* head = nullptr;  // Contexts with pending interrupts, FIFO
+  PosixContext* tail = nullptr;
+  PosixContext* serving = nullptr;  // Context whose handlers are running
+};
+
+static GpioIrqDispatcher gpio_dispatcher;
+
+/* ========================================================================= */
+/* Simulation Contexts                                                       */
+/* ========================================================================= */
+
+/**
+ * Everything that belongs to one simulated board lives in a PosixContext:
+ * pin levels and modes, the interrupt engine, the critical section and
+ * the UART port table. A thread acts on the context it bound with
+ * hal_context_bind(), or on the static default context, so a process
+ * without contexts behaves as one board. The interrupt dispatcher and
+ * the replay thread bind the context they are serving, and software
+ * timer callbacks run bound to their creator's context.
+ *
+ * The host clock, virtual time and the interrupt, timer, UART and console
+ * service threads are process-wide; contexts share them.
+ */
+static constexpr size_t kCriticalSiteSlots = 32;  // Power of two
+
+struct CriticalLock
+{
+  alignas(kCacheLineSize) std::atomic<uint32_t> word{0};
+  uint32_t depth = 0;
+  std::atomic<uint32_t> spin_estimate{0};
+};
+
+struct CriticalSiteSlot
+{
+  std::atomic<uintptr_t> site{0};
+  std::atomic<uint64_t> contended{0};
+};
+
+struct CriticalStats
+{
+  alignas(kCacheLineSize) std::atomic<uint64_t> contended{0};
+  std::atomic<uint64_t> spin_acquired{0};
+  std::atomic<uint64_t> sleeps{0};
+  std::atomic<uint32_t> max_depth{0};
+  std::atomic<uint64_t> other_sites{0};  // Contended enters from sites that did not fit
+  CriticalSiteSlot sites[kCriticalSiteSlots];
+};
+
+struct UartHandleData;
+
+struct PosixContext
+{
+  GpioBank gpio_states;  // Pin values (0 or 1)
+  GpioBank gpio_modes;   // Pin modes (0=input, 1=output)
+  GpioIrqEngine irq;
+  CriticalLock critical;
+  CriticalStats critical_stats;
+  UartHandleData* uart_ports[PosixPlatform::max_uart_ports()] = {};  // uart_loop.lock
+  hal_handle_t sys_uart[PosixPlatform::max_uart_ports()] = {};  // Opened by UART_INIT
+  std::atomic<uint64_t> refs{0};  // Bindings, open UART handles and software timers
+  PosixContext* next_free = nullptr;  // Arena free list
+};
+
+static PosixContext default_context;
+static thread_local PosixContext* bound_context = nullptr;  // Never &default_context
+
+// Context of the calling thread
+static inline PosixContext& context()
+{
+  PosixContext* c = bound_context;
+  return c ? *c : default_context;
+}
+
+/**
+ * PosixContext::refs keeps a context alive. Each thread bound to it, and
+ * the interrupt dispatcher while it runs one of its handlers, holds a
+ * kContextBinding; each open UART handle and software timer holds 1.
+ * hal_context_destroy() claims a context with one CAS that requires no
+ * binding and nothing but its UART_INIT handles, and sets kContextDying
+ * while it confirms them, so it cannot free a context a thread is using.
+ */
+static constexpr uint64_t kContextBinding = 1ULL << 32;
+static constexpr uint64_t kContextDying = 1ULL << 63;
+
+// Take a binding on c unless hal_context_destroy() is claiming it
+static bool context_try_bind(PosixContext& c)
+{
+  uint64_t refs = c.refs.load(std::memory_order_relaxed);
+  do
   {
-    gpio_modes |= (1u << pin);
-  }
-  else
+    if (refs & kContextDying)
+      return false;
+  } while (!c.refs.compare_exchange_weak(refs, refs + kContextBinding,
+                                         std::memory_order_acquire,
+                                         std::memory_order_relaxed));
+  return true;
+}
+
+static inline void context_unbind(PosixContext& c)
+{
+  c.refs.fetch_sub(kContextBinding, std::memory_order_release);
+}
+
+/* ========================================================================= */
+/* GPIO Interrupt Dispatch                                                   */
+/* ========================================================================= */
+
+// Run the handlers of every pending pin of one context. Each handler
+// holds a binding on c, and is skipped if c is being destroyed.
+static void gpio_irq_dispatch(PosixContext& c)
+{
+  GpioIrqEngine& irq = c.irq;
+  bool counted = (&c != &default_context);
+  for (size_t w = 0; w < GpioBank::kWords; w++)
   {
-    gpio_modes &= ~(1u << pin);
+    GpioWord fired = irq.pending.exchange(w, 0);
+    while (fired)
+    {
+      int pin = static_cast<int>(w * GpioBank::kWordBits) + __builtin_ctzll(fired);
+      fired &= fired - 1;
+
+      // Re-check under run_lock so detach/disable from another thread is final
+      pthread_mutex_lock(&irq.run_lock);
+      if (irq.enabled.test(pin))
+      {
+        pthread_mutex_lock(&irq.lock);
+        GpioIrqSlot slot = irq.slots[pin];
+        pthread_mutex_unlock(&irq.lock);
+        if (slot.handler && (!counted || context_try_bind(c)))
+        {
+          bound_context = counted ? &c : nullptr;
+          slot.handler(pin, slot.user_data);
+          PosixPlatform::context_bind_impl(nullptr);  // Also drops a binding it left
+        }
+      }
+      pthread_mutex_unlock(&irq.run_lock);
+    }
   }
-  return HAL_OK;
 }
 
-int PosixPlatform::gpio_write_impl(int pin, hal_gpio_value_t value)
+// Serves queued contexts for the life of the process; handlers run bound
+// to the context they belong to (see gpio_irq_dispatch())
+static void* gpio_irq_thread(void*)
 {
-  // Check if pin is configured as output
-  if (!(gpio_modes & (1u << pin)))
+  GpioIrqDispatcher& d = gpio_dispatcher;
+  pthread_mutex_lock(&d.lock);
+  for (;;)
   {
-    return HAL_ERR_PARAM;  // Pin not configured as output
+    while (!d.head)
+      pthread_cond_wait(&d.cond, &d.lock);
+
+    PosixContext* c = d.head;
+    d.head = c->irq.next_queued;
+    if (!d.head)
+      d.tail = nullptr;
+    c->irq.queued = false;  // Before the exchanges, so new edges queue it again
+    d.serving = c;
+    pthread_mutex_unlock(&d.lock);
+
+    gpio_irq_dispatch(*c);
+
+    pthread_mutex_lock(&d.lock);
+    d.serving = nullptr;
+    pthread_cond_broadcast(&d.served);
   }
+  return nullptr;
+}
 
-  // Update pin state
-  if (value == HAL_GPIO_HIGH)
+// Append c to the dispatcher queue unless it is already waiting there
+static void gpio_irq_queue(PosixContext& c)
+{
+  GpioIrqDispatcher& d = gpio_dispatcher;
+  pthread_mutex_lock(&d.lock);
+  if (!c.irq.queued)
   {
-    gpio_states |= (1u << pin);
+    c.irq.queued = true;
+    c.irq.next_queued = nullptr;
+    if (d.tail)
+      d.tail->irq.next_queued = &c;
+    else
+      d.head = &c;
+    d.tail = &c;
+    pthread_cond_signal(&d.cond);
   }
-  else
+  pthread_mutex_unlock(&d.lock);
+}
+
+// Take c off the dispatcher and wait until none of its handlers is running
+static void gpio_irq_forget(PosixContext& c)
+{
+  GpioIrqDispatcher& d = gpio_dispatcher;
+  pthread_mutex_lock(&d.lock);
+  if (c.irq.queued)
   {
-    gpio_states &= ~(1u << pin);
+    PosixContext* prev = nullptr;
+    for (PosixContext* p = d.head; p != &c; p = p->irq.next_queued)
+      prev = p;
+    (prev ? prev->irq.next_queued : d.head) = c.irq.next_queued;
+    if (d.tail == &c)
+      d.tail = prev;
+    c.irq.queued = false;
   }
-  return HAL_OK;
+  while (d.serving == &c)
+    pthread_cond_wait(&d.served, &d.lock);
+  pthread_mutex_unlock(&d.lock);
 }
 
-int PosixPlatform::gpio_read_impl(int pin, hal_gpio_value_t* value)
+// Queue interrupts for the pins of word w that changed to levels on an armed edge
+static void gpio_irq_raise(PosixContext& c, size_t w, GpioWord changed, GpioWord levels)
 {
-  *value = (gpio_states & (1u << pin)) ? HAL_GPIO_HIGH : HAL_GPIO_LOW;
-  return HAL_OK;
+  GpioIrqEngine& irq = c.irq;
+  GpioWord fire = (changed & levels & irq.rising.load(w)) |
+                  (changed & ~levels & irq.falling.load(w));
+  fire &= irq.enabled.load(w);
+  if (!fire)
+    return;
+
+  if (irq.pending.fetch_or(w, fire) == 0)
+    gpio_irq_queue(c);
+}
+
+// Raise interrupts for the bits of word w that differ between old and new levels
+static inline void gpio_irq_check(PosixContext& c, size_t w, GpioWord old_word,
+                                  GpioWord new_word)
+{
+  GpioWord changed = (old_word ^ new_word) & c.irq.attached.load(w);
+  if (changed)
+    gpio_irq_raise(c, w, changed, new_word);
 }
 
 /* ========================================================================= */
-/* UART Simulation                                                           */
+/* GPIO Trace Recorder                                                       */
 /* ========================================================================= */
 
-struct UartHandleData
+/**
+ * While hal_sim_gpio_record_start() is in effect, every level and
+ * direction change is appended by the changing thread to its own SPSC
+ * ring as two varints: microseconds since that thread's previous event
+ * and pin << 2 | kind. Each call is one clock read, varints encoded in
+ * place in the ring and a release store; a full ring drops (and counts)
+ * the batch rather than block. examples/trace_bench measures the cost,
+ * which is dominated by the clock read. A writer thread drains every ring
+ * each V4_HAL_POSIX_GPIO_TRACE_FLUSH_US, or as soon as one is half full,
+ * merges the events by time and streams them through a sliding mmap
+ * window into the trace file. Only the context that started the
+ * recording is recorded.
+ */
+enum : uint8_t
 {
-  int port;
-  FILE* fp;
+  kTraceLow = 0,
+  kTraceHigh = 1,
+  kTraceInput = 2,
+  kTraceOutput = 3,
 };
 
-hal_handle_t PosixPlatform::uart_open_impl(int port, const hal_uart_config_t* config)
+static constexpr size_t kTraceRecordMax = 2 * kVarintMaxBytes;
+static constexpr size_t kTraceWindow = 1 << 20;  // Bytes mapped at a time
+
+struct TraceBuffer
+{
+  SpscByteRing<PosixPlatform::gpio_trace_ring_size()> ring;
+  TraceBuffer* next = nullptr;       // Registry link, set before publishing
+  std::atomic<bool> retired{false};  // Owning thread has exited
+  std::atomic<uint64_t> dropped{0};
+  uint32_t session = 0;  // Producer: session last_us belongs to
+  uint64_t last_us = 0;  // Producer: time of the previous event
+  uint64_t base_us = 0;  // Writer: time of the previous decoded event
+  uint8_t carry[kTraceRecordMax];  // Writer: partial record between pops
+  size_t carry_len = 0;
+};
+
+struct TraceEvent
+{
+  uint64_t us;
+  uint64_t code;  // pin << 2 | kind
+};
+
+struct TraceFile
+{
+  int fd = -1;
+  uint8_t* map = nullptr;  // Window of kTraceWindow bytes at map_off
+  uint64_t map_off = 0;
+  size_t pos = 0;  // Write position in the window
+  bool error = false;
+};
+
+struct GpioTrace
 {
-  (void)config;  // Unused in simulation
+  std::atomic<uint32_t> session{0};  // Non-zero while recording
+  std::atomic<PosixContext*> context{nullptr};  // Context being recorded
+  std::atomic<TraceBuffer*> buffers{nullptr};
+  pthread_mutex_t control = PTHREAD_MUTEX_INITIALIZER;  // Serializes start/stop
+  pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;     // Guards wake
+  pthread_cond_t wake;                                  // Writer waits here
+  std::atomic<bool> kicked{false};                      // A buffer passed half full
+  uint32_t last_session = 0;
+  uint64_t start_us = 0;
+  hal_sim_trace_format_t format = HAL_SIM_TRACE_BINARY;
+  pthread_t writer;
+  std::atomic<bool> stopping{false};
+  bool initialized = false;  // wake and the exit hook are set up
+  TraceFile file;
+  uint64_t emitted_us = 0;  // Time of the last event written
+  uint64_t events = 0;
+};
 
-  auto* handle = new UartHandleData{port, nullptr};
+static GpioTrace gpio_trace;
+static thread_local TraceBuffer* trace_tls = nullptr;
 
-  // Port 0 uses stdout for simulation
-  if (port == 0)
+// Marks the thread's buffer for reclamation when the thread exits
+struct TraceOwner
+{
+  TraceBuffer* buffer = nullptr;
+  ~TraceOwner()
   {
-    handle->fp = stdout;
+    if (buffer)
+      buffer->retired.store(true, std::memory_order_release);
+    trace_tls = nullptr;
   }
+};
 
-  return static_cast<hal_handle_t>(handle);
+static thread_local TraceOwner trace_owner;
+
+static TraceBuffer* trace_register()
+{
+  auto* b = new (std::nothrow) TraceBuffer;  // Ring pages stay untouched until used
+  if (!b)
+    return nullptr;
+
+  TraceBuffer* head = gpio_trace.buffers.load(std::memory_order_relaxed);
+  do
+    b->next = head;
+  while (!gpio_trace.buffers.compare_exchange_weak(head, b, std::memory_order_release,
+                                                   std::memory_order_relaxed));
+  trace_owner.buffer = b;
+  trace_tls = b;
+  return b;
 }
 
-int PosixPlatform::uart_close_impl(hal_handle_t handle)
+// Wake the writer early once a buffer is half full
+static void trace_kick()
 {
-  auto* h = static_cast<UartHandleData*>(handle);
-  delete h;
-  return HAL_OK;
+  if (gpio_trace.kicked.load(std::memory_order_relaxed) ||
+      gpio_trace.kicked.exchange(true, std::memory_order_relaxed))
+    return;
+  pthread_mutex_lock(&gpio_trace.lock);
+  pthread_cond_signal(&gpio_trace.wake);
+  pthread_mutex_unlock(&gpio_trace.lock);
 }
 
-int PosixPlatform::uart_write_impl(hal_handle_t handle, const uint8_t* buf, size_t len)
+// Append one record per set bit of changed; kind is base + the bit's new
+// value. The batch shares one timestamp, one space check and one push.
+static void trace_record(uint32_t session, size_t w, GpioWord changed, GpioWord values,
+                         uint8_t base)
 {
-  auto* h = static_cast<UartHandleData*>(handle);
-  if (h->fp)
+  TraceBuffer* b = trace_tls ? trace_tls : trace_register();
+  if (!b)
+    return;
+  if (b->session != session)
   {
-    size_t written = fwrite(buf, 1, len, h->fp);
-    fflush(h->fp);
-    return static_cast<int>(written);
+    b->session = session;
+    b->last_us = gpio_trace.start_us;
   }
-  return 0;
+
+  // Encode straight into the ring when the contiguous free span can take
+  // the worst case, otherwise into a local batch copied in below
+  uint8_t* span;
+  size_t worst = kTraceRecordMax * static_cast<size_t>(__builtin_popcountll(changed));
+  bool in_place = b->ring.write_span(&span) >= worst;
+  uint8_t local[GpioBank::kWordBits * kTraceRecordMax];
+  uint8_t* rec = in_place ? span : local;
+
+  uint64_t now = PosixPlatform::micros_impl();
+  size_t n = varint_encode(now > b->last_us ? now - b->last_us : 0, rec);
+  uint64_t first_pin = w * GpioBank::kWordBits;
+  GpioWord pending = changed;
+  for (;;)
+  {
+    int bit = __builtin_ctzll(pending);
+    pending &= pending - 1;
+    n += varint_encode((first_pin + bit) << 2 | (base + ((values >> bit) & 1)), rec + n);
+    if (!pending)
+      break;
+    rec[n++] = 0;  // Later records of the batch are 0 us after the first
+  }
+
+  if (in_place)
+  {
+    b->ring.commit(n);
+  }
+  else if (b->ring.space() >= n)
+  {
+    b->ring.push(rec, n);
+  }
+  else
+  {
+    b->dropped.fetch_add(__builtin_popcountll(changed), std::memory_order_relaxed);
+    trace_kick();
+    return;
+  }
+  if (now > b->last_us)
+    b->last_us = now;
+  if (b->ring.size() > b->ring.capacity() / 2)
+    trace_kick();
 }
 
-int PosixPlatform::uart_read_impl(hal_handle_t handle, uint8_t* buf, size_t len)
+// Hot-path hook: one load when recording is off
+static inline void gpio_trace_changes(PosixContext& c, size_t w, GpioWord changed,
+                                      GpioWord values, uint8_t base)
 {
-  (void)handle;
-  (void)buf;
-  (void)len;
-  // Non-blocking read - simplified implementation returns 0
-  return 0;
+  uint32_t session = gpio_trace.session.load(std::memory_order_acquire);
+  if (__builtin_expect(session != 0, 0) && changed &&
+      gpio_trace.context.load(std::memory_order_relaxed) == &c)
+    trace_record(session, w, changed, values, base);
 }
 
-int PosixPlatform::uart_available_impl(hal_handle_t handle)
+static bool trace_file_map(TraceFile& f, uint64_t off)
 {
-  (void)handle;
-  return 0;  // Simplified implementation
+  if (f.map)
+    munmap(f.map, kTraceWindow);
+  f.map = nullptr;
+  if (ftruncate(f.fd, static_cast<off_t>(off + kTraceWindow)) != 0)
+    return false;
+
+  void* p = mmap(nullptr, kTraceWindow, PROT_READ | PROT_WRITE, MAP_SHARED, f.fd,
+                 static_cast<off_t>(off));
+  if (p == MAP_FAILED)
+    return false;
+  f.map = static_cast<uint8_t*>(p);
+  f.map_off = off;
+  f.pos = 0;
+  return true;
 }
 
-/* ========================================================================= */
-/* Timer Implementation                                                      */
-/* ========================================================================= */
+static void trace_file_write(TraceFile& f, const void* data, size_t len)
+{
+  auto* p = static_cast<const uint8_t*>(data);
+  while (len && !f.error)
+  {
+    if (f.pos == kTraceWindow && !trace_file_map(f, f.map_off + kTraceWindow))
+    {
+      f.error = true;
+      break;
+    }
+    size_t n = std::min(len, kTraceWindow - f.pos);
+    memcpy(f.map + f.pos, p, n);
+    f.pos += n;
+    p += n;
+    len -= n;
+  }
+}
 
-static uint64_t get_time_ns()
+// VCD identifier for variable index i (printable characters '!' to '~')
+static size_t trace_vcd_id(size_t i, char* out)
 {
-  struct timespec ts;
-  clock_gettime(CLOCK_MONOTONIC, &ts);
-  return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+  size_t n = 0;
+  do
+  {
+    out[n++] = static_cast<char>('!' + i % 94);
+    i /= 94;
+  } while (i);
+  return n;
 }
 
-static const uint64_t start_time = get_time_ns();
+static void trace_emit(uint64_t us, uint64_t code)
+{
+  TraceFile& f = gpio_trace.file;
+  if (gpio_trace.format == HAL_SIM_TRACE_BINARY)
+  {
+    uint8_t rec[kTraceRecordMax];
+    size_t n = varint_encode(us - gpio_trace.emitted_us, rec);
+    n += varint_encode(code, rec + n);
+    trace_file_write(f, rec, n);
+  }
+  else
+  {
+    char line[48];
+    int n = 0;
+    if (us != gpio_trace.emitted_us || gpio_trace.events == 0)
+      n = snprintf(line, sizeof(line), "#%llu\n",
+                   static_cast<unsigned long long>(us - gpio_trace.start_us));
+    uint64_t kind = code & 3;
+    // Levels are variable 2 * pin, directions 2 * pin + 1
+    size_t var = static_cast<size_t>((code >> 2) * 2 + (kind >= kTraceInput));
+    line[n++] = (kind & 1) ? '1' : '0';
+    n += static_cast<int>(trace_vcd_id(var, line + n));
+    line[n++] = '\n';
+    trace_file_write(f, line, static_cast<size_t>(n));
+  }
+  gpio_trace.emitted_us = us;
+  gpio_trace.events++;
+}
 
-uint32_t PosixPlatform::millis_impl()
+// Decode the complete records buffered in b
+static void trace_collect(TraceBuffer* b, std::vector<TraceEvent>& events)
 {
-  return static_cast<uint32_t>((get_time_ns() - start_time) / 1000000);
+  uint8_t chunk[4096];
+  for (;;)
+  {
+    size_t n = b->carry_len;
+    memcpy(chunk, b->carry, n);
+    size_t got = b->ring.pop(chunk + n, sizeof(chunk) - n);
+    if (!got)
+      return;
+    n += got;
+
+    size_t pos = 0;
+    for (;;)
+    {
+      uint64_t delta;
+      uint64_t code;
+      size_t a = varint_decode(chunk + pos, n - pos, &delta);
+      size_t c = a ? varint_decode(chunk + pos + a, n - pos - a, &code) : 0;
+      if (!c)
+        break;
+      pos += a + c;
+      b->base_us += delta;
+      events.push_back({b->base_us, code});
+    }
+    b->carry_len = n - pos;
+    memcpy(b->carry, chunk + pos, b->carry_len);
+  }
 }
 
-uint64_t PosixPlatform::micros_impl()
+// Merge everything buffered so far into the file; reclaim exited threads' buffers
+static void trace_drain(std::vector<TraceEvent>& events)
 {
-  return (get_time_ns() - start_time) / 1000;
+  events.clear();
+  TraceBuffer* prev = nullptr;
+  TraceBuffer* b = gpio_trace.buffers.load(std::memory_order_acquire);
+  while (b)
+  {
+    bool retired = b->retired.load(std::memory_order_acquire);
+    trace_collect(b, events);
+    TraceBuffer* next = b->next;
+    // Producers only ever replace the head, so any other node can be unlinked
+    if (retired && prev && b->ring.size() == 0)
+    {
+      prev->next = next;
+      delete b;
+    }
+    else
+    {
+      prev = b;
+    }
+    b = next;
+  }
+
+  std::stable_sort(events.begin(), events.end(),
+                   [](const TraceEvent& x, const TraceEvent& y) { return x.us < y.us; });
+  for (const TraceEvent& e : events)
+  {
+    // Events committed after a later drain are clamped to keep time monotonic
+    trace_emit(std::max(e.us, gpio_trace.emitted_us), e.code);
+  }
 }
 
-void PosixPlatform::delay_ms_impl(uint32_t ms)
+static void* gpio_trace_thread(void*)
 {
-  usleep(ms * 1000);
+  std::vector<TraceEvent> events;
+  for (;;)
+  {
+    bool stopping = gpio_trace.stopping.load(std::memory_order_acquire);
+    gpio_trace.kicked.store(false, std::memory_order_relaxed);
+    trace_drain(events);
+    if (stopping)
+      return nullptr;
+
+    pthread_mutex_lock(&gpio_trace.lock);
+    if (!gpio_trace.kicked.load(std::memory_order_relaxed) &&
+        !gpio_trace.stopping.load(std::memory_order_relaxed))
+    {
+      struct timespec ts = cond_deadline(V4_HAL_POSIX_GPIO_TRACE_FLUSH_US);
+      pthread_cond_timedwait(&gpio_trace.wake, &gpio_trace.lock, &ts);
+    }
+    pthread_mutex_unlock(&gpio_trace.lock);
+  }
 }
 
-void PosixPlatform::delay_us_impl(uint32_t us)
+static void trace_write_header()
+{
+  constexpr int kPins = PosixPlatform::max_gpio_pins();
+  if (gpio_trace.format == HAL_SIM_TRACE_BINARY)
+  {
+    uint8_t header[16] = {'V', '4', 'G', 'T', 1, 0, kPins & 0xff, kPins >> 8};
+    for (int i = 0; i < 8; i++)
+      header[8 + i] = static_cast<uint8_t>(gpio_trace.start_us >> (8 * i));
+    trace_file_write(gpio_trace.file, header, sizeof(header));
+    return;
+  }
+
+  static const char kHead[] =
+      "$version V4 HAL GPIO trace $end\n$timescale 1us $end\n$scope module gpio $end\n";
+  trace_file_write(gpio_trace.file, kHead, sizeof(kHead) - 1);
+  for (int pin = 0; pin < kPins; pin++)
+  {
+    char line[64];
+    for (int dir = 0; dir < 2; dir++)
+    {
+      char id[8];
+      size_t idn = trace_vcd_id(static_cast<size_t>(2 * pin + dir), id);
+      int n = snprintf(line, sizeof(line), "$var wire 1 %.*s pin%d%s $end\n",
+                       static_cast<int>(idn), id, pin, dir ? "_out" : "");
+      trace_file_write(gpio_trace.file, line, static_cast<size_t>(n));
+    }
+  }
+  static const char kTail[] = "$upscope $end\n$enddefinitions $end\n";
+  trace_file_write(gpio_trace.file, kTail, sizeof(kTail) - 1);
+}
+
+static int trace_close_file(uint64_t* bytes)
 {
-  usleep(us);
+  TraceFile& f = gpio_trace.file;
+  uint64_t size = f.map_off + f.pos;
+  if (f.map)
+    munmap(f.map, kTraceWindow);
+  bool ok = !f.error && ftruncate(f.fd, static_cast<off_t>(size)) == 0;
+  close(f.fd);
+  f = TraceFile();
+  if (bytes)
+    *bytes = size;
+  return ok ? HAL_OK : HAL_ERR_IO;
 }
 
-/* ========================================================================= */
-/* Console I/O Implementation                                                */
-/* ========================================================================= */
+// Called with gpio_trace.control held
+static int trace_stop_locked(hal_sim_trace_stats_t* stats)
+{
+  if (gpio_trace.session.load(std::memory_order_relaxed) == 0)
+    return HAL_ERR_PARAM;
 
-int PosixPlatform::console_write_impl(const uint8_t* buf, size_t len)
+  gpio_trace.session.store(0, std::memory_order_release);
+  pthread_mutex_lock(&gpio_trace.lock);
+  gpio_trace.stopping.store(true, std::memory_order_release);
+  pthread_cond_signal(&gpio_trace.wake);
+  pthread_mutex_unlock(&gpio_trace.lock);
+  pthread_join(gpio_trace.writer, nullptr);
+
+  uint64_t dropped = 0;
+  for (TraceBuffer* b = gpio_trace.buffers.load(std::memory_order_acquire); b;
+       b = b->next)
+    dropped += b->dropped.load(std::memory_order_relaxed);
+
+  uint64_t bytes = 0;
+  int ret = trace_close_file(&bytes);
+  if (stats)
+  {
+    stats->events = gpio_trace.events;
+    stats->dropped = dropped;
+    stats->bytes = bytes;
+  }
+  return ret;
+}
+
+static void trace_at_exit()
 {
-  // Write to stdout using POSIX write()
-  ssize_t written = write(STDOUT_FILENO, buf, len);
-  return (written >= 0) ? static_cast<int>(written) : HAL_ERR_IO;
+  pthread_mutex_lock(&gpio_trace.control);
+  trace_stop_locked(nullptr);
+  pthread_mutex_unlock(&gpio_trace.control);
 }
 
-int PosixPlatform::console_read_impl(uint8_t* buf, size_t len)
+// Called with gpio_trace.control held
+static int trace_start_locked(const char* path, hal_sim_trace_format_t format)
 {
-  // Read from stdin using POSIX read() - blocking
-  ssize_t bytes_read = read(STDIN_FILENO, buf, len);
-  return (bytes_read >= 0) ? static_cast<int>(bytes_read) : HAL_ERR_IO;
+  if (gpio_trace.session.load(std::memory_order_relaxed) != 0)
+    return HAL_ERR_BUSY;
+
+  if (!gpio_trace.initialized)
+  {
+    pthread_condattr_t cond_attr;
+    pthread_condattr_init(&cond_attr);
+#ifndef __APPLE__
+    pthread_condattr_setclock(&cond_attr, kCondClock);
+#endif
+    pthread_cond_init(&gpio_trace.wake, &cond_attr);
+    pthread_condattr_destroy(&cond_attr);
+    atexit(trace_at_exit);
+    gpio_trace.initialized = true;
+  }
+
+  TraceFile& f = gpio_trace.file;
+  f.fd = open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (f.fd < 0)
+    return HAL_ERR_IO;
+  if (!trace_file_map(f, 0))
+  {
+    trace_close_file(nullptr);
+    return HAL_ERR_IO;
+  }
+
+  // Leftovers from a previous session belong to no file
+  uint64_t start = PosixPlatform::micros_impl();
+  for (TraceBuffer* b = gpio_trace.buffers.load(std::memory_order_acquire); b;
+       b = b->next)
+  {
+    b->ring.consume(b->ring.size());
+    b->carry_len = 0;
+    b->base_us = start;
+    b->dropped.store(0, std::memory_order_relaxed);
+  }
+
+  gpio_trace.format = format;
+  gpio_trace.start_us = start;
+  gpio_trace.emitted_us = start;
+  gpio_trace.events = 0;
+  gpio_trace.stopping.store(false, std::memory_order_relaxed);
+  trace_write_header();
+
+  PosixContext& c = context();
+  gpio_trace.context.store(&c, std::memory_order_relaxed);
+  uint32_t session = ++gpio_trace.last_session;
+  if (session == 0)
+    session = ++gpio_trace.last_session;
+  gpio_trace.session.store(session, std::memory_order_release);
+
+  // Snapshot after enabling, so a change racing with it is recorded too
+  for (int pin = 0; pin < PosixPlatform::max_gpio_pins(); pin++)
+  {
+    uint64_t code = static_cast<uint64_t>(pin) << 2;
+    trace_emit(start, code | (c.gpio_states.test(pin) ? kTraceHigh : kTraceLow));
+    trace_emit(start, code | (c.gpio_modes.test(pin) ? kTraceOutput : kTraceInput));
+  }
+
+  if (pthread_create(&gpio_trace.writer, nullptr, gpio_trace_thread, nullptr) != 0)
+  {
+    gpio_trace.session.store(0, std::memory_order_release);
+    trace_close_file(nullptr);
+    return HAL_ERR_NOMEM;
+  }
+  return HAL_OK;
+}
+
+// Record and raise interrupts for a level change of word w
+static inline void gpio_levels_changed(PosixContext& c, size_t w, GpioWord old_word,
+                                       GpioWord new_word)
+{
+  gpio_trace_changes(c, w, old_word ^ new_word, new_word, kTraceLow);
+  gpio_irq_check(c, w, old_word, new_word);
+}
+
+// Update a pin level and raise its interrupt on an armed edge
+static void gpio_set_level(PosixContext& c, int pin, hal_gpio_value_t value)
+{
+  GpioWord bit = GpioBank::bit_of(pin);
+  GpioWord old_word;
+  GpioWord new_word;
+  if (value == HAL_GPIO_HIGH)
+  {
+    old_word = c.gpio_states.set(pin);
+    new_word = old_word | bit;
+  }
+  else
+  {
+    old_word = c.gpio_states.clear(pin);
+    new_word = old_word & ~bit;
+  }
+  gpio_levels_changed(c, GpioBank::word_of(pin), old_word, new_word);
+}
+
+// Block until the dispatcher is not inside a handler (unless we are it)
+static void gpio_irq_quiesce(GpioIrqEngine& irq)
+{
+  if (gpio_dispatcher.started.load(std::memory_order_acquire) &&
+      !pthread_equal(pthread_self(), gpio_dispatcher.thread))
+  {
+    pthread_mutex_lock(&irq.run_lock);
+    pthread_mutex_unlock(&irq.run_lock);
+  }
 }
 
 /* ========================================================================= */
-/* Interrupt Control Implementation                                          */
+/* GPIO Implementation                                                       */
 /* ========================================================================= */
 
-// Static mutex for critical sections
-static pthread_mutex_t critical_mutex = PTHREAD_MUTEX_INITIALIZER;
+int PosixPlatform::gpio_mode_impl(int pin, hal_gpio_mode_t mode)
+{
+  // Simulate mode configuration by setting bit in gpio_modes
+  PosixContext& c = context();
+  GpioWord bit = GpioBank::bit_of(pin);
+  GpioWord old_word;
+  GpioWord new_word;
+  if (mode == HAL_GPIO_OUTPUT || mode == HAL_GPIO_OUTPUT_OD)
+  {
+    old_word = c.gpio_modes.set(pin);
+    new_word = old_word | bit;
+  }
+  else
+  {
+    old_word = c.gpio_modes.clear(pin);
+    new_word = old_word & ~bit;
+  }
+  gpio_trace_changes(c, GpioBank::word_of(pin), old_word ^ new_word, new_word,
+                     kTraceInput);
+  return HAL_OK;
+}
+
+int PosixPlatform::gpio_write_impl(int pin, hal_gpio_value_t value)
+{
+  // Check if pin is configured as output
+  PosixContext& c = context();
+  if (!c.gpio_modes.test(pin))
+  {
+    return HAL_ERR_PARAM;  // Pin not configured as output
+  }
 
-void PosixPlatform::critical_enter_impl()
+  // Update pin state
+  gpio_set_level(c, pin, value);
+  return HAL_OK;
+}
+
+int PosixPlatform::gpio_read_impl(int pin, hal_gpio_value_t* value)
 {
-  // Use pthread_mutex for thread-safe critical sections
-  pthread_mutex_lock(&critical_mutex);
+  *value = context().gpio_states.test(pin) ? HAL_GPIO_HIGH : HAL_GPIO_LOW;
+  return HAL_OK;
 }
 
-void PosixPlatform::critical_exit_impl()
+int PosixPlatform::gpio_toggle_impl(int pin)
 {
-  // Release mutex
-  pthread_mutex_unlock(&critical_mutex);
+  PosixContext& c = context();
+  if (!c.gpio_modes.test(pin))
+  {
+    return HAL_ERR_PARAM;  // Pin not configured as output
+  }
+
+  GpioWord old_word = c.gpio_states.flip(pin);
+  gpio_levels_changed(c, GpioBank::word_of(pin), old_word,
+                      old_word ^ GpioBank::bit_of(pin));
+  return HAL_OK;
 }
 
-}  // namespace hal
-}  // namespace v4
+int PosixPlatform::gpio_write_bank_impl(int bank, uint64_t set_mask, uint64_t clear_mask)
+{
+  PosixContext& c = context();
+  size_t w = static_cast<size_t>(bank);
+  if ((set_mask | clear_mask) & ~c.gpio_modes.load(w))
+  {
+    return HAL_ERR_PARAM;  // Some pins not configured as output
+  }
+
+  // One atomic RMW for the whole word of pins
+  GpioWord old_word = c.gpio_states.update(w, set_mask, clear_mask);
+  gpio_levels_changed(c, w, old_word, (old_word | set_mask) & ~clear_mask);
+  return HAL_OK;
+}
+
+int PosixPlatform::gpio_read_bank_impl(int bank, uint64_t* value)
+{
+  *value = context().gpio_states.load(static_cast<size_t>(bank));
+  return HAL_OK;
+}
+
+int PosixPlatform::gpio_mode_bank_impl(int bank, uint64_t mask, hal_gpio_mode_t mode)
+{
+  PosixContext& c = context();
+  size_t w = static_cast<size_t>(bank);
+  if (mode == HAL_GPIO_OUTPUT || mode == HAL_GPIO_OUTPUT_OD)
+  {
+    GpioWord old_word = c.gpio_modes.fetch_or(w, mask);
+    gpio_trace_changes(c, w, ~old_word & mask, mask, kTraceInput);
+  }
+  else
+  {
+    GpioWord old_word = c.gpio_modes.fetch_and(w, ~mask);
+    gpio_trace_changes(c, w, old_word & mask, 0, kTraceInput);
+  }
+  return HAL_OK;
+}
+
+int PosixPlatform::gpio_irq_attach_impl(int pin, hal_gpio_irq_edge_t edge,
+                                        hal_gpio_irq_handler_t handler, void* user_data)
+{
+  PosixContext& c = context();
+  GpioIrqEngine& irq = c.irq;
+  pthread_mutex_lock(&irq.lock);
+  if (irq.attached.test(pin))
+  {
+    pthread_mutex_unlock(&irq.lock);
+    return HAL_ERR_BUSY;
+  }
+
+  // The dispatcher starts with the first handler of any context and then
+  // idles on its condition variable for the life of the process
+  GpioIrqDispatcher& d = gpio_dispatcher;
+  pthread_mutex_lock(&d.lock);
+  if (!d.started.load(std::memory_order_relaxed))
+  {
+    if (pthread_create(&d.thread, nullptr, gpio_irq_thread, nullptr) != 0)
+    {
+      pthread_mutex_unlock(&d.lock);
+      pthread_mutex_unlock(&irq.lock);
+      return HAL_ERR_NOMEM;
+    }
+    d.started.store(true, std::memory_order_release);
+  }
+  pthread_mutex_unlock(&d.lock);
+
+  irq.slots[pin] = GpioIrqSlot{handler, user_data};
+  if (edge & HAL_GPIO_IRQ_RISING)
+    irq.rising.set(pin);
+  if (edge & HAL_GPIO_IRQ_FALLING)
+    irq.falling.set(pin);
+  irq.enabled.set(pin);
+  irq.attached.set(pin);
+  pthread_mutex_unlock(&irq.lock);
+  return HAL_OK;
+}
+
+int PosixPlatform::gpio_irq_detach_impl(int pin)
+{
+  GpioIrqEngine& irq = context().irq;
+  pthread_mutex_lock(&irq.lock);
+  if (!irq.attached.test(pin))
+  {
+    pthread_mutex_unlock(&irq.lock);
+    return HAL_ERR_PARAM;
+  }
+  irq.attached.clear(pin);
+  irq.enabled.clear(pin);
+  irq.rising.clear(pin);
+  irq.falling.clear(pin);
+  irq.slots[pin] = GpioIrqSlot{nullptr, nullptr};
+  pthread_mutex_unlock(&irq.lock);
+
+  gpio_irq_quiesce(irq);
+  return HAL_OK;
+}
+
+int PosixPlatform::gpio_irq_enable_impl(int pin)
+{
+  GpioIrqEngine& irq = context().irq;
+  if (!irq.attached.test(pin))
+    return HAL_ERR_PARAM;
+  irq.enabled.set(pin);
+  return HAL_OK;
+}
+
+int PosixPlatform::gpio_irq_disable_impl(int pin)
+{
+  GpioIrqEngine& irq = context().irq;
+  if (!irq.attached.test(pin))
+    return HAL_ERR_PARAM;
+  irq.enabled.clear(pin);
+  gpio_irq_quiesce(irq);
+  return HAL_OK;
+}
+
+/* ========================================================================= */
+/* UART Simulation                                                           */
+/* ========================================================================= */
+
+/**
+ * Each open port owns an SPSC RX ring. A single event-loop thread
+ * (epoll on Linux, poll elsewhere) services every port's receive fd and
+ * reads straight into the ring's free space; HAL callers drain the ring
+ * without any syscall. When a ring fills, its fd is disarmed
+ * (back-pressure) until the consumer frees space. Blocking readers sleep
+ * on a per-port condition variable that the loop signals only while
+ * someone is waiting; under HAL_CLOCK_VIRTUAL they wait as virtual-time
+ * participants on rx_ready instead, so their timeouts are virtual too.
+ *
+ * Transmit data is coalesced in a per-port buffer and handed to the fd
+ * with writev() when the buffer fills, on a newline (line mode), on
+ * hal_uart_flush(), or when the event loop sees the latency deadline pass.
+ */
+struct UartHandleData
+{
+  PosixContext* ctx;  // Context the port was opened in
+  int port;
+  hal_uart_backend_t backend;
+  int rx_fd;                     // RX source (-1 = none)
+  int tx_fd;                     // TX sink (-1 = discard), guarded by tx_lock
+  int listen_fd;                 // SOCKET: listening socket
+  int hold_fd;                   // PTY: slave kept open so the master never HUPs
+  uint32_t slot;                 // Event loop slot index
+  bool rx_armed;                 // rx_fd is watched by the loop (loop lock)
+  bool rx_polled;                // rx_fd is read on every loop pass (loop lock)
+  bool listening;                // listen_fd is watched by the loop (loop lock)
+  uint8_t owned_paths;           // Filesystem entries to remove on close
+  std::atomic<bool> rx_stalled;  // RX fd disarmed until the ring drains
+  std::atomic<int> rx_waiters;   // Threads blocked in uart_read_timeout_impl
+  std::atomic<bool> rx_ready;    // Set with rx_cond for virtual-time readers
+  pthread_mutex_t rx_lock;       // Pairs with rx_cond
+  pthread_cond_t rx_cond;        // Signalled when bytes land in the ring
+  pthread_mutex_t tx_lock;       // Guards tx_fd and the TX buffer
+  hal_uart_tx_mode_t tx_mode;    // Coalescing policy
+  bool tx_timed;                 // Buffered data counted in tx_pending
+  uint64_t tx_flush_ns;          // Max latency of buffered data
+  uint64_t tx_deadline;          // Flush deadline of buffered data
+  size_t tx_len;                 // Bytes buffered in tx_buf
+  uint8_t tx_buf[PosixPlatform::uart_tx_buffer_size()];
+  char path[sizeof(sockaddr_un::sun_path)];
+  SpscByteRing<PosixPlatform::uart_rx_ring_size()> rx;  // Received bytes
+};
+
+// owned_paths bits
+static constexpr uint8_t kOwnPath = 0x01;    // path itself (symlink/socket)
+static constexpr uint8_t kOwnFifoRx = 0x02;  // path.rx
+static constexpr uint8_t kOwnFifoTx = 0x04;  // path.tx
+
+/* ------------------------------------------------------------------------- */
+/* Event loop                                                                */
+/* ------------------------------------------------------------------------- */
+
+// Event tag: slot index in the upper bits, fd role in the low bit
+static constexpr uint64_t kTagListen = 1;
+static constexpr uint64_t kTagWake = ~0ull;
+
+struct UartLoop
+{
+  pthread_mutex_t life_lock = PTHREAD_MUTEX_INITIALIZER;  // open/close/start/stop
+  pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;       // slots and fd state
+  pthread_t thread;
+  std::atomic<bool> running{false};
+  int users = 0;
+  std::atomic<int> stalled{0};
+  std::atomic<int> polled{0};      // Armed ports epoll cannot watch
+  std::atomic<int> tx_pending{0};  // Ports with a TX flush deadline
+  std::atomic<bool> idle{false};   // Loop is waiting without a timeout
+  int wake_fd[2] = {-1, -1};
+#ifdef __linux__
+  int epfd = -1;
+#endif
+  std::vector<UartHandleData*> slots;
+  UartHandleData* stdin_owner = nullptr;  // The one STDIO port reading stdin
+};
+
+static UartLoop uart_loop;
+
+static void uart_loop_wake()
+{
+  uint8_t b = 0;
+  ssize_t r = write(uart_loop.wake_fd[1], &b, 1);
+  (void)r;  // Pipe full means a wakeup is already pending
+}
+
+static void set_nonblocking(int fd)
+{
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+}
+
+// Start watching fd for readability (loop lock held); returns 0 or errno
+static int uart_loop_watch(int fd, uint64_t tag)
+{
+#ifdef __linux__
+  struct epoll_event ev;
+  ev.events = EPOLLIN;
+  ev.data.u64 = tag;
+  return (epoll_ctl(uart_loop.epfd, EPOLL_CTL_ADD, fd, &ev) == 0) ? 0 : errno;
+#else
+  (void)fd;
+  (void)tag;
+  uart_loop_wake();  // poll() set is rebuilt from handle state
+  return 0;
+#endif
+}
+
+// Stop watching fd (loop lock held)
+static void uart_loop_unwatch(int fd)
+{
+#ifdef __linux__
+  epoll_ctl(uart_loop.epfd, EPOLL_CTL_DEL, fd, nullptr);
+#else
+  (void)fd;
+  uart_loop_wake();
+#endif
+}
+
+// Watch the RX fd. epoll refuses regular files (stdin redirected from a
+// file or /dev/null), which never block, so those are read on every loop
+// pass instead. Returns false if the fd cannot be watched at all.
+static bool uart_arm_rx(UartHandleData* h)
+{
+  if (h->rx_fd < 0 || h->rx_armed)
+    return true;
+
+  int err = uart_loop_watch(h->rx_fd, static_cast<uint64_t>(h->slot) << 1);
+  if (err == EPERM)
+  {
+    h->rx_polled = true;
+    if (uart_loop.polled++ == 0)
+      uart_loop_wake();  // The loop may be waiting without a timeout
+  }
+  else if (err != 0)
+  {
+    return false;
+  }
+  h->rx_armed = true;
+  return true;
+}
+
+static void uart_disarm_rx(UartHandleData* h)
+{
+  if (h->rx_armed)
+  {
+    if (h->rx_polled)
+    {
+      h->rx_polled = false;
+      uart_loop.polled--;
+    }
+    else
+    {
+      uart_loop_unwatch(h->rx_fd);
+    }
+    h->rx_armed = false;
+  }
+}
+
+static void uart_arm_listen(UartHandleData* h)
+{
+  if (h->listen_fd >= 0 && !h->listening)
+  {
+    uart_loop_watch(h->listen_fd, (static_cast<uint64_t>(h->slot) << 1) | kTagListen);
+    h->listening = true;
+  }
+}
+
+// SOCKET: drop the current client and wait for the next one (loop lock held)
+static void uart_drop_client(UartHandleData* h)
+{
+  uart_disarm_rx(h);
+  pthread_mutex_lock(&h->tx_lock);
+  close(h->rx_fd);
+  h->rx_fd = -1;
+  h->tx_fd = -1;
+  pthread_mutex_unlock(&h->tx_lock);
+  uart_arm_listen(h);
+}
+
+static void uart_service_accept(UartHandleData* h)
+{
+  int fd = accept(h->listen_fd, nullptr, nullptr);
+  if (fd < 0)
+    return;
+  set_nonblocking(fd);
+#ifdef SO_NOSIGPIPE
+  int one = 1;
+  setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+
+  // One client at a time: stop accepting until it disconnects
+  uart_loop_unwatch(h->listen_fd);
+  h->listening = false;
+
+  pthread_mutex_lock(&h->tx_lock);
+  h->rx_fd = fd;
+  h->tx_fd = fd;
+  pthread_mutex_unlock(&h->tx_lock);
+  uart_arm_rx(h);
+}
+
+static inline bool virtual_time_active();
+static void virtual_sleep_until(uint64_t deadline_us, const std::atomic<bool>* wake);
+static void virtual_notify();
+
+// Wake blocked readers after bytes were committed to the RX ring
+static void uart_rx_notify(UartHandleData* h)
+{
+  // Pairs with the fence in uart_read_timeout_impl: either the reader
+  // sees the new bytes or we see the reader
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (h->rx_waiters.load(std::memory_order_relaxed) != 0)
+  {
+    h->rx_ready.store(true, std::memory_order_release);
+    pthread_mutex_lock(&h->rx_lock);
+    pthread_cond_broadcast(&h->rx_cond);
+    pthread_mutex_unlock(&h->rx_lock);
+    virtual_notify();
+  }
+}
+
+static void uart_service_rx(UartHandleData* h)
+{
+  uint8_t* p;
+  size_t room = h->rx.write_span(&p);
+  if (room == 0)
+  {
+    // Ring full: stop watching until the consumer drains it
+    uart_disarm_rx(h);
+    h->rx_stalled.store(true, std::memory_order_release);
+    uart_loop.stalled++;
+    return;
+  }
+
+  ssize_t n = read(h->rx_fd, p, room);
+  if (n > 0)
+  {
+    h->rx.commit(static_cast<size_t>(n));
+    uart_rx_notify(h);
+  }
+  else if (n == 0 || (errno != EINTR && errno != EAGAIN))
+  {
+    // EOF or hard error on the source
+    if (h->backend == HAL_UART_BACKEND_SOCKET)
+      uart_drop_client(h);
+    else
+      uart_disarm_rx(h);
+  }
+}
+
+// Read the armed ports epoll cannot watch (loop lock held)
+static void uart_service_polled()
+{
+  for (UartHandleData* h : uart_loop.slots)
+  {
+    if (h && h->rx_armed && h->rx_polled)
+      uart_service_rx(h);
+  }
+}
+
+// Re-arm ports whose ring has space again (loop lock held)
+static void uart_retry_stalled()
+{
+  for (UartHandleData* h : uart_loop.slots)
+  {
+    uint8_t* p;
+    if (h && h->rx_stalled.load(std::memory_order_acquire) && h->rx.write_span(&p) != 0)
+    {
+      h->rx_stalled.store(false, std::memory_order_release);
+      uart_loop.stalled--;
+      uart_arm_rx(h);
+    }
+  }
+}
+
+/* ------------------------------------------------------------------------- */
+/* Transmit coalescing                                                       */
+/* ------------------------------------------------------------------------- */
+
+static uint64_t uart_now_ns()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+}
+
+// Write all iovecs to the fd, waiting briefly for space on non-blocking fds
+static ssize_t uart_writev_fd(int fd, bool is_socket, struct iovec* iov, int iovcnt)
+{
+  constexpr int kWriteTimeoutMs = 100;
+  size_t done = 0;
+
+  while (iovcnt > 0)
+  {
+#ifdef MSG_NOSIGNAL
+    // A disconnected peer must not raise SIGPIPE in the host process
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = iovcnt;
+    ssize_t n = is_socket ? sendmsg(fd, &msg, MSG_NOSIGNAL) : writev(fd, iov, iovcnt);
+#else
+    (void)is_socket;  // SO_NOSIGPIPE is set on accepted sockets instead
+    ssize_t n = writev(fd, iov, iovcnt);
+#endif
+    if (n > 0)
+    {
+      done += static_cast<size_t>(n);
+      while (iovcnt > 0 && static_cast<size_t>(n) >= iov->iov_len)
+      {
+        n -= static_cast<ssize_t>(iov->iov_len);
+        iov++;
+        iovcnt--;
+      }
+      if (iovcnt > 0)
+      {
+        iov->iov_base = static_cast<uint8_t*>(iov->iov_base) + n;
+        iov->iov_len -= static_cast<size_t>(n);
+      }
+      continue;
+    }
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n < 0 && errno == EAGAIN)
+    {
+      struct pollfd pfd = {fd, POLLOUT, 0};
+      if (poll(&pfd, 1, kWriteTimeoutMs) > 0)
+        continue;
+      return (done > 0) ? static_cast<ssize_t>(done) : ssize_t{HAL_ERR_TIMEOUT};
+    }
+    return (done > 0) ? static_cast<ssize_t>(done) : ssize_t{HAL_ERR_IO};
+  }
+  return static_cast<ssize_t>(done);
+}
+
+// Hand iovecs to the port's TX fd (tx_lock held)
+static ssize_t uart_tx_commit(UartHandleData* h, struct iovec* iov, int iovcnt)
+{
+  // Keep ordering with anything the application printed through stdio
+  if (h->backend == HAL_UART_BACKEND_STDIO)
+    fflush(stdout);
+  return uart_writev_fd(h->tx_fd, h->backend == HAL_UART_BACKEND_SOCKET, iov, iovcnt);
+}
+
+// Empty the TX buffer (tx_lock held)
+static void uart_tx_clear(UartHandleData* h)
+{
+  h->tx_len = 0;
+  if (h->tx_timed)
+  {
+    h->tx_timed = false;
+    uart_loop.tx_pending.fetch_sub(1);
+  }
+}
+
+// Start the latency deadline for freshly buffered data (tx_lock held)
+static void uart_tx_arm_deadline(UartHandleData* h)
+{
+  h->tx_timed = true;
+  h->tx_deadline = uart_now_ns() + h->tx_flush_ns;
+  uart_loop.tx_pending.fetch_add(1);
+
+  // The loop is sleeping without a timeout; make it pick up the deadline
+  if (uart_loop.idle.exchange(false))
+    uart_loop_wake();
+}
+
+// Write out buffered TX data (tx_lock held). Unsendable data is dropped.
+static int uart_tx_flush_locked(UartHandleData* h)
+{
+  if (h->tx_len == 0)
+    return HAL_OK;
+
+  ssize_t n = HAL_OK;
+  if (h->tx_fd >= 0)
+  {
+    struct iovec iov = {h->tx_buf, h->tx_len};
+    n = uart_tx_commit(h, &iov, 1);
+  }
+  uart_tx_clear(h);
+  return (n < 0) ? static_cast<int>(n) : HAL_OK;
+}
+
+// Flush buffers whose deadline passed; returns ms until the next deadline
+// or -1 if none is pending (loop lock held)
+static int uart_tx_flush_expired()
+{
+  uint64_t now = uart_now_ns();
+  uint64_t next = UINT64_MAX;
+
+  for (UartHandleData* h : uart_loop.slots)
+  {
+    if (!h)
+      continue;
+    if (pthread_mutex_trylock(&h->tx_lock) != 0)
+    {
+      next = (next < now + 1000000) ? next : now + 1000000;  // Writer active: retry
+      continue;
+    }
+    if (h->tx_timed)
+    {
+      if (now >= h->tx_deadline)
+        uart_tx_flush_locked(h);
+      else if (h->tx_deadline < next)
+        next = h->tx_deadline;
+    }
+    pthread_mutex_unlock(&h->tx_lock);
+  }
+
+  if (next == UINT64_MAX)
+    return -1;
+  return static_cast<int>((next - now + 999999) / 1000000);
+}
+
+static void uart_dispatch(uint64_t tag)
+{
+  if (tag == kTagWake)
+  {
+    uint8_t drain[64];
+    while (read(uart_loop.wake_fd[0], drain, sizeof(drain)) > 0)
+    {
+    }
+    return;
+  }
+
+  size_t slot = static_cast<size_t>(tag >> 1);
+  UartHandleData* h = slot < uart_loop.slots.size() ? uart_loop.slots[slot] : nullptr;
+  if (!h)
+    return;  // Port closed after the event was reported
+
+  if (tag & kTagListen)
+  {
+    if (h->listening)
+      uart_service_accept(h);
+  }
+  else if (h->rx_armed)
+  {
+    uart_service_rx(h);
+  }
+}
+
+static void* uart_loop_thread(void*)
+{
+  constexpr int kMaxEvents = 64;
+
+  while (uart_loop.running.load(std::memory_order_acquire))
+  {
+    // While any port is stalled, re-check periodically in case the
+    // consumer's wakeup raced with the stall being recorded.
+    int timeout = (uart_loop.stalled > 0) ? 10 : -1;
+    if (uart_loop.polled > 0)
+      timeout = 0;
+
+    if (uart_loop.tx_pending.load() > 0)
+    {
+      pthread_mutex_lock(&uart_loop.lock);
+      int due = uart_tx_flush_expired();
+      pthread_mutex_unlock(&uart_loop.lock);
+      if (due >= 0 && (timeout < 0 || due < timeout))
+        timeout = due;
+    }
+
+    if (timeout < 0)
+    {
+      // Writers check this flag after registering a deadline
+      uart_loop.idle.store(true);
+      if (uart_loop.tx_pending.load() > 0)
+        timeout = 0;
+    }
+
+#ifdef __linux__
+    struct epoll_event events[kMaxEvents];
+    int n = epoll_wait(uart_loop.epfd, events, kMaxEvents, timeout);
+    uart_loop.idle.store(false);
+
+    pthread_mutex_lock(&uart_loop.lock);
+    for (int i = 0; i < n; i++)
+    {
+      uart_dispatch(events[i].data.u64);
+    }
+#else
+    std::vector<struct pollfd> fds;
+    std::vector<uint64_t> tags;
+    pthread_mutex_lock(&uart_loop.lock);
+    fds.push_back({uart_loop.wake_fd[0], POLLIN, 0});
+    tags.push_back(kTagWake);
+    for (UartHandleData* h : uart_loop.slots)
+    {
+      if (h && h->rx_armed)
+      {
+        fds.push_back({h->rx_fd, POLLIN, 0});
+        tags.push_back(static_cast<uint64_t>(h->slot) << 1);
+      }
+      if (h && h->listening)
+      {
+        fds.push_back({h->listen_fd, POLLIN, 0});
+        tags.push_back((static_cast<uint64_t>(h->slot) << 1) | kTagListen);
+      }
+    }
+    pthread_mutex_unlock(&uart_loop.lock);
+
+    int n = poll(fds.data(), fds.size(), timeout);
+    uart_loop.idle.store(false);
+
+    pthread_mutex_lock(&uart_loop.lock);
+    for (size_t i = 0; n > 0 && i < fds.size(); i++)
+    {
+      if (fds[i].revents)
+        uart_dispatch(tags[i]);
+    }
+#endif
+    if (uart_loop.polled > 0)
+      uart_service_polled();
+    if (uart_loop.stalled > 0)
+      uart_retry_stalled();
+    pthread_mutex_unlock(&uart_loop.lock);
+  }
+  return nullptr;
+}
+
+/**
+ * stdin has one consumer at a time: the first STDIO port opened, in any
+ * context, until it closes and hands stdin to another STDIO port, or
+ * hal_console_read() while no STDIO port is open. The owner reads a
+ * private non-blocking open file description of stdin, so the event loop
+ * never blocks in read() and the application's stdin keeps its flags.
+ */
+static int uart_open_stdin()
+{
+#ifdef __linux__
+  // A new description, unlike dup(), whose O_NONBLOCK would be shared
+  int fd = open("/proc/self/fd/0", O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+  if (fd >= 0)
+  {
+    off_t pos = lseek(STDIN_FILENO, 0, SEEK_CUR);  // Regular files: resume here
+    if (pos > 0)
+      lseek(fd, pos, SEEK_SET);
+    return fd;
+  }
+#endif
+  return fcntl(STDIN_FILENO, F_DUPFD_CLOEXEC, 0);  // Only the owner reads it
+}
+
+static void uart_loop_detach(UartHandleData* h);
+
+// Register a handle with the loop, starting the thread for the first one
+static bool uart_loop_attach(UartHandleData* h)
+{
+  pthread_mutex_lock(&uart_loop.life_lock);
+
+  if (uart_loop.users == 0)
+  {
+    if (pipe(uart_loop.wake_fd) != 0)
+    {
+      pthread_mutex_unlock(&uart_loop.life_lock);
+      return false;
+    }
+    set_nonblocking(uart_loop.wake_fd[0]);
+    set_nonblocking(uart_loop.wake_fd[1]);
+#ifdef __linux__
+    uart_loop.epfd = epoll_create1(EPOLL_CLOEXEC);
+    uart_loop_watch(uart_loop.wake_fd[0], kTagWake);
+#endif
+    uart_loop.running.store(true, std::memory_order_release);
+    if (pthread_create(&uart_loop.thread, nullptr, uart_loop_thread, nullptr) != 0)
+    {
+#ifdef __linux__
+      close(uart_loop.epfd);
+#endif
+      close(uart_loop.wake_fd[0]);
+      close(uart_loop.wake_fd[1]);
+      pthread_mutex_unlock(&uart_loop.life_lock);
+      return false;
+    }
+  }
+  uart_loop.users++;
+
+  pthread_mutex_lock(&uart_loop.lock);
+  size_t slot = 0;
+  while (slot < uart_loop.slots.size() && uart_loop.slots[slot])
+    slot++;
+  if (slot == uart_loop.slots.size())
+    uart_loop.slots.push_back(nullptr);
+  uart_loop.slots[slot] = h;
+  h->slot = static_cast<uint32_t>(slot);
+  if (h->backend == HAL_UART_BACKEND_STDIO && !uart_loop.stdin_owner)
+  {
+    h->rx_fd = uart_open_stdin();
+    if (h->rx_fd >= 0)
+      uart_loop.stdin_owner = h;
+  }
+  bool armed = uart_arm_rx(h);
+  uart_arm_listen(h);
+  pthread_mutex_unlock(&uart_loop.lock);
+
+  pthread_mutex_unlock(&uart_loop.life_lock);
+  if (!armed)
+    uart_loop_detach(h);  // The port would open but never receive
+  return armed;
+}
+
+// Unregister a handle, stopping the thread after the last one
+static void uart_loop_detach(UartHandleData* h)
+{
+  pthread_mutex_lock(&uart_loop.life_lock);
+
+  pthread_mutex_lock(&uart_loop.lock);
+  uart_disarm_rx(h);
+  if (h->listening)
+  {
+    uart_loop_unwatch(h->listen_fd);
+    h->listening = false;
+  }
+  if (h->rx_stalled.load(std::memory_order_acquire))
+    uart_loop.stalled--;
+  uart_loop.slots[h->slot] = nullptr;
+  if (uart_loop.stdin_owner == h)
+  {
+    // Hand stdin to the next STDIO port, if any is still open
+    uart_loop.stdin_owner = nullptr;
+    for (UartHandleData* next : uart_loop.slots)
+    {
+      if (next && next->backend == HAL_UART_BACKEND_STDIO)
+      {
+        next->rx_fd = h->rx_fd;
+        h->rx_fd = -1;
+        uart_loop.stdin_owner = next;
+        uart_arm_rx(next);
+        break;
+      }
+    }
+  }
+  pthread_mutex_unlock(&uart_loop.lock);
+
+  if (--uart_loop.users == 0)
+  {
+    uart_loop.running.store(false, std::memory_order_release);
+    uart_loop_wake();
+    pthread_join(uart_loop.thread, nullptr);
+#ifdef __linux__
+    close(uart_loop.epfd);
+#endif
+    close(uart_loop.wake_fd[0]);
+    close(uart_loop.wake_fd[1]);
+    uart_loop.slots.clear();
+  }
+
+  pthread_mutex_unlock(&uart_loop.life_lock);
+}
+
+/* ------------------------------------------------------------------------- */
+/* Backends                                                                  */
+/* ------------------------------------------------------------------------- */
+
+static bool uart_copy_path(UartHandleData* h, const char* path, size_t reserve)
+{
+  if (!path || strlen(path) + reserve >= sizeof(h->path))
+    return false;
+  strcpy(h->path, path);
+  return true;
+}
+
+static bool uart_open_pty(UartHandleData* h, const char* path)
+{
+  int master = posix_openpt(O_RDWR | O_NOCTTY);
+  if (master < 0)
+    return false;
+
+  const char* slave = nullptr;
+  if (grantpt(master) != 0 || unlockpt(master) != 0 || !(slave = ptsname(master)))
+  {
+    close(master);
+    return false;
+  }
+
+  // Raw line discipline so bytes pass through untouched
+  struct termios tio;
+  if (tcgetattr(master, &tio) == 0)
+  {
+    cfmakeraw(&tio);
+    tcsetattr(master, TCSANOW, &tio);
+  }
+
+  h->hold_fd = open(slave, O_RDWR | O_NOCTTY);
+
+  if (path)
+  {
+    if (!uart_copy_path(h, path, 0))
+    {
+      close(h->hold_fd);
+      close(master);
+      return false;
+    }
+    unlink(path);
+    if (symlink(slave, path) == 0)
+      h->owned_paths |= kOwnPath;
+  }
+
+  set_nonblocking(master);
+  h->rx_fd = master;
+  h->tx_fd = master;
+  return true;
+}
+
+static bool uart_open_socket(UartHandleData* h, const char* path)
+{
+  if (!uart_copy_path(h, path, 0))
+    return false;
+
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0)
+    return false;
+
+  struct sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path, path);
+
+  unlink(path);  // Remove a stale socket from a previous run
+  if (bind(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0 ||
+      listen(fd, 1) != 0)
+  {
+    close(fd);
+    return false;
+  }
+
+  set_nonblocking(fd);
+  h->owned_paths |= kOwnPath;
+  h->listen_fd = fd;
+  return true;
+}
+
+static int uart_open_fifo_end(UartHandleData* h, const char* suffix, uint8_t own_bit)
+{
+  char name[sizeof(h->path) + 4];
+  snprintf(name, sizeof(name), "%s%s", h->path, suffix);
+  if (mkfifo(name, 0600) == 0)
+    h->owned_paths |= own_bit;
+  else if (errno != EEXIST)
+    return -1;
+
+  // O_RDWR keeps the FIFO open without a peer: no blocking open, no EOF
+  return open(name, O_RDWR | O_NONBLOCK);
+}
+
+static bool uart_open_fifo(UartHandleData* h, const char* path)
+{
+  if (!uart_copy_path(h, path, 3))
+    return false;
+
+  h->rx_fd = uart_open_fifo_end(h, ".rx", kOwnFifoRx);
+  h->tx_fd = uart_open_fifo_end(h, ".tx", kOwnFifoTx);
+  return h->rx_fd >= 0 && h->tx_fd >= 0;
+}
+
+static void uart_release(UartHandleData* h)
+{
+  if (h->rx_fd >= 0)
+    close(h->rx_fd);  // STDIO: the private stdin description
+  if (h->backend != HAL_UART_BACKEND_STDIO && h->tx_fd >= 0 && h->tx_fd != h->rx_fd)
+    close(h->tx_fd);
+  if (h->listen_fd >= 0)
+    close(h->listen_fd);
+  if (h->hold_fd >= 0)
+    close(h->hold_fd);
+
+  char name[sizeof(h->path) + 4];
+  if (h->owned_paths & kOwnPath)
+    unlink(h->path);
+  if (h->owned_paths & kOwnFifoRx)
+  {
+    snprintf(name, sizeof(name), "%s.rx", h->path);
+    unlink(name);
+  }
+  if (h->owned_paths & kOwnFifoTx)
+  {
+    snprintf(name, sizeof(name), "%s.tx", h->path);
+    unlink(name);
+  }
+
+  pthread_mutex_destroy(&h->tx_lock);
+  pthread_cond_destroy(&h->rx_cond);
+  pthread_mutex_destroy(&h->rx_lock);
+  delete h;
+}
+
+/* ------------------------------------------------------------------------- */
+/* UART Implementation                                                       */
+/* ------------------------------------------------------------------------- */
+
+// Make h its context's target for injected RX bytes (the latest open wins)
+static void uart_register_port(UartHandleData* h)
+{
+  h->ctx->refs.fetch_add(1, std::memory_order_relaxed);  // The opener's binding pins ctx
+  pthread_mutex_lock(&uart_loop.lock);
+  h->ctx->uart_ports[h->port] = h;
+  pthread_mutex_unlock(&uart_loop.lock);
+}
+
+/**
+ * Append bytes to the RX ring of the handle open on port in the calling
+ * thread's context, as if they had arrived on the wire. Runs under the
+ * loop lock, which the event loop also holds while it fills rings, so the
+ * ring keeps a single producer at a time. Bytes that find no open port
+ * or no ring space are lost, as in a hardware FIFO overrun.
+ *
+ * @return Number of bytes delivered
+ */
+static size_t uart_inject_rx(int port, const uint8_t* data, size_t len)
+{
+  if (port < 0 || port >= PosixPlatform::max_uart_ports())
+    return 0;
+
+  pthread_mutex_lock(&uart_loop.lock);
+  UartHandleData* h = context().uart_ports[port];
+  size_t n = h ? h->rx.push(data, len) : 0;
+  if (n)
+    uart_rx_notify(h);
+  pthread_mutex_unlock(&uart_loop.lock);
+  return n;
+}
+
+hal_handle_t PosixPlatform::uart_open_impl(int port, const hal_uart_config_t* config)
+{
+  auto* h = new UartHandleData();
+  h->ctx = &context();
+  h->port = port;
+  h->backend = config->backend;
+  h->rx_fd = -1;
+  h->tx_fd = -1;
+  h->listen_fd = -1;
+  h->hold_fd = -1;
+  h->rx_armed = false;
+  h->rx_polled = false;
+  h->listening = false;
+  h->owned_paths = 0;
+  h->path[0] = '\0';
+  pthread_mutex_init(&h->tx_lock, nullptr);
+  pthread_mutex_init(&h->rx_lock, nullptr);
+  pthread_condattr_t cond_attr;
+  pthread_condattr_init(&cond_attr);
+#ifndef __APPLE__
+  pthread_condattr_setclock(&cond_attr, kCondClock);
+#endif
+  pthread_cond_init(&h->rx_cond, &cond_attr);
+  pthread_condattr_destroy(&cond_attr);
+  h->tx_mode =
+      (config->tx_mode == HAL_UART_TX_DEFAULT) ? HAL_UART_TX_LINE : config->tx_mode;
+  h->tx_timed = false;
+  h->tx_flush_ns = 1000ULL * (config->tx_flush_us ? config->tx_flush_us
+                                                  : V4_HAL_POSIX_UART_TX_FLUSH_US);
+  h->tx_len = 0;
+
+  // Port 0 defaults to the console (stdout/stdin); others are unconnected
+  if (h->backend == HAL_UART_BACKEND_DEFAULT)
+    h->backend = (port == 0) ? HAL_UART_BACKEND_STDIO : HAL_UART_BACKEND_NONE;
+
+  bool ok = true;
+  switch (h->backend)
+  {
+    case HAL_UART_BACKEND_NONE:
+      uart_register_port(h);
+      return static_cast<hal_handle_t>(h);  // Nothing to service
+
+    case HAL_UART_BACKEND_STDIO:
+      h->tx_fd = STDOUT_FILENO;  // rx_fd is set if the loop gives it stdin
+      break;
+
+    case HAL_UART_BACKEND_PTY:
+      ok = uart_open_pty(h, config->path);
+      break;
+
+    case HAL_UART_BACKEND_SOCKET:
+      ok = uart_open_socket(h, config->path);
+      break;
+
+    case HAL_UART_BACKEND_FIFO:
+      ok = uart_open_fifo(h, config->path);
+      break;
+
+    default:
+      ok = false;
+      break;
+  }
+
+  if (!ok || !uart_loop_attach(h))
+  {
+    uart_release(h);
+    return nullptr;
+  }
+
+  if (h->backend != HAL_UART_BACKEND_STDIO && h->rx_fd >= 0)
+    set_nonblocking(h->rx_fd);
+  uart_register_port(h);
+  return static_cast<hal_handle_t>(h);
+}
+
+int PosixPlatform::uart_close_impl(hal_handle_t handle)
+{
+  auto* h = static_cast<UartHandleData*>(handle);
+  pthread_mutex_lock(&h->tx_lock);
+  uart_tx_flush_locked(h);
+  pthread_mutex_unlock(&h->tx_lock);
+
+  pthread_mutex_lock(&uart_loop.lock);
+  if (h->ctx->uart_ports[h->port] == h)
+    h->ctx->uart_ports[h->port] = nullptr;
+  pthread_mutex_unlock(&uart_loop.lock);
+  h->ctx->refs.fetch_sub(1, std::memory_order_release);  // Last use of h->ctx
+
+  if (h->backend != HAL_UART_BACKEND_NONE)
+    uart_loop_detach(h);
+  uart_release(h);
+  return HAL_OK;
+}
+
+// Send buffered bytes followed by the caller's segments (tx_lock held).
+// Returns the number of caller bytes sent.
+static ssize_t uart_tx_send(UartHandleData* h, const hal_iovec_t* iov, size_t iovcnt)
+{
+  constexpr size_t kMaxIov = 64;
+  struct iovec vec[kMaxIov];
+  size_t buffered = h->tx_len;
+  size_t sent = 0;
+  size_t i = 0;
+  bool first = true;
+
+  while (first || i < iovcnt)
+  {
+    size_t n = 0;
+    size_t expect = 0;
+    if (first && buffered > 0)
+    {
+      vec[n++] = {h->tx_buf, buffered};
+      expect += buffered;
+    }
+    while (i < iovcnt && n < kMaxIov)
+    {
+      vec[n++] = {iov[i].base, iov[i].len};
+      expect += iov[i].len;
+      i++;
+    }
+
+    ssize_t r = (n > 0) ? uart_tx_commit(h, vec, static_cast<int>(n)) : 0;
+    if (first)
+      uart_tx_clear(h);
+    if (r < 0)
+      return (sent > 0) ? static_cast<ssize_t>(sent) : r;
+
+    size_t done = static_cast<size_t>(r);
+    if (first)
+      done = (done > buffered) ? done - buffered : 0;
+    sent += done;
+    first = false;
+
+    if (static_cast<size_t>(r) < expect)
+      break;  // Device stopped accepting data
+  }
+  return static_cast<ssize_t>(sent);
+}
+
+int PosixPlatform::uart_write_impl(hal_handle_t handle, const uint8_t* buf, size_t len)
+{
+  hal_iovec_t iov = {const_cast<uint8_t*>(buf), len};
+  return uart_writev_impl(handle, &iov, 1);
+}
+
+int PosixPlatform::uart_writev_impl(hal_handle_t handle, const hal_iovec_t* iov,
+                                    size_t iovcnt)
+{
+  auto* h = static_cast<UartHandleData*>(handle);
+  size_t total = 0;
+  for (size_t i = 0; i < iovcnt; i++)
+    total += iov[i].len;
+  int ret = static_cast<int>(total);
+
+  pthread_mutex_lock(&h->tx_lock);
+  if (h->tx_fd < 0)
+  {
+    ret = 0;  // Unconnected: discard
+  }
+  else if (h->tx_mode != HAL_UART_TX_UNBUFFERED && h->tx_len + total < sizeof(h->tx_buf))
+  {
+    // Common case: coalesce into the TX buffer
+    bool newline = false;
+    for (size_t i = 0; i < iovcnt; i++)
+    {
+      memcpy(h->tx_buf + h->tx_len, iov[i].base, iov[i].len);
+      h->tx_len += iov[i].len;
+      if (h->tx_mode == HAL_UART_TX_LINE && memchr(iov[i].base, '\n', iov[i].len))
+        newline = true;
+    }
+
+    if (newline)
+    {
+      int err = uart_tx_flush_locked(h);
+      if (err < 0)
+        ret = err;
+    }
+    else if (!h->tx_timed && h->tx_len > 0)
+    {
+      uart_tx_arm_deadline(h);
+    }
+  }
+  else
+  {
+    // Buffer would overflow: buffered and new bytes go out in one writev
+    ssize_t n = uart_tx_send(h, iov, iovcnt);
+    ret = static_cast<int>(n);
+  }
+  pthread_mutex_unlock(&h->tx_lock);
+  return ret;
+}
+
+int PosixPlatform::uart_flush_impl(hal_handle_t handle)
+{
+  auto* h = static_cast<UartHandleData*>(handle);
+  pthread_mutex_lock(&h->tx_lock);
+  int ret = uart_tx_flush_locked(h);
+  pthread_mutex_unlock(&h->tx_lock);
+  return ret;
+}
+
+int PosixPlatform::uart_read_impl(hal_handle_t handle, uint8_t* buf, size_t len)
+{
+  auto* h = static_cast<UartHandleData*>(handle);
+  size_t n = h->rx.pop(buf, len);
+
+  // The loop stopped watching this port because the ring was full
+  if (n != 0 && h->rx_stalled.load(std::memory_order_acquire))
+    uart_loop_wake();
+
+  return static_cast<int>(n);
+}
+
+// Wait for the rest of len in virtual time, until the virtual deadline or
+// the clock leaves virtual time. Returns the new total.
+static size_t uart_read_virtual(UartHandleData* h, uint8_t* buf, size_t len, size_t total,
+                                uint32_t timeout_us)
+{
+  hal_handle_t handle = static_cast<hal_handle_t>(h);
+  uint64_t deadline = (timeout_us == HAL_UART_WAIT_FOREVER)
+                          ? UINT64_MAX
+                          : PosixPlatform::micros_impl() + timeout_us;
+
+  h->rx_waiters.fetch_add(1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  while (total < len && virtual_time_active())
+  {
+    // Consume the flag before looking at the ring, so bytes committed
+    // after this read set it again and end the next wait at once
+    h->rx_ready.exchange(false, std::memory_order_acquire);
+    size_t n = static_cast<size_t>(
+        PosixPlatform::uart_read_impl(handle, buf + total, len - total));
+    total += n;
+    if (n != 0)
+      continue;
+    if (PosixPlatform::micros_impl() >= deadline)
+      break;
+    virtual_sleep_until(deadline, &h->rx_ready);
+  }
+  h->rx_waiters.fetch_sub(1, std::memory_order_relaxed);
+  return total;
+}
+
+int PosixPlatform::uart_read_timeout_impl(hal_handle_t handle, uint8_t* buf, size_t len,
+                                          uint32_t timeout_us)
+{
+  auto* h = static_cast<UartHandleData*>(handle);
+  size_t total = static_cast<size_t>(uart_read_impl(handle, buf, len));
+  if (total == len || timeout_us == 0)
+    return static_cast<int>(total);
+
+  // A thread blocked here must not hold the virtual clock, so it waits
+  // as a participant; if the clock leaves virtual time meanwhile, the
+  // real-time wait below takes over
+  if (virtual_time_active())
+  {
+    total = uart_read_virtual(h, buf, len, total, timeout_us);
+    if (total == len || virtual_time_active())
+      return static_cast<int>(total);
+  }
+
+  const bool forever = (timeout_us == HAL_UART_WAIT_FOREVER);
+  struct timespec deadline = cond_deadline(forever ? 0 : timeout_us);
+
+  h->rx_waiters.fetch_add(1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  pthread_mutex_lock(&h->rx_lock);
+  while (total < len)
+  {
+    size_t n = static_cast<size_t>(uart_read_impl(handle, buf + total, len - total));
+    total += n;
+    if (n != 0)
+      continue;
+
+    int rc = forever ? pthread_cond_wait(&h->rx_cond, &h->rx_lock)
+                     : pthread_cond_timedwait(&h->rx_cond, &h->rx_lock, &deadline);
+    if (rc == ETIMEDOUT)
+    {
+      total += static_cast<size_t>(uart_read_impl(handle, buf + total, len - total));
+      break;
+    }
+  }
+  pthread_mutex_unlock(&h->rx_lock);
+  h->rx_waiters.fetch_sub(1, std::memory_order_relaxed);
+
+  return static_cast<int>(total);
+}
+
+int PosixPlatform::uart_readv_impl(hal_handle_t handle, const hal_iovec_t* iov,
+                                   size_t iovcnt)
+{
+  auto* h = static_cast<UartHandleData*>(handle);
+  size_t total = 0;
+  for (size_t i = 0; i < iovcnt; i++)
+  {
+    size_t n = h->rx.pop(static_cast<uint8_t*>(iov[i].base), iov[i].len);
+    total += n;
+    if (n < iov[i].len)
+      break;  // Ring drained
+  }
+
+  if (total != 0 && h->rx_stalled.load(std::memory_order_acquire))
+    uart_loop_wake();
+
+  return static_cast<int>(total);
+}
+
+int PosixPlatform::uart_rx_peek_impl(hal_handle_t handle, const uint8_t** data,
+                                     size_t* len)
+{
+  auto* h = static_cast<UartHandleData*>(handle);
+  *len = h->rx.peek(data);
+  return HAL_OK;
+}
+
+int PosixPlatform::uart_rx_consume_impl(hal_handle_t handle, size_t len)
+{
+  auto* h = static_cast<UartHandleData*>(handle);
+  if (len > h->rx.size())
+    return HAL_ERR_PARAM;
+  h->rx.consume(len);
+
+  if (h->rx_stalled.load(std::memory_order_acquire))
+    uart_loop_wake();
+
+  return HAL_OK;
+}
+
+int PosixPlatform::uart_available_impl(hal_handle_t handle)
+{
+  auto* h = static_cast<UartHandleData*>(handle);
+  return static_cast<int>(h->rx.size());
+}
+
+/* ========================================================================= */
+/* Timer Implementation                                                      */
+/* ========================================================================= */
+
+// Tick-granular clock read from the vDSO without touching the clocksource
+#if defined(CLOCK_MONOTONIC_COARSE)
+static constexpr clockid_t kCoarseClock = CLOCK_MONOTONIC_COARSE;
+#elif defined(CLOCK_MONOTONIC_RAW_APPROX)
+static constexpr clockid_t kCoarseClock = CLOCK_MONOTONIC_RAW_APPROX;
+#else
+static constexpr clockid_t kCoarseClock = CLOCK_MONOTONIC;
+#endif
+
+// Hardware rate without NTP frequency adjustment
+#if defined(CLOCK_MONOTONIC_RAW)
+static constexpr clockid_t kRawClock = CLOCK_MONOTONIC_RAW;
+#else
+static constexpr clockid_t kRawClock = CLOCK_MONOTONIC;
+#endif
+
+static uint64_t get_time_ns(clockid_t clock = CLOCK_MONOTONIC)
+{
+  struct timespec ts;
+  clock_gettime(clock, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+}
+
+// Every source counts from the same instant; clock_switch() then rebases
+// the new source so that switching never moves time backwards
+static const uint64_t start_time = get_time_ns();
+static const uint64_t start_coarse = get_time_ns(kCoarseClock);
+static const uint64_t start_raw = get_time_ns(kRawClock);
+
+static std::atomic<int> clock_source{HAL_CLOCK_MONOTONIC};
+static std::atomic<bool> clock_source_chosen{false};  // Set by hal_timer_set_source()
+
+// Per real source: how far it has to be moved forward to continue from
+// the readings of the sources used before it (including virtual time
+// skipped while in HAL_CLOCK_VIRTUAL). Only ever grows.
+static std::atomic<uint64_t> clock_lead_us[HAL_CLOCK_VIRTUAL] = {};
+
+#if V4_HAL_POSIX_TSC_CLOCK
+
+/**
+ * TSC fast clock. hal_init() measures the TSC rate against
+ * CLOCK_MONOTONIC once; after that millis/micros are one rdtsc, one
+ * subtraction and one 64x32 multiply-shift, with no syscall, vDSO call
+ * or division. It is only enabled when CPUID reports an invariant TSC
+ * (constant rate across P-/C-states); otherwise, and before hal_init(),
+ * the clock_gettime() path is used.
+ */
+__extension__ typedef unsigned __int128 TscWide;
+
+struct TscScale
+{
+  uint64_t mult;   // units = (ticks * mult) >> shift
+  unsigned shift;  // chosen so that mult < 2^32
+};
+
+struct TscClock
+{
+  std::atomic<bool> ready{false};
+  uint64_t origin = 0;  // TSC value at start_time
+  TscScale us = {};
+  TscScale ms = {};
+};
+
+static TscClock tsc_clock;
+static pthread_once_t tsc_once = PTHREAD_ONCE_INIT;
+
+static constexpr long kTscCalibrationNs = 10000000;  // 10 ms
+static constexpr uint64_t kTscMinHz = 100000000;     // Reject < 100 MHz
+
+static bool tsc_invariant()
+{
+  unsigned eax, ebx, ecx, edx;
+  if (!__get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx) || eax < 0x80000007)
+    return false;
+  __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx);
+  return (edx & (1u << 8)) != 0;  // Invariant TSC
+}
+
+// Pair a CLOCK_MONOTONIC reading with the TSC value taken at the same
+// moment, keeping the tightest of a few bracketed samples
+static void tsc_sample(uint64_t* tsc, uint64_t* ns)
+{
+  uint64_t best = UINT64_MAX;
+  for (int i = 0; i < 8; i++)
+  {
+    uint64_t t0 = __rdtsc();
+    uint64_t now = get_time_ns();
+    uint64_t t1 = __rdtsc();
+    if (t1 - t0 < best)
+    {
+      best = t1 - t0;
+      *tsc = t0 + (t1 - t0) / 2;
+      *ns = now;
+    }
+  }
+}
+
+static TscScale tsc_make_scale(uint64_t units_per_sec, uint64_t hz)
+{
+  TscScale s = {0, 63};
+  for (; s.shift > 0; s.shift--)
+  {
+    s.mult = static_cast<uint64_t>((static_cast<TscWide>(units_per_sec) << s.shift) / hz);
+    if (s.mult < (uint64_t{1} << 32))
+      break;
+  }
+  return s;
+}
+
+static inline uint64_t tsc_scale(uint64_t ticks, const TscScale& s)
+{
+  return static_cast<uint64_t>((static_cast<TscWide>(ticks) * s.mult) >> s.shift);
+}
+
+static void tsc_calibrate()
+{
+  if (!tsc_invariant())
+    return;
+
+  uint64_t tsc0, ns0, tsc1, ns1;
+  tsc_sample(&tsc0, &ns0);
+  struct timespec pause = {0, kTscCalibrationNs};
+  while (nanosleep(&pause, &pause) != 0 && errno == EINTR)
+  {
+  }
+  tsc_sample(&tsc1, &ns1);
+  if (tsc1 <= tsc0 || ns1 <= ns0)
+    return;
+
+  uint64_t hz = static_cast<uint64_t>(static_cast<TscWide>(tsc1 - tsc0) * 1000000000u /
+                                      (ns1 - ns0));
+  if (hz < kTscMinHz)
+    return;
+
+  uint64_t elapsed = static_cast<uint64_t>(static_cast<TscWide>(ns1 - start_time) * hz /
+                                           1000000000u);
+  if (elapsed > tsc1)
+    return;
+
+  tsc_clock.origin = tsc1 - elapsed;
+  tsc_clock.us = tsc_make_scale(1000000, hz);
+  tsc_clock.ms = tsc_make_scale(1000, hz);
+  tsc_clock.ready.store(true, std::memory_order_release);
+}
+
+#endif  // V4_HAL_POSIX_TSC_CLOCK
+
+/* ------------------------------------------------------------------------- */
+/* Virtual Time                                                              */
+/* ------------------------------------------------------------------------- */
+
+/**
+ * HAL_CLOCK_VIRTUAL turns millis/micros into a simulated counter that
+ * delays advance instead of sleeping, so time-heavy programs run at CPU
+ * speed. It works like a discrete-event simulator: every thread that has
+ * delayed in virtual time is a participant, and the counter jumps to the
+ * earliest pending deadline once all participants are waiting and none
+ * of them is already due. Wake-ups therefore happen in deadline order no
+ * matter how long the threads compute in between.
+ *
+ * A participant that blocks outside a HAL delay would hold the clock
+ * forever, so a waiter that sees no progress for virtual_stall_us() of
+ * real time advances without it. Participants leave when their thread
+ * exits or calls hal_sim_time_detach(); hal_sim_time_attach() joins a
+ * thread before its first delay.
+ */
+struct VirtualWaiter
+{
+  uint64_t deadline;
+  const std::atomic<bool>* wake;  // Ends the wait early when set (may be null)
+  VirtualWaiter* next;
+};
+
+struct VirtualClock
+{
+  pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+  pthread_cond_t cond;
+  std::atomic<uint64_t> now_us{0};
+  uint64_t epoch = 0;  // Bumped on every advance
+  int participants = 0;
+  int waiting = 0;
+  VirtualWaiter* waiters = nullptr;
+};
+
+static VirtualClock virtual_clock;
+static pthread_once_t virtual_once = PTHREAD_ONCE_INIT;
+
+static void virtual_clock_init()
+{
+  pthread_condattr_t cond_attr;
+  pthread_condattr_init(&cond_attr);
+#ifndef __APPLE__
+  pthread_condattr_setclock(&cond_attr, kCondClock);
+#endif
+  pthread_cond_init(&virtual_clock.cond, &cond_attr);
+  pthread_condattr_destroy(&cond_attr);
+}
+
+static inline bool virtual_time_active()
+{
+  return clock_source.load(std::memory_order_acquire) == HAL_CLOCK_VIRTUAL;
+}
+
+static inline bool virtual_waiter_ready(const VirtualWaiter* w, uint64_t now)
+{
+  return w->deadline <= now || (w->wake && w->wake->load(std::memory_order_acquire));
+}
+
+/**
+ * Jump to the earliest deadline if every waiter needs time to move and,
+ * unless forced, every participant is waiting. Called with the lock held.
+ */
+static void virtual_advance_locked(bool force)
+{
+  if (!force && virtual_clock.waiting < virtual_clock.participants)
+    return;
+
+  uint64_t now = virtual_clock.now_us.load(std::memory_order_relaxed);
+  uint64_t earliest = UINT64_MAX;
+  for (VirtualWaiter* w = virtual_clock.waiters; w; w = w->next)
+  {
+    if (virtual_waiter_ready(w, now))
+      return;  // Must run before time moves on
+    if (w->deadline < earliest)
+      earliest = w->deadline;
+  }
+  if (earliest == UINT64_MAX)
+    return;
+
+  virtual_clock.now_us.store(earliest, std::memory_order_release);
+  virtual_clock.epoch++;
+  pthread_cond_broadcast(&virtual_clock.cond);
+}
+
+struct VirtualParticipant
+{
+  bool joined = false;
+
+  // Called with the lock held
+  void join_locked()
+  {
+    if (joined)
+      return;
+    joined = true;
+    virtual_clock.participants++;
+  }
+
+  void leave()
+  {
+    if (!joined)
+      return;
+    pthread_mutex_lock(&virtual_clock.lock);
+    joined = false;
+    virtual_clock.participants--;
+    virtual_advance_locked(false);
+    pthread_mutex_unlock(&virtual_clock.lock);
+  }
+
+  ~VirtualParticipant()
+  {
+    leave();
+  }
+};
+
+static thread_local VirtualParticipant virtual_self;
+
+/**
+ * Wait until the virtual clock reaches deadline_us or *wake is set.
+ * Returns early if the clock leaves virtual time.
+ */
+static void virtual_sleep_until(uint64_t deadline_us, const std::atomic<bool>* wake)
+{
+  pthread_mutex_lock(&virtual_clock.lock);
+  virtual_self.join_locked();
+
+  VirtualWaiter self = {deadline_us, wake, virtual_clock.waiters};
+  virtual_clock.waiters = &self;
+  virtual_clock.waiting++;
+  virtual_advance_locked(false);
+
+  // now_us only changes under the lock
+  while (virtual_time_active() &&
+         !virtual_waiter_ready(&self,
+                               virtual_clock.now_us.load(std::memory_order_relaxed)))
+  {
+    uint64_t epoch = virtual_clock.epoch;
+    struct timespec ts = cond_deadline(PosixPlatform::virtual_stall_us());
+    int rc = pthread_cond_timedwait(&virtual_clock.cond, &virtual_clock.lock, &ts);
+    if (rc == ETIMEDOUT && epoch == virtual_clock.epoch)
+    {
+      virtual_advance_locked(true);  // A participant is blocked elsewhere
+    }
+  }
+
+  VirtualWaiter** link = &virtual_clock.waiters;
+  while (*link != &self)
+    link = &(*link)->next;
+  *link = self.next;
+  virtual_clock.waiting--;
+  pthread_mutex_unlock(&virtual_clock.lock);
+}
+
+// Wake virtual-time waiters to re-check their wake flags
+static void virtual_notify()
+{
+  if (!virtual_time_active())
+    return;
+  pthread_mutex_lock(&virtual_clock.lock);
+  pthread_cond_broadcast(&virtual_clock.cond);
+  pthread_mutex_unlock(&virtual_clock.lock);
+}
+
+/* ------------------------------------------------------------------------- */
+/* Clock Sources                                                             */
+/* ------------------------------------------------------------------------- */
+
+static inline uint64_t clock_lead(int source)
+{
+  return clock_lead_us[source].load(std::memory_order_relaxed);
+}
+
+static uint32_t clock_millis(int source)
+{
+  switch (source)
+  {
+    case HAL_CLOCK_VIRTUAL:
+      return static_cast<uint32_t>(virtual_clock.now_us.load(std::memory_order_acquire) /
+                                   1000);
+#if V4_HAL_POSIX_TSC_CLOCK
+    case HAL_CLOCK_TSC:
+      return static_cast<uint32_t>(tsc_scale(__rdtsc() - tsc_clock.origin, tsc_clock.ms) +
+                                   clock_lead(HAL_CLOCK_TSC) / 1000);
+#endif
+    case HAL_CLOCK_COARSE:
+      return static_cast<uint32_t>((get_time_ns(kCoarseClock) - start_coarse) / 1000000 +
+                                   clock_lead(HAL_CLOCK_COARSE) / 1000);
+    case HAL_CLOCK_RAW:
+      return static_cast<uint32_t>((get_time_ns(kRawClock) - start_raw) / 1000000 +
+                                   clock_lead(HAL_CLOCK_RAW) / 1000);
+    default:
+      return static_cast<uint32_t>((get_time_ns() - start_time) / 1000000 +
+                                   clock_lead(source) / 1000);
+  }
+}
+
+static uint64_t clock_micros(int source)
+{
+  switch (source)
+  {
+    case HAL_CLOCK_VIRTUAL:
+      return virtual_clock.now_us.load(std::memory_order_acquire);
+#if V4_HAL_POSIX_TSC_CLOCK
+    case HAL_CLOCK_TSC:
+      return tsc_scale(__rdtsc() - tsc_clock.origin, tsc_clock.us) +
+             clock_lead(HAL_CLOCK_TSC);
+#endif
+    case HAL_CLOCK_RAW:
+      return (get_time_ns(kRawClock) - start_raw) / 1000 + clock_lead(HAL_CLOCK_RAW);
+    default:  // COARSE only applies to millis
+      return (get_time_ns() - start_time) / 1000 + clock_lead(source);
+  }
+}
+
+static void timer_driver_wake();
+
+/**
+ * Move real source `to` forward so that it continues from the current
+ * readings of `from`. It is sampled first, so the lead errs forward.
+ */
+static void clock_rebase(int from, int to)
+{
+  uint64_t to_us = clock_micros(to);
+  uint32_t to_ms = clock_millis(to);
+  uint64_t from_us = clock_micros(from);
+  uint32_t from_ms = clock_millis(from);
+
+  uint64_t lead = (from_us > to_us) ? from_us - to_us : 0;
+  auto lag_ms = static_cast<int32_t>(from_ms - to_ms);  // COARSE millis trail micros
+  if (lag_ms > 0 && static_cast<uint64_t>(lag_ms) * 1000 > lead)
+    lead = static_cast<uint64_t>(lag_ms) * 1000;
+  if (lead)
+    clock_lead_us[to].fetch_add(lead, std::memory_order_relaxed);
+}
+
+/**
+ * Switch sources, continuing from the old source's reading so that time
+ * never steps backwards. Threads still waiting in virtual time return
+ * when it is left.
+ */
+static void clock_switch(int source)
+{
+  int previous = clock_source.load(std::memory_order_acquire);
+  if (source == previous)
+    return;
+
+  if (source == HAL_CLOCK_VIRTUAL)
+  {
+    pthread_once(&virtual_once, virtual_clock_init);
+    virtual_clock.now_us.store(clock_micros(previous), std::memory_order_release);
+    clock_source.store(source, std::memory_order_release);
+    timer_driver_wake();  // Move the software timer driver onto virtual time
+    return;
+  }
+
+  clock_rebase(previous, source);
+  if (previous == HAL_CLOCK_VIRTUAL)
+  {
+    pthread_mutex_lock(&virtual_clock.lock);
+    clock_source.store(source, std::memory_order_release);
+    pthread_cond_broadcast(&virtual_clock.cond);
+    pthread_mutex_unlock(&virtual_clock.lock);
+    return;
+  }
+
+  clock_source.store(source, std::memory_order_release);
+}
+
+/**
+ * Called from hal_init(): picks virtual time when built with
+ * V4_HAL_POSIX_VIRTUAL_TIME, otherwise calibrates the TSC and makes it
+ * the default source, unless the application already picked one.
+ */
+static void clock_init()
+{
+#if V4_HAL_POSIX_VIRTUAL_TIME
+  if (!clock_source_chosen.load(std::memory_order_relaxed))
+    clock_switch(HAL_CLOCK_VIRTUAL);
+#elif V4_HAL_POSIX_TSC_CLOCK
+  pthread_once(&tsc_once, tsc_calibrate);
+  if (tsc_clock.ready.load(std::memory_order_acquire) &&
+      !clock_source_chosen.load(std::memory_order_relaxed))
+  {
+    // Rebasing before the exchange at worst moves an already selected
+    // TSC source forward, never backward
+    clock_rebase(HAL_CLOCK_MONOTONIC, HAL_CLOCK_TSC);
+    int expected = HAL_CLOCK_MONOTONIC;
+    clock_source.compare_exchange_strong(expected, HAL_CLOCK_TSC,
+                                         std::memory_order_release);
+  }
+#endif
+}
+
+uint32_t PosixPlatform::millis_impl()
+{
+  return clock_millis(clock_source.load(std::memory_order_acquire));
+}
+
+uint64_t PosixPlatform::micros_impl()
+{
+  return clock_micros(clock_source.load(std::memory_order_acquire));
+}
+
+int PosixPlatform::timer_set_source_impl(hal_clock_source_t source)
+{
+  if (source == HAL_CLOCK_TSC)
+  {
+#if V4_HAL_POSIX_TSC_CLOCK
+    pthread_once(&tsc_once, tsc_calibrate);
+    if (!tsc_clock.ready.load(std::memory_order_acquire))
+      return HAL_ERR_NOTSUP;
+#else
+    return HAL_ERR_NOTSUP;
+#endif
+  }
+
+  clock_source_chosen.store(true, std::memory_order_relaxed);
+  clock_switch(source);
+  return HAL_OK;
+}
+
+hal_clock_source_t PosixPlatform::timer_get_source_impl()
+{
+  return static_cast<hal_clock_source_t>(clock_source.load(std::memory_order_acquire));
+}
+
+static inline void cpu_relax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  __asm__ __volatile__("yield");
+#endif
+}
+
+// Sleep until CLOCK_MONOTONIC reaches abs_ns
+static void sleep_until_ns(uint64_t abs_ns)
+{
+#ifdef __APPLE__
+  // No clock_nanosleep(): sleep the remaining interval, re-armed on EINTR
+  for (uint64_t now = get_time_ns(); now < abs_ns; now = get_time_ns())
+  {
+    struct timespec rel = {static_cast<time_t>((abs_ns - now) / 1000000000ULL),
+                           static_cast<long>((abs_ns - now) % 1000000000ULL)};
+    nanosleep(&rel, nullptr);
+  }
+#else
+  struct timespec ts = {static_cast<time_t>(abs_ns / 1000000000ULL),
+                        static_cast<long>(abs_ns % 1000000000ULL)};
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR)
+  {
+  }
+#endif
+}
+
+/**
+ * Hybrid delay: sleep on an absolute CLOCK_MONOTONIC deadline until
+ * spin_us before deadline_us, then busy-wait the rest on micros_impl().
+ * The absolute sleep is immune to EINTR drift, and the spin absorbs the
+ * kernel's timer slack (typically 50 us on Linux) that makes a plain
+ * sleep overshoot.
+ */
+static void delay_until(uint64_t deadline_us, uint32_t spin_us)
+{
+  if (virtual_time_active())
+  {
+    virtual_sleep_until(deadline_us, nullptr);
+    return;
+  }
+
+  uint64_t now = PosixPlatform::micros_impl();
+  if (now >= deadline_us)
+    return;
+
+  uint64_t remaining = deadline_us - now;
+  if (remaining > spin_us)
+    sleep_until_ns(get_time_ns() + (remaining - spin_us) * 1000);
+
+  if (spin_us)
+  {
+    while (PosixPlatform::micros_impl() < deadline_us)
+      cpu_relax();
+  }
+}
+
+void PosixPlatform::delay_ms_impl(uint32_t ms)
+{
+  delay_until(micros_impl() + uint64_t{ms} * 1000, 0);
+}
+
+void PosixPlatform::delay_us_impl(uint32_t us)
+{
+  delay_until(micros_impl() + us, delay_spin_us());
+}
+
+void PosixPlatform::delay_us_precise_impl(uint32_t us, uint32_t spin_us)
+{
+  delay_until(micros_impl() + us, spin_us);
+}
+
+void PosixPlatform::delay_until_us_impl(uint64_t deadline_us)
+{
+  delay_until(deadline_us, delay_spin_us());
+}
+
+/* ------------------------------------------------------------------------- */
+/* Software Timer Driver                                                     */
+/* ------------------------------------------------------------------------- */
+
+/**
+ * One thread runs the software timer service. It sleeps until the
+ * deadline the service returned, or until timer_service_kick_impl()
+ * reports an earlier timer; a kick always forces one more service pass,
+ * so a kick racing with the service's own re-arm is never lost. In
+ * virtual time the thread waits as a virtual-time participant instead.
+ */
+struct TimerDriver
+{
+  pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+  pthread_cond_t cond;
+  bool cond_ready = false;                       // cond is initialized, never destroyed
+  std::atomic<uint64_t (*)()> service{nullptr};  // Published once the cond is ready
+  std::atomic<bool> kicked{false};
+};
+
+static TimerDriver timer_driver;
+
+// Real-time wait for deadline, a kick or a switch to virtual time
+static void timer_driver_wait(uint64_t deadline)
+{
+  pthread_mutex_lock(&timer_driver.lock);
+  while (!timer_driver.kicked.load(std::memory_order_relaxed) && !virtual_time_active())
+  {
+    uint64_t now = PosixPlatform::micros_impl();
+    if (deadline <= now)
+      break;
+    if (deadline == UINT64_MAX)
+    {
+      pthread_cond_wait(&timer_driver.cond, &timer_driver.lock);
+    }
+    else
+    {
+      struct timespec ts = cond_deadline(deadline - now);
+      pthread_cond_timedwait(&timer_driver.cond, &timer_driver.lock, &ts);
+    }
+  }
+  pthread_mutex_unlock(&timer_driver.lock);
+}
+
+static void* timer_driver_thread(void*)
+{
+  uint64_t deadline = UINT64_MAX;
+  for (;;)
+  {
+    if (virtual_time_active())
+      virtual_sleep_until(deadline, &timer_driver.kicked);
+    else
+      timer_driver_wait(deadline);
+
+    timer_driver.kicked.store(false, std::memory_order_relaxed);
+    deadline = timer_driver.service.load(std::memory_order_acquire)();
+  }
+  return nullptr;
+}
+
+// Interrupt the driver's current wait, if the driver is running
+static void timer_driver_wake()
+{
+  if (timer_driver.service.load(std::memory_order_acquire))
+    PosixPlatform::timer_service_kick_impl();
+}
+
+int PosixPlatform::timer_service_start_impl(uint64_t (*service)())
+{
+  // Called once at a time by the timer layer. The cond outlives a failed
+  // start, since a clock switch may be signalling it concurrently.
+  if (!timer_driver.cond_ready)
+  {
+    pthread_condattr_t cond_attr;
+    pthread_condattr_init(&cond_attr);
+#ifndef __APPLE__
+    pthread_condattr_setclock(&cond_attr, kCondClock);
+#endif
+    pthread_cond_init(&timer_driver.cond, &cond_attr);
+    pthread_condattr_destroy(&cond_attr);
+    timer_driver.cond_ready = true;
+  }
+  timer_driver.service.store(service, std::memory_order_release);
+
+  pthread_t thread;
+  if (pthread_create(&thread, nullptr, timer_driver_thread, nullptr) != 0)
+  {
+    timer_driver.service.store(nullptr, std::memory_order_release);
+    return HAL_ERR_NOMEM;
+  }
+  pthread_detach(thread);
+  return HAL_OK;
+}
+
+void PosixPlatform::timer_service_kick_impl()
+{
+  pthread_mutex_lock(&timer_driver.lock);
+  timer_driver.kicked.store(true, std::memory_order_relaxed);
+  pthread_cond_signal(&timer_driver.cond);
+  pthread_mutex_unlock(&timer_driver.lock);
+  virtual_notify();
+}
+
+/* ========================================================================= */
+/* Stimulus Replay                                                           */
+/* ========================================================================= */
+
+/**
+ * hal_sim_stimulus_start() replays a stimulus file from a thread of its
+ * own. The file is read through a read-only mmap window of kTraceWindow
+ * bytes that slides forward as records are consumed, so memory use does
+ * not depend on the file size. Each record is applied when micros_impl()
+ * reaches its time: pin levels go through gpio_set_level(), so the
+ * interrupt engine and the recorder see them like any other change, and
+ * UART bytes land in the port's RX ring. In virtual time the replay
+ * thread waits as a virtual-time participant, so events fire at their
+ * exact time. The replay drives the context that started it.
+ */
+enum : uint8_t
+{
+  kStimulusUart = 2,  // "V4SI" kind: port << 2 | 2, varint length, bytes
+};
+
+struct StimulusFile
+{
+  int fd = -1;
+  uint64_t size = 0;
+  const uint8_t* map = nullptr;  // Window of map_len bytes at map_off
+  uint64_t map_off = 0;
+  size_t map_len = 0;
+  uint64_t pos = 0;  // Read position in the file
+};
+
+struct StimulusEngine
+{
+  pthread_mutex_t control = PTHREAD_MUTEX_INITIALIZER;  // Serializes start/stop
+  pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;     // Pairs with cond
+  pthread_cond_t cond;  // Signalled on stop and when the replay ends
+  bool cond_ready = false;
+  bool running = false;  // Started and not yet stopped (control)
+  bool exit_hook = false;
+  pthread_t thread;
+  std::atomic<bool> stopping{false};
+  bool attached = false;  // Replay thread is past its virtual-time join (lock)
+  bool done = false;      // Replay reached the end of the file (lock)
+  bool recorded = false;  // "V4GT" recording: kinds 2 and 3 are directions
+  PosixContext* ctx = nullptr;  // Context the replay drives
+  int status = HAL_OK;
+  uint64_t base_us = 0;  // micros_impl() time of file time 0
+  StimulusFile file;
+  hal_sim_stimulus_stats_t stats;
+};
+
+static StimulusEngine stimulus;
+
+/**
+ * Make at least want bytes at the read position visible (fewer at the
+ * end of the file) and return a pointer to them.
+ *
+ * @param avail Receives the number of bytes mapped from the read position
+ * @return Pointer to the read position, or nullptr if the file cannot be
+ *         mapped
+ */
+static const uint8_t* stimulus_window(StimulusFile& f, size_t want, size_t* avail)
+{
+  uint64_t end = f.map_off + f.map_len;
+  if (!f.map || (f.pos + want > end && end < f.size) || f.pos >= end)
+  {
+    if (f.map)
+      munmap(const_cast<uint8_t*>(f.map), f.map_len);
+    f.map = nullptr;
+
+    static const uint64_t kPage = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+    uint64_t off = f.pos - f.pos % kPage;
+    size_t len = static_cast<size_t>(std::min<uint64_t>(kTraceWindow, f.size - off));
+    void* p = mmap(nullptr, len, PROT_READ, MAP_SHARED, f.fd, static_cast<off_t>(off));
+    if (p == MAP_FAILED)
+      return nullptr;
+    madvise(p, len, MADV_SEQUENTIAL);
+    f.map = static_cast<const uint8_t*>(p);
+    f.map_off = off;
+    f.map_len = len;
+  }
+  *avail = static_cast<size_t>(f.map_off + f.map_len - f.pos);
+  return f.map + (f.pos - f.map_off);
+}
+
+// Read one varint at the read position; false if truncated or unmappable
+static bool stimulus_varint(StimulusFile& f, uint64_t* value)
+{
+  size_t avail;
+  const uint8_t* p = stimulus_window(f, kVarintMaxBytes, &avail);
+  size_t n = p ? varint_decode(p, avail, value) : 0;
+  f.pos += n;
+  return n != 0;
+}
+
+/**
+ * Sleep until micros_impl() reaches deadline_us.
+ *
+ * @return false if the replay is being stopped
+ */
+static bool stimulus_sleep_until(uint64_t deadline_us)
+{
+  while (!stimulus.stopping.load(std::memory_order_acquire))
+  {
+    uint64_t now = PosixPlatform::micros_impl();
+    if (now >= deadline_us)
+      return true;
+
+    if (virtual_time_active())
+    {
+      virtual_sleep_until(deadline_us, &stimulus.stopping);
+      continue;
+    }
+
+    // Sleep to spin_us before the deadline, then spin off the timer slack
+    uint64_t remaining = deadline_us - now;
+    if (remaining <= PosixPlatform::delay_spin_us())
+    {
+      cpu_relax();
+      continue;
+    }
+    struct timespec ts = cond_deadline(remaining - PosixPlatform::delay_spin_us());
+    pthread_mutex_lock(&stimulus.lock);
+    if (!stimulus.stopping.load(std::memory_order_relaxed))
+      pthread_cond_timedwait(&stimulus.cond, &stimulus.lock, &ts);
+    pthread_mutex_unlock(&stimulus.lock);
+  }
+  return false;
+}
+
+// Deliver a UART record's payload in window-sized pieces
+static bool stimulus_uart(StimulusFile& f, int port, uint64_t len)
+{
+  if (len > f.size - f.pos)
+    return false;
+
+  while (len)
+  {
+    size_t avail;
+    const uint8_t* p = stimulus_window(f, 1, &avail);
+    if (!p)
+      return false;
+    size_t n = static_cast<size_t>(std::min<uint64_t>(len, avail));
+    size_t delivered = uart_inject_rx(port, p, n);
+    stimulus.stats.uart_bytes += delivered;
+    stimulus.stats.dropped += n - delivered;
+    f.pos += n;
+    len -= n;
+  }
+  return true;
+}
+
+static void stimulus_gpio(int pin, uint8_t kind)
+{
+  PosixContext& c = *stimulus.ctx;
+  if (pin >= PosixPlatform::max_gpio_pins() || c.gpio_modes.test(pin))
+  {
+    stimulus.stats.ignored++;  // Absent pin, or driven by the firmware
+    return;
+  }
+  gpio_set_level(c, pin, kind == kTraceHigh ? HAL_GPIO_HIGH : HAL_GPIO_LOW);
+  stimulus.stats.gpio_events++;
+}
+
+static void* stimulus_thread(void*)
+{
+  StimulusFile& f = stimulus.file;
+  uint64_t rel_us = 0;
+  int status = HAL_OK;
+  if (stimulus.ctx != &default_context)
+    bound_context = stimulus.ctx;
+
+  // Join virtual time before start returns, so the clock cannot move past
+  // the first events while this thread is still starting up
+  pthread_mutex_lock(&virtual_clock.lock);
+  if (virtual_time_active())
+    virtual_self.join_locked();
+  pthread_mutex_unlock(&virtual_clock.lock);
+  pthread_mutex_lock(&stimulus.lock);
+  stimulus.attached = true;
+  pthread_cond_broadcast(&stimulus.cond);
+  pthread_mutex_unlock(&stimulus.lock);
+
+  while (f.pos < f.size)
+  {
+    uint64_t delta;
+    uint64_t code;
+    if (!stimulus_varint(f, &delta) || !stimulus_varint(f, &code))
+    {
+      status = HAL_ERR_IO;
+      break;
+    }
+    rel_us += delta;
+
+    uint64_t len = 0;
+    uint8_t kind = static_cast<uint8_t>(code & 3);
+    bool uart = !stimulus.recorded && kind == kStimulusUart;
+    if (!stimulus.recorded && kind > kStimulusUart)
+    {
+      status = HAL_ERR_IO;  // Reserved kind
+      break;
+    }
+    if (uart && !stimulus_varint(f, &len))
+    {
+      status = HAL_ERR_IO;
+      break;
+    }
+
+    uint64_t deadline = stimulus.base_us + rel_us;
+    if (!stimulus_sleep_until(deadline))
+      break;
+    uint64_t late = PosixPlatform::micros_impl() - deadline;
+    if (late > stimulus.stats.max_late_us)
+      stimulus.stats.max_late_us = late;
+
+    uint64_t target = code >> 2;
+    if (uart)
+    {
+      int port = target < static_cast<uint64_t>(PosixPlatform::max_uart_ports())
+                     ? static_cast<int>(target)
+                     : -1;
+      if (!stimulus_uart(f, port, len))
+      {
+        status = HAL_ERR_IO;
+        break;
+      }
+    }
+    else if (kind <= kTraceHigh)
+    {
+      stimulus_gpio(static_cast<int>(std::min<uint64_t>(target, INT32_MAX)), kind);
+    }
+  }
+
+  pthread_mutex_lock(&stimulus.lock);
+  stimulus.status = status;
+  stimulus.done = true;
+  pthread_cond_broadcast(&stimulus.cond);
+  pthread_mutex_unlock(&stimulus.lock);
+  return nullptr;
+}
+
+static void stimulus_close_file()
+{
+  StimulusFile& f = stimulus.file;
+  if (f.map)
+    munmap(const_cast<uint8_t*>(f.map), f.map_len);
+  if (f.fd >= 0)
+    close(f.fd);
+  f = StimulusFile();
+}
+
+// Called with stimulus.control held
+static int stimulus_stop_locked(hal_sim_stimulus_stats_t* stats)
+{
+  if (!stimulus.running)
+    return HAL_ERR_PARAM;
+
+  pthread_mutex_lock(&stimulus.lock);
+  stimulus.stopping.store(true, std::memory_order_release);
+  pthread_cond_broadcast(&stimulus.cond);
+  pthread_mutex_unlock(&stimulus.lock);
+  virtual_notify();
+  pthread_join(stimulus.thread, nullptr);
+
+  stimulus_close_file();
+  stimulus.running = false;
+  if (stats)
+    *stats = stimulus.stats;
+  return stimulus.status;
+}
+
+static void stimulus_at_exit()
+{
+  pthread_mutex_lock(&stimulus.control);
+  stimulus_stop_locked(nullptr);
+  pthread_mutex_unlock(&stimulus.control);
+}
+
+// Called with stimulus.control held
+static int stimulus_start_locked(const char* path)
+{
+  if (stimulus.running)
+    return HAL_ERR_BUSY;
+
+  if (!stimulus.cond_ready)
+  {
+    pthread_condattr_t cond_attr;
+    pthread_condattr_init(&cond_attr);
+#ifndef __APPLE__
+    pthread_condattr_setclock(&cond_attr, kCondClock);
+#endif
+    pthread_cond_init(&stimulus.cond, &cond_attr);
+    pthread_condattr_destroy(&cond_attr);
+    stimulus.cond_ready = true;
+  }
+
+  StimulusFile& f = stimulus.file;
+  struct stat st;
+  f.fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (f.fd < 0 || fstat(f.fd, &st) != 0 || st.st_size < 16)
+  {
+    stimulus_close_file();
+    return HAL_ERR_IO;
+  }
+  f.size = static_cast<uint64_t>(st.st_size);
+
+  size_t avail;
+  const uint8_t* header = stimulus_window(f, 16, &avail);
+  bool stim = header && memcmp(header, "V4SI", 4) == 0;
+  bool recorded = header && memcmp(header, "V4GT", 4) == 0;
+  if (!(stim || recorded) || header[4] != 1)
+  {
+    stimulus_close_file();
+    return HAL_ERR_IO;
+  }
+  f.pos = 16;  // The header's pin count and start time are informational
+
+  stimulus.recorded = recorded;
+  stimulus.ctx = &context();
+  stimulus.stats = hal_sim_stimulus_stats_t();
+  stimulus.status = HAL_OK;
+  stimulus.attached = false;
+  stimulus.done = false;
+  stimulus.stopping.store(false, std::memory_order_relaxed);
+  stimulus.base_us = PosixPlatform::micros_impl();
+  if (pthread_create(&stimulus.thread, nullptr, stimulus_thread, nullptr) != 0)
+  {
+    stimulus_close_file();
+    return HAL_ERR_NOMEM;
+  }
+  stimulus.running = true;
+
+  pthread_mutex_lock(&stimulus.lock);
+  while (!stimulus.attached)
+    pthread_cond_wait(&stimulus.cond, &stimulus.lock);
+  pthread_mutex_unlock(&stimulus.lock);
+
+  if (!stimulus.exit_hook)
+  {
+    atexit(stimulus_at_exit);
+    stimulus.exit_hook = true;
+  }
+  return HAL_OK;
+}
+
+/* ========================================================================= */
+/* Console I/O Implementation                                                */
+/* ========================================================================= */
+
+/**
+ * Buffered console (HAL_CONSOLE_BUFFERED). Writers serialize on a
+ * hal_lock_t and memcpy into an SPSC ring that a flusher thread drains
+ * with write(STDOUT_FILENO). While output keeps arriving the flusher
+ * polls every V4_HAL_POSIX_CONSOLE_FLUSH_US, so writers never signal it;
+ * after an empty poll it sets `idle` and sleeps until a writer that sees
+ * the flag wakes it.
+ */
+struct ConsoleBuffer
+{
+  SpscByteRing<PosixPlatform::console_ring_size()> ring;
+  std::atomic<bool> buffered{false};
+  std::atomic<bool> idle{false};  // Flusher asleep until kicked
+  hal_lock_t writer = {};         // Serializes writers and mode switches
+  bool started = false;           // Guarded by writer
+  pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+  pthread_cond_t wake;                                // Flusher waits here
+  pthread_cond_t drained = PTHREAD_COND_INITIALIZER;  // After each drain pass
+  bool kicked = false;                                // Guarded by lock
+};
+
+static ConsoleBuffer console;
+
+// Write out everything in the ring; returns the number of bytes taken
+static size_t console_drain()
+{
+  size_t total = 0;
+  const uint8_t* p;
+  while (size_t n = console.ring.peek(&p))
+  {
+    ssize_t written = write(STDOUT_FILENO, p, n);
+    if (written < 0 && errno == EINTR)
+      continue;
+    if (written < 0 && errno == EAGAIN)
+    {
+      struct pollfd pfd = {STDOUT_FILENO, POLLOUT, 0};
+      poll(&pfd, 1, 10);
+      continue;
+    }
+    // Bytes the device refuses are dropped rather than stalling writers
+    size_t done = written > 0 ? static_cast<size_t>(written) : n;
+    console.ring.consume(done);
+    total += done;
+  }
+  return total;
+}
+
+static void* console_flusher_thread(void*)
+{
+  bool active = true;  // Output drained since the last poll
+  pthread_mutex_lock(&console.lock);
+  for (;;)
+  {
+    console.kicked = false;
+    pthread_mutex_unlock(&console.lock);
+    if (console_drain())
+      active = true;
+    pthread_mutex_lock(&console.lock);
+    pthread_cond_broadcast(&console.drained);
+
+    if (console.kicked || console.ring.size())
+      continue;
+    if (active)
+    {
+      struct timespec ts = cond_deadline(V4_HAL_POSIX_CONSOLE_FLUSH_US);
+      pthread_cond_timedwait(&console.wake, &console.lock, &ts);
+      active = false;
+      continue;
+    }
+
+    // Pairs with the fence in console_push()
+    console.idle.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    while (!console.kicked && console.ring.size() == 0)
+      pthread_cond_wait(&console.wake, &console.lock);
+    console.idle.store(false, std::memory_order_relaxed);
+  }
+  return nullptr;
+}
+
+// Block until the flusher has written every byte in the ring
+static void console_wait_drained()
+{
+  pthread_mutex_lock(&console.lock);
+  while (console.ring.size())
+  {
+    console.kicked = true;
+    pthread_cond_signal(&console.wake);
+    pthread_cond_wait(&console.drained, &console.lock);
+  }
+  pthread_mutex_unlock(&console.lock);
+}
+
+// Called with the writer lock held
+static void console_push(const uint8_t* buf, size_t len)
+{
+  size_t done = console.ring.push(buf, len);
+  while (done < len)
+  {
+    console_wait_drained();
+    done += console.ring.push(buf + done, len - done);
+  }
+
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (console.idle.load(std::memory_order_relaxed))
+  {
+    pthread_mutex_lock(&console.lock);
+    console.kicked = true;
+    pthread_cond_signal(&console.wake);
+    pthread_mutex_unlock(&console.lock);
+  }
+}
+
+static void console_at_exit()
+{
+  PosixPlatform::console_flush_impl();
+}
+
+// Called with the writer lock held
+static int console_start()
+{
+  pthread_condattr_t cond_attr;
+  pthread_condattr_init(&cond_attr);
+#ifndef __APPLE__
+  pthread_condattr_setclock(&cond_attr, kCondClock);
+#endif
+  pthread_cond_init(&console.wake, &cond_attr);
+  pthread_condattr_destroy(&cond_attr);
+
+  pthread_t thread;
+  if (pthread_create(&thread, nullptr, console_flusher_thread, nullptr) != 0)
+  {
+    pthread_cond_destroy(&console.wake);
+    return HAL_ERR_NOMEM;
+  }
+  pthread_detach(thread);
+  atexit(console_at_exit);
+  console.started = true;
+  return HAL_OK;
+}
+
+int PosixPlatform::console_write_impl(const uint8_t* buf, size_t len)
+{
+  if (console.buffered.load(std::memory_order_acquire))
+  {
+    lock_acquire_impl(&console.writer);
+    // Re-check under the lock: switching to direct mode holds it
+    bool buffered = console.buffered.load(std::memory_order_relaxed);
+    if (buffered)
+      console_push(buf, len);
+    lock_release_impl(&console.writer);
+    if (buffered)
+      return static_cast<int>(len);
+  }
+
+  // Write to stdout using POSIX write()
+  ssize_t written = write(STDOUT_FILENO, buf, len);
+  return (written >= 0) ? static_cast<int>(written) : HAL_ERR_IO;
+}
+
+int PosixPlatform::console_set_mode_impl(hal_console_mode_t mode)
+{
+  int ret = HAL_OK;
+  lock_acquire_impl(&console.writer);
+  if (mode == HAL_CONSOLE_BUFFERED)
+  {
+    if (!console.started)
+      ret = console_start();
+    if (ret == HAL_OK)
+      console.buffered.store(true, std::memory_order_release);
+  }
+  else if (console.buffered.load(std::memory_order_relaxed))
+  {
+    console_wait_drained();
+    console.buffered.store(false, std::memory_order_release);
+  }
+  lock_release_impl(&console.writer);
+  return ret;
+}
+
+int PosixPlatform::console_flush_impl()
+{
+  // The ring is drained before buffered mode is left, so direct mode has
+  // nothing pending
+  if (console.buffered.load(std::memory_order_acquire))
+    console_wait_drained();
+  return HAL_OK;
+}
+
+int PosixPlatform::console_read_impl(uint8_t* buf, size_t len)
+{
+  console_flush_impl();
+
+  // An open STDIO UART port is the one consumer of stdin
+  pthread_mutex_lock(&uart_loop.lock);
+  bool owned = uart_loop.stdin_owner != nullptr;
+  pthread_mutex_unlock(&uart_loop.lock);
+  if (owned)
+    return HAL_ERR_BUSY;
+
+  // Read from stdin using POSIX read() - blocking
+  ssize_t bytes_read = read(STDIN_FILENO, buf, len);
+  return (bytes_read >= 0) ? static_cast<int>(bytes_read) : HAL_ERR_IO;
+}
+
+/* ========================================================================= */
+/* Interrupt Control Implementation                                          */
+/* ========================================================================= */
+
+/**
+ * Recursive futex lock, used for the global critical section and for
+ * every hal_lock_t. The 32-bit lock word holds the owner's thread id,
+ * with bit 31 set once a waiter may be asleep on it, so:
+ * - an uncontended acquire is one CAS (0 -> id) and a release one exchange;
+ * - a nested acquire is one load and an owner-only depth increment;
+ * - a contended acquire spins for an adaptive number of rounds (glibc's
+ *   PTHREAD_MUTEX_ADAPTIVE_NP heuristic), then sleeps with FUTEX_WAIT
+ *   (sched_yield() on hosts without futexes).
+ */
+static constexpr uint32_t kLockWaiters = 0x80000000u;
+static constexpr int32_t kLockMaxSpin = 200;
+
+struct FutexLock
+{
+  std::atomic<uint32_t>& word;
+  uint32_t& depth;                       // Nested acquires; owner only
+  std::atomic<uint32_t>& spin_estimate;  // Running mean of spins to acquire
+};
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t) &&
+                  std::atomic<uint32_t>::is_always_lock_free,
+              "futex word must be a plain 32-bit integer");
+
+// Small process-unique thread id (never 0, below kLockWaiters)
+static uint32_t lock_thread_id()
+{
+  static std::atomic<uint32_t> next_id{1};
+  static thread_local uint32_t id = 0;
+  if (!id)
+    id = next_id.fetch_add(1, std::memory_order_relaxed) & ~kLockWaiters;
+  return id;
+}
+
+static void lock_wait(std::atomic<uint32_t>& word, uint32_t expected)
+{
+#ifdef __linux__
+  syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT_PRIVATE, expected,
+          nullptr, nullptr, 0);
+#else
+  (void)word;
+  (void)expected;
+  sched_yield();
+#endif
+}
+
+static void lock_wake(std::atomic<uint32_t>& word)
+{
+#ifdef __linux__
+  syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE_PRIVATE, 1, nullptr,
+          nullptr, 0);
+#else
+  (void)word;
+#endif
+}
+
+/**
+ * Take the lock without waiting, or nest if the caller owns it.
+ *
+ * @return Nesting level reached (1 = outermost), 0 if another thread owns it
+ */
+static inline uint32_t lock_try_acquire(const FutexLock& lock, uint32_t self)
+{
+  uint32_t word = 0;
+  if (lock.word.compare_exchange_strong(word, self, std::memory_order_acquire,
+                                        std::memory_order_relaxed))
+    return 1;
+  if ((word & ~kLockWaiters) == self)
+    return ++lock.depth + 1;
+  return 0;
+}
+
+/**
+ * Wait for the lock after lock_try_acquire() failed.
+ *
+ * @return Number of times the caller slept (0 = acquired while spinning)
+ */
+static uint32_t lock_acquire_contended(const FutexLock& lock, uint32_t self)
+{
+  // Spin while the owner is likely to leave soon
+  auto estimate =
+      static_cast<int32_t>(lock.spin_estimate.load(std::memory_order_relaxed));
+  int32_t limit = estimate * 2 + 10;
+  if (limit > kLockMaxSpin)
+    limit = kLockMaxSpin;
+  for (int32_t spins = 0; spins < limit; spins++)
+  {
+    cpu_relax();
+    uint32_t expected = 0;
+    if (lock.word.load(std::memory_order_relaxed) == 0 &&
+        lock.word.compare_exchange_weak(expected, self, std::memory_order_acquire,
+                                        std::memory_order_relaxed))
+    {
+      lock.spin_estimate.store(static_cast<uint32_t>(estimate + (spins - estimate) / 8),
+                               std::memory_order_relaxed);
+      return 0;
+    }
+  }
+  lock.spin_estimate.store(static_cast<uint32_t>(estimate + (limit - estimate) / 8),
+                           std::memory_order_relaxed);
+
+  // Sleep. A thread that wakes up takes the lock with the waiters bit set,
+  // since it cannot know whether others are still asleep.
+  uint32_t sleeps = 0;
+  for (;;)
+  {
+    uint32_t word = lock.word.load(std::memory_order_relaxed);
+    if (word == 0)
+    {
+      if (lock.word.compare_exchange_weak(word, self | kLockWaiters,
+                                          std::memory_order_acquire,
+                                          std::memory_order_relaxed))
+        return sleeps;
+      continue;
+    }
+    if (!(word & kLockWaiters) &&
+        !lock.word.compare_exchange_weak(word, word | kLockWaiters,
+                                         std::memory_order_relaxed))
+      continue;
+
+    sleeps++;
+    lock_wait(lock.word, word | kLockWaiters);
+  }
+}
+
+static inline void lock_release(const FutexLock& lock)
+{
+  assert((lock.word.load(std::memory_order_relaxed) & ~kLockWaiters) == lock_thread_id() &&
+         "lock released by a thread that does not hold it");
+  if (lock.depth)
+  {
+    lock.depth--;
+    return;
+  }
+  if (lock.word.exchange(0, std::memory_order_release) & kLockWaiters)
+    lock_wake(lock.word);
+}
+
+/* ------------------------------------------------------------------------- */
+/* Critical section                                                          */
+/* ------------------------------------------------------------------------- */
+
+/**
+ * One FutexLock per context, shared by that context's hal_critical_enter()
+ * callers. Contended enters
+ * are counted per call site in a small open-addressed table keyed by
+ * return address; the uncontended path counts nothing.
+ */
+static FutexLock critical_futex(PosixContext& c)
+{
+  return {c.critical.word, c.critical.depth, c.critical.spin_estimate};
+}
+
+// Context whose critical section the calling thread holds. Nested enters
+// and the matching exits use it, even if the thread rebinds in between.
+static thread_local PosixContext* critical_held = nullptr;
+
+static void critical_count_site(CriticalStats& critical_stats, const void* site)
+{
+  uintptr_t key = reinterpret_cast<uintptr_t>(site);
+  if (!key)
+  {
+    critical_stats.other_sites.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  size_t hash = static_cast<size_t>((key >> 2) * 0x9E3779B97F4A7C15ull >> 32);
+  for (size_t i = 0; i < kCriticalSiteSlots; i++)
+  {
+    CriticalSiteSlot& slot = critical_stats.sites[(hash + i) & (kCriticalSiteSlots - 1)];
+    uintptr_t current = slot.site.load(std::memory_order_acquire);
+    if (current == 0 && slot.site.compare_exchange_strong(current, key,
+                                                          std::memory_order_acq_rel))
+      current = key;
+    if (current == key)
+    {
+      slot.contended.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+  }
+  critical_stats.other_sites.fetch_add(1, std::memory_order_relaxed);
+}
+
+void PosixPlatform::critical_enter_impl(const void* site)
+{
+  PosixContext& c = critical_held ? *critical_held : context();
+  CriticalStats& critical_stats = c.critical_stats;
+  FutexLock futex = critical_futex(c);
+  uint32_t self = lock_thread_id();
+  uint32_t level = lock_try_acquire(futex, self);
+  if (level > 1)
+  {
+    if (level > critical_stats.max_depth.load(std::memory_order_relaxed))
+      critical_stats.max_depth.store(level, std::memory_order_relaxed);
+    return;
+  }
+  critical_held = &c;
+  if (level == 1)
+    return;
+
+  critical_stats.contended.fetch_add(1, std::memory_order_relaxed);
+  critical_count_site(critical_stats, site);
+  uint32_t sleeps = lock_acquire_contended(futex, self);
+  if (sleeps)
+    critical_stats.sleeps.fetch_add(sleeps, std::memory_order_relaxed);
+  else
+    critical_stats.spin_acquired.fetch_add(1, std::memory_order_relaxed);
+}
+
+void PosixPlatform::critical_enter_impl()
+{
+  critical_enter_impl(__builtin_return_address(0));
+}
+
+void PosixPlatform::critical_exit_impl()
+{
+  PosixContext* c = critical_held;
+  assert(c && "hal_critical_exit() without hal_critical_enter()");
+  if (!c)
+    return;
+
+  FutexLock futex = critical_futex(*c);
+  if (futex.depth == 0)
+    critical_held = nullptr;
+  lock_release(futex);
+}
+
+int PosixPlatform::critical_stats_impl(hal_critical_stats_t* stats)
+{
+  const CriticalStats& critical_stats = context().critical_stats;
+  stats->contended = critical_stats.contended.load(std::memory_order_relaxed);
+  stats->spin_acquired = critical_stats.spin_acquired.load(std::memory_order_relaxed);
+  stats->sleeps = critical_stats.sleeps.load(std::memory_order_relaxed);
+  uint32_t max_depth = critical_stats.max_depth.load(std::memory_order_relaxed);
+  stats->max_depth = max_depth ? max_depth : 1;
+  return HAL_OK;
+}
+
+size_t PosixPlatform::critical_sites_impl(hal_critical_site_t* sites, size_t max)
+{
+  CriticalStats& critical_stats = context().critical_stats;
+  size_t count = 0;
+  auto add = [&](const void* site, uint64_t contended)
+  {
+    // Insertion into the descending list, dropping the smallest when full
+    size_t i = (count < max) ? count++ : max;
+    while (i > 0 && sites[i - 1].contended < contended)
+    {
+      if (i < max)
+        sites[i] = sites[i - 1];
+      i--;
+    }
+    if (i < max)
+      sites[i] = {site, contended};
+  };
+
+  for (CriticalSiteSlot& slot : critical_stats.sites)
+  {
+    uintptr_t site = slot.site.load(std::memory_order_acquire);
+    uint64_t contended = slot.contended.load(std::memory_order_relaxed);
+    if (site && contended)
+      add(reinterpret_cast<const void*>(site), contended);
+  }
+  uint64_t other = critical_stats.other_sites.load(std::memory_order_relaxed);
+  if (other)
+    add(nullptr, other);
+  return count;
+}
+
+void PosixPlatform::critical_stats_reset_impl()
+{
+  CriticalStats& critical_stats = context().critical_stats;
+  critical_stats.contended.store(0, std::memory_order_relaxed);
+  critical_stats.spin_acquired.store(0, std::memory_order_relaxed);
+  critical_stats.sleeps.store(0, std::memory_order_relaxed);
+  critical_stats.max_depth.store(0, std::memory_order_relaxed);
+  critical_stats.other_sites.store(0, std::memory_order_relaxed);
+  for (CriticalSiteSlot& slot : critical_stats.sites)
+  {
+    slot.contended.store(0, std::memory_order_relaxed);
+    slot.site.store(0, std::memory_order_relaxed);
+  }
+}
+
+/* ------------------------------------------------------------------------- */
+/* Named locks                                                               */
+/* ------------------------------------------------------------------------- */
+
+/**
+ * A hal_lock_t is its own FutexLock: impl[0] is the lock word, impl[1]
+ * the nesting depth and impl[2] the spin estimate, so independent locks
+ * share no state and no cache line traffic beyond their own.
+ */
+static_assert(sizeof(static_cast<hal_lock_t*>(nullptr)->impl) >= 3 * sizeof(uint32_t),
+              "hal_lock_t too small for a FutexLock");
+
+static FutexLock futex_of(hal_lock_t* lock)
+{
+  return {*reinterpret_cast<std::atomic<uint32_t>*>(&lock->impl[0]), lock->impl[1],
+          *reinterpret_cast<std::atomic<uint32_t>*>(&lock->impl[2])};
+}
+
+void PosixPlatform::lock_init_impl(hal_lock_t* lock)
+{
+  lock->impl[0] = 0;
+  lock->impl[1] = 0;
+  lock->impl[2] = 0;
+}
+
+void PosixPlatform::lock_acquire_impl(hal_lock_t* lock)
+{
+  FutexLock futex = futex_of(lock);
+  uint32_t self = lock_thread_id();
+  if (lock_try_acquire(futex, self))
+    return;
+
+  reinterpret_cast<std::atomic<uint32_t>*>(&lock->contended)
+      ->fetch_add(1, std::memory_order_relaxed);
+  lock_acquire_contended(futex, self);
+}
+
+void PosixPlatform::lock_release_impl(hal_lock_t* lock)
+{
+  lock_release(futex_of(lock));
+}
+
+/* ========================================================================= */
+/* Context Implementation                                                    */
+/* ========================================================================= */
+
+/**
+ * Contexts are carved out of anonymous mmap slabs of context_slab_size()
+ * contexts each, and destroyed contexts go on a free list for reuse, so
+ * creating thousands of boards costs a handful of mappings and only the
+ * pages they touch. Slabs are never returned to the system.
+ */
+struct ContextArena
+{
+  pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+  uint8_t* next = nullptr;  // Unused part of the current slab
+  uint8_t* end = nullptr;
+  PosixContext* free_list = nullptr;
+};
+
+static ContextArena context_arena;
+
+static PosixContext* context_alloc()
+{
+  void* p;
+  pthread_mutex_lock(&context_arena.lock);
+  if (context_arena.free_list)
+  {
+    p = context_arena.free_list;
+    context_arena.free_list = context_arena.free_list->next_free;
+  }
+  else
+  {
+    if (context_arena.next == context_arena.end)
+    {
+      size_t bytes = sizeof(PosixContext) * PosixPlatform::context_slab_size();
+      void* slab = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (slab == MAP_FAILED)
+      {
+        pthread_mutex_unlock(&context_arena.lock);
+        return nullptr;
+      }
+      context_arena.next = static_cast<uint8_t*>(slab);
+      context_arena.end = context_arena.next + bytes;
+    }
+    p = context_arena.next;
+    context_arena.next += sizeof(PosixContext);
+  }
+  pthread_mutex_unlock(&context_arena.lock);
+  return new (p) PosixContext();
+}
+
+static void context_free(PosixContext* c)
+{
+  c->~PosixContext();
+  pthread_mutex_lock(&context_arena.lock);
+  c->next_free = context_arena.free_list;
+  context_arena.free_list = c;
+  pthread_mutex_unlock(&context_arena.lock);
+}
+
+hal_context_t* PosixPlatform::context_create_impl()
+{
+  return reinterpret_cast<hal_context_t*>(context_alloc());
+}
+
+// UART_INIT handles in c's table, owned by the SYS layer and closed by destroy
+static uint64_t context_sys_handles(const PosixContext& c)
+{
+  uint64_t n = 0;
+  for (hal_handle_t h : c.sys_uart)
+    n += (h != nullptr);
+  return n;
+}
+
+int PosixPlatform::context_destroy_impl(hal_context_t* ctx)
+{
+  auto* c = reinterpret_cast<PosixContext*>(ctx);
+
+  // The table is only written by threads bound to c, so the count taken
+  // here may be stale; once kContextDying stops new bindings it is exact
+  uint64_t sys_handles = context_sys_handles(*c);
+  if (!c->refs.compare_exchange_strong(sys_handles, sys_handles | kContextDying,
+                                       std::memory_order_acq_rel,
+                                       std::memory_order_relaxed))
+    return HAL_ERR_BUSY;
+  if (context_sys_handles(*c) != sys_handles)
+  {
+    c->refs.fetch_and(~kContextDying, std::memory_order_release);
+    return HAL_ERR_BUSY;
+  }
+  for (hal_handle_t& h : c->sys_uart)
+  {
+    if (h)
+      uart_close_impl(h);
+    h = nullptr;
+  }
+
+  // Stop the simulation engines driving this board
+  pthread_mutex_lock(&gpio_trace.control);
+  if (gpio_trace.context.load(std::memory_order_relaxed) == c)
+  {
+    trace_stop_locked(nullptr);
+    gpio_trace.context.store(nullptr, std::memory_order_relaxed);
+  }
+  pthread_mutex_unlock(&gpio_trace.control);
+  pthread_mutex_lock(&stimulus.control);
+  if (stimulus.running && stimulus.ctx == c)
+    stimulus_stop_locked(nullptr);
+  pthread_mutex_unlock(&stimulus.control);
+
+  gpio_irq_forget(*c);
+
+  context_free(c);
+  return HAL_OK;
+}
+
+void PosixPlatform::context_retain_impl(hal_context_t* ctx)
+{
+  reinterpret_cast<PosixContext*>(ctx)->refs.fetch_add(1, std::memory_order_relaxed);
+}
+
+void PosixPlatform::context_release_impl(hal_context_t* ctx)
+{
+  reinterpret_cast<PosixContext*>(ctx)->refs.fetch_sub(1, std::memory_order_release);
+}
+
+hal_handle_t* PosixPlatform::context_sys_uart_impl()
+{
+  return context().sys_uart;
+}
+
+hal_context_t* PosixPlatform::context_bind_impl(hal_context_t* ctx)
+{
+  PosixContext* previous = bound_context;
+  auto* c = reinterpret_cast<PosixContext*>(ctx);
+  if (c == previous)
+    return ctx;
+
+  // A destroy that finds c in use clears kContextDying again; binding a
+  // context it went on to free is a use after hal_context_destroy()
+  if (c)
+  {
+    while (!context_try_bind(*c))
+      sched_yield();
+  }
+  bound_context = c;
+  if (previous)
+    context_unbind(*previous);
+  return reinterpret_cast<hal_context_t*>(previous);
+}
+
+hal_context_t* PosixPlatform::context_current_impl()
+{
+  return reinterpret_cast<hal_context_t*>(bound_context);
+}
+
+}  // namespace hal
+}  // namespace v4
+
+/* ========================================================================= */
+/* Platform Hooks                                                            */
+/* ========================================================================= */
+
+extern "C" int hal_platform_init(void)
+{
+  v4::hal::clock_init();
+  if (V4_HAL_POSIX_CONSOLE_BUFFERED)
+    return v4::hal::PosixPlatform::console_set_mode_impl(HAL_CONSOLE_BUFFERED);
+  return HAL_OK;
+}
+
+extern "C" void hal_platform_deinit(void)
+{
+  v4::hal::PosixPlatform::console_flush_impl();
+}
+
+/* ========================================================================= */
+/* Simulation API                                                            */
+/* ========================================================================= */
+
+extern "C" int hal_sim_gpio_input(int pin, hal_gpio_value_t value)
+{
+  using namespace v4::hal;
+  if (pin < 0 || pin >= PosixPlatform::max_gpio_pins())
+    return HAL_ERR_PARAM;
+  PosixContext& c = context();
+  if (c.gpio_modes.test(pin))
+    return HAL_ERR_PARAM;  // Output pins are driven by the firmware
+
+  gpio_set_level(c, pin, value);
+  return HAL_OK;
+}
+
+extern "C" int hal_sim_gpio_record_start(const char* path, hal_sim_trace_format_t format)
+{
+  using namespace v4::hal;
+  if (!path || (format != HAL_SIM_TRACE_BINARY && format != HAL_SIM_TRACE_VCD))
+    return HAL_ERR_PARAM;
+
+  pthread_mutex_lock(&gpio_trace.control);
+  int ret = trace_start_locked(path, format);
+  pthread_mutex_unlock(&gpio_trace.control);
+  return ret;
+}
+
+extern "C" int hal_sim_gpio_record_stop(hal_sim_trace_stats_t* stats)
+{
+  using namespace v4::hal;
+  pthread_mutex_lock(&gpio_trace.control);
+  int ret = trace_stop_locked(stats);
+  pthread_mutex_unlock(&gpio_trace.control);
+  return ret;
+}
+
+extern "C" int hal_sim_stimulus_start(const char* path)
+{
+  using namespace v4::hal;
+  if (!path)
+    return HAL_ERR_PARAM;
+
+  pthread_mutex_lock(&stimulus.control);
+  int ret = stimulus_start_locked(path);
+  pthread_mutex_unlock(&stimulus.control);
+  return ret;
+}
+
+extern "C" int hal_sim_stimulus_wait(uint32_t timeout_ms)
+{
+  using namespace v4::hal;
+  pthread_mutex_lock(&stimulus.control);
+  bool running = stimulus.running;
+  pthread_mutex_unlock(&stimulus.control);
+  if (!running)
+    return HAL_ERR_PARAM;
+
+  struct timespec deadline = cond_deadline(uint64_t{timeout_ms} * 1000);
+  pthread_mutex_lock(&stimulus.lock);
+  int rc = 0;
+  while (!stimulus.done && rc != ETIMEDOUT)
+    rc = pthread_cond_timedwait(&stimulus.cond, &stimulus.lock, &deadline);
+  bool done = stimulus.done;
+  pthread_mutex_unlock(&stimulus.lock);
+  return done ? HAL_OK : HAL_ERR_TIMEOUT;
+}
+
+extern "C" int hal_sim_stimulus_stop(hal_sim_stimulus_stats_t* stats)
+{
+  using namespace v4::hal;
+  pthread_mutex_lock(&stimulus.control);
+  int ret = stimulus_stop_locked(stats);
+  pthread_mutex_unlock(&stimulus.control);
+  return ret;
+}
+
+extern "C" int hal_sim_time_advance(uint64_t us)
+{
+  using namespace v4::hal;
+  pthread_mutex_lock(&virtual_clock.lock);
+  if (!virtual_time_active())
+  {
+    pthread_mutex_unlock(&virtual_clock.lock);
+    return HAL_ERR_NOTSUP;
+  }
+  virtual_clock.now_us.fetch_add(us, std::memory_order_acq_rel);
+  virtual_clock.epoch++;
+  pthread_cond_broadcast(&virtual_clock.cond);
+  pthread_mutex_unlock(&virtual_clock.lock);
+  return HAL_OK;
+}
+
+extern "C" void hal_sim_time_attach(void)
+{
+  using namespace v4::hal;
+  pthread_mutex_lock(&virtual_clock.lock);
+  virtual_self.join_locked();
+  pthread_mutex_unlock(&virtual_clock.lock);
+}
+
+extern "C" void hal_sim_time_detach(void)
+{
+  v4::hal::virtual_self.leave();
+}
 
 /* ========================================================================= */
 /* Platform Capabilities                                                     */
@@ -205,7 +4064,7 @@ void PosixPlatform::critical_exit_impl()
 extern "C" const hal_capabilities_t* hal_platform_capabilities(void)
 {
   static const hal_capabilities_t caps = {
-      32,  // gpio_count
+      v4::hal::PosixPlatform::max_gpio_pins(),  // gpio_count
       4,   // uart_count
       0,   // spi_count
       0,   // i2c_count
@@ -214,6 +4073,7 @@ extern "C" const hal_capabilities_t* hal_platform_capabilities(void)
       0,   // has_pwm
       0,   // has_rtc
       0,   // has_dma
+      1,   // has_contexts
       0,   // reserved
   };
   return &caps;
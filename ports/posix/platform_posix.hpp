@@ -13,6 +13,66 @@
 
 #include "v4/hal_types.h"
 
+#ifndef V4_HAL_POSIX_GPIO_PINS
+#define V4_HAL_POSIX_GPIO_PINS 32
+#endif
+
+#ifndef V4_HAL_POSIX_TSC_CLOCK
+#if defined(__x86_64__)
+#define V4_HAL_POSIX_TSC_CLOCK 1
+#else
+#define V4_HAL_POSIX_TSC_CLOCK 0
+#endif
+#endif
+
+#ifndef V4_HAL_POSIX_DELAY_SPIN_US
+#define V4_HAL_POSIX_DELAY_SPIN_US 0
+#endif
+
+#ifndef V4_HAL_POSIX_VIRTUAL_TIME
+#define V4_HAL_POSIX_VIRTUAL_TIME 0
+#endif
+
+#ifndef V4_HAL_POSIX_VIRTUAL_STALL_US
+#define V4_HAL_POSIX_VIRTUAL_STALL_US 10000
+#endif
+
+#ifndef V4_HAL_POSIX_UART_RX_RING_SIZE
+#define V4_HAL_POSIX_UART_RX_RING_SIZE 4096
+#endif
+
+#ifndef V4_HAL_POSIX_UART_TX_BUF_SIZE
+#define V4_HAL_POSIX_UART_TX_BUF_SIZE 1024
+#endif
+
+#ifndef V4_HAL_POSIX_UART_TX_FLUSH_US
+#define V4_HAL_POSIX_UART_TX_FLUSH_US 1000
+#endif
+
+#ifndef V4_HAL_POSIX_GPIO_TRACE_RING_SIZE
+#define V4_HAL_POSIX_GPIO_TRACE_RING_SIZE 1048576
+#endif
+
+#ifndef V4_HAL_POSIX_GPIO_TRACE_FLUSH_US
+#define V4_HAL_POSIX_GPIO_TRACE_FLUSH_US 1000
+#endif
+
+#ifndef V4_HAL_POSIX_CONTEXT_SLAB
+#define V4_HAL_POSIX_CONTEXT_SLAB 64
+#endif
+
+#ifndef V4_HAL_POSIX_CONSOLE_BUFFERED
+#define V4_HAL_POSIX_CONSOLE_BUFFERED 0
+#endif
+
+#ifndef V4_HAL_POSIX_CONSOLE_RING_SIZE
+#define V4_HAL_POSIX_CONSOLE_RING_SIZE 65536
+#endif
+
+#ifndef V4_HAL_POSIX_CONSOLE_FLUSH_US
+#define V4_HAL_POSIX_CONSOLE_FLUSH_US 1000
+#endif
+
 namespace v4
 {
 namespace hal
@@ -22,7 +82,9 @@ namespace hal
  * @brief POSIX platform implementation
  *
  * Provides CRTP implementation for GPIO, UART, and Timer operations.
- * GPIO is simulated using bitmaps. UART uses stdin/stdout.
+ * GPIO is simulated using a compile-time sized lock-free pin bank. UART
+ * ports bind to stdio, PTYs, Unix sockets or FIFOs, with received bytes
+ * buffered in per-port lock-free rings.
  * Timer uses clock_gettime(CLOCK_MONOTONIC).
  */
 struct PosixPlatform
@@ -34,11 +96,12 @@ struct PosixPlatform
   /**
    * @brief Maximum number of GPIO pins
    *
-   * POSIX simulation supports 32 GPIO pins.
+   * Size of the simulated pin bank, 32 by default. Set with the
+   * V4_HAL_POSIX_GPIO_PINS CMake cache variable (up to 65535).
    */
   static constexpr int max_gpio_pins()
   {
-    return 32;
+    return V4_HAL_POSIX_GPIO_PINS;
   }
 
   /**
@@ -51,6 +114,64 @@ struct PosixPlatform
     return 4;
   }
 
+  /**
+   * @brief UART receive ring size in bytes (per port)
+   *
+   * Must be a power of two. Override with -DV4_HAL_POSIX_UART_RX_RING_SIZE.
+   */
+  static constexpr size_t uart_rx_ring_size()
+  {
+    return V4_HAL_POSIX_UART_RX_RING_SIZE;
+  }
+
+  /**
+   * @brief UART transmit coalescing buffer size in bytes (per port)
+   *
+   * Writes that would overflow the buffer are sent together with the
+   * buffered bytes in one writev(). Override with
+   * -DV4_HAL_POSIX_UART_TX_BUF_SIZE.
+   */
+  static constexpr size_t uart_tx_buffer_size()
+  {
+    return V4_HAL_POSIX_UART_TX_BUF_SIZE;
+  }
+
+  /**
+   * @brief Per-thread GPIO trace buffer size in bytes
+   *
+   * A transition takes about two bytes, so the default holds roughly half
+   * a million; the writer is woken early once a buffer is half full. On a
+   * single-CPU host the producer can outrun the writer for a whole
+   * scheduler slice, which smaller buffers turn into dropped transitions.
+   * Must be a power of two. Override with
+   * -DV4_HAL_POSIX_GPIO_TRACE_RING_SIZE.
+   */
+  static constexpr size_t gpio_trace_ring_size()
+  {
+    return V4_HAL_POSIX_GPIO_TRACE_RING_SIZE;
+  }
+
+  /**
+   * @brief Contexts allocated per arena slab
+   *
+   * hal_context_create() maps memory for this many contexts at a time.
+   * Override with -DV4_HAL_POSIX_CONTEXT_SLAB.
+   */
+  static constexpr size_t context_slab_size()
+  {
+    return V4_HAL_POSIX_CONTEXT_SLAB;
+  }
+
+  /**
+   * @brief Console output ring size in bytes (HAL_CONSOLE_BUFFERED)
+   *
+   * Must be a power of two. Override with -DV4_HAL_POSIX_CONSOLE_RING_SIZE.
+   */
+  static constexpr size_t console_ring_size()
+  {
+    return V4_HAL_POSIX_CONSOLE_RING_SIZE;
+  }
+
   /* ======================================================================= */
   /* GPIO Implementation                                                     */
   /* ======================================================================= */
@@ -88,6 +209,94 @@ struct PosixPlatform
    */
   static int gpio_read_impl(int pin, hal_gpio_value_t* value);
 
+  /**
+   * @brief Toggle GPIO output pin
+   *
+   * Single atomic fetch_xor on the simulated port.
+   *
+   * @param pin GPIO pin number
+   * @return HAL_OK on success, HAL_ERR_PARAM if not configured as output
+   */
+  static int gpio_toggle_impl(int pin);
+
+  /**
+   * @brief Set and clear several output pins of one 64-pin bank
+   *
+   * Applies both masks to the bank's word with a single atomic
+   * fetch_or/fetch_and (or one CAS when both masks are non-empty).
+   *
+   * @param bank       Bank index (pins 64*bank .. 64*bank+63)
+   * @param set_mask   Pins to drive high
+   * @param clear_mask Pins to drive low
+   * @return HAL_OK on success, HAL_ERR_PARAM if a selected pin is not an output
+   */
+  static int gpio_write_bank_impl(int bank, uint64_t set_mask, uint64_t clear_mask);
+
+  /**
+   * @brief Read every pin level of one bank with one atomic load
+   *
+   * @param bank  Bank index
+   * @param value Receives pin levels
+   * @return HAL_OK
+   */
+  static int gpio_read_bank_impl(int bank, uint64_t* value);
+
+  /**
+   * @brief Configure several pins of one bank with the same mode
+   *
+   * @param bank Bank index
+   * @param mask Pins to configure
+   * @param mode Pin mode
+   * @return HAL_OK
+   */
+  static int gpio_mode_bank_impl(int bank, uint64_t mask, hal_gpio_mode_t mode);
+
+  /**
+   * @brief Attach interrupt handler to GPIO pin
+   *
+   * Edges are detected whenever the simulated level changes, either from
+   * gpio_write_impl() or from hal_sim_gpio_input(). Matching pins are
+   * flagged in a pending bitmask and their handlers run on a dedicated
+   * dispatch thread, one call per set bit. The IRQ is enabled on attach.
+   *
+   * @param pin       GPIO pin number
+   * @param edge      Edge(s) to trigger on
+   * @param handler   Callback run on the dispatch thread
+   * @param user_data User context passed to handler
+   * @return HAL_OK on success, HAL_ERR_BUSY if a handler is already attached
+   */
+  static int gpio_irq_attach_impl(int pin, hal_gpio_irq_edge_t edge,
+                                  hal_gpio_irq_handler_t handler, void* user_data);
+
+  /**
+   * @brief Detach interrupt handler from GPIO pin
+   *
+   * When called from another thread, returns only after any running
+   * invocation of the pin's handler has finished.
+   *
+   * @param pin GPIO pin number
+   * @return HAL_OK on success, HAL_ERR_PARAM if no handler is attached
+   */
+  static int gpio_irq_detach_impl(int pin);
+
+  /**
+   * @brief Unmask GPIO interrupt
+   *
+   * @param pin GPIO pin number
+   * @return HAL_OK on success, HAL_ERR_PARAM if no handler is attached
+   */
+  static int gpio_irq_enable_impl(int pin);
+
+  /**
+   * @brief Mask GPIO interrupt
+   *
+   * Edges seen while masked are dropped.
+   *
+   * @param pin GPIO pin number
+   * @return HAL_OK on success, HAL_ERR_PARAM if no handler is attached
+   */
+  static int gpio_irq_disable_impl(int pin);
+
   /* ======================================================================= */
   /* UART Implementation                                                     */
   /* ======================================================================= */
@@ -95,10 +304,13 @@ struct PosixPlatform
   /**
    * @brief Open UART port
    *
-   * Simulates UART using FILE* (stdout for port 0).
+   * Connects the port to the host backend selected by config->backend:
+   * stdio (port 0 default), a pseudo-terminal, a listening Unix domain
+   * socket or a FIFO pair. Receive fds of all ports are serviced by one
+   * shared event-loop thread that fills each port's RX ring.
    *
    * @param port   UART port number
-   * @param config UART configuration (ignored in simulation)
+   * @param config UART configuration (line settings ignored in simulation)
    * @return Opaque handle on success, nullptr on failure
    */
   static hal_handle_t uart_open_impl(int port, const hal_uart_config_t* config);
@@ -114,6 +326,10 @@ struct PosixPlatform
   /**
    * @brief Write data to UART
    *
+   * Coalesces data in the port's TX buffer according to the configured
+   * hal_uart_tx_mode_t; a character-at-a-time writer costs about one
+   * syscall per line or per buffer rather than one per byte.
+   *
    * @param handle UART handle
    * @param buf    Data buffer
    * @param len    Number of bytes to write
@@ -121,23 +337,97 @@ struct PosixPlatform
    */
   static int uart_write_impl(hal_handle_t handle, const uint8_t* buf, size_t len);
 
+  /**
+   * @brief Gather-write to UART
+   *
+   * Segments are coalesced into the TX buffer when they fit, otherwise
+   * the buffered bytes and all segments go out in one writev().
+   *
+   * @param handle UART handle
+   * @param iov    Segment array
+   * @param iovcnt Number of segments
+   * @return Number of bytes written
+   */
+  static int uart_writev_impl(hal_handle_t handle, const hal_iovec_t* iov, size_t iovcnt);
+
+  /**
+   * @brief Flush buffered transmit data with a single writev()
+   *
+   * @param handle UART handle
+   * @return HAL_OK on success, negative error code on failure
+   */
+  static int uart_flush_impl(hal_handle_t handle);
+
   /**
    * @brief Read data from UART
    *
-   * Non-blocking read (simplified implementation).
+   * Non-blocking read. Drains the RX ring with at most two memcpy calls
+   * and no syscall.
    *
    * @param handle UART handle
    * @param buf    Destination buffer
    * @param len    Maximum bytes to read
-   * @return Number of bytes read (0 in simple implementation)
+   * @return Number of bytes read
    */
   static int uart_read_impl(hal_handle_t handle, uint8_t* buf, size_t len);
 
+  /**
+   * @brief Read from UART, blocking until len bytes arrive or timeout
+   *
+   * Sleeps on a condition variable signalled by the event loop, so an
+   * idle port costs no CPU while waiting. Under HAL_CLOCK_VIRTUAL the
+   * timeout is virtual and the caller waits as a virtual-time participant.
+   *
+   * @param handle     UART handle
+   * @param buf        Destination buffer
+   * @param len        Bytes to read
+   * @param timeout_us Timeout in microseconds (HAL_UART_WAIT_FOREVER = none)
+   * @return Number of bytes read (less than len on timeout)
+   */
+  static int uart_read_timeout_impl(hal_handle_t handle, uint8_t* buf, size_t len,
+                                    uint32_t timeout_us);
+
+  /**
+   * @brief Scatter-read from UART
+   *
+   * Non-blocking. Drains the RX ring directly into each segment in turn.
+   *
+   * @param handle UART handle
+   * @param iov    Segment array
+   * @param iovcnt Number of segments
+   * @return Number of bytes read
+   */
+  static int uart_readv_impl(hal_handle_t handle, const hal_iovec_t* iov, size_t iovcnt);
+
+  /**
+   * @brief Borrow the contiguous readable region of the RX ring
+   *
+   * The event loop only appends behind the view, so it stays valid until
+   * the caller consumes it. At most two peeks cover all buffered data.
+   *
+   * @param handle UART handle
+   * @param data   Receives pointer into the RX ring
+   * @param len    Receives contiguous length (0 if the ring is empty)
+   * @return HAL_OK
+   */
+  static int uart_rx_peek_impl(hal_handle_t handle, const uint8_t** data, size_t* len);
+
+  /**
+   * @brief Release bytes from the RX ring
+   *
+   * @param handle UART handle
+   * @param len    Number of bytes to release
+   * @return HAL_OK, or HAL_ERR_PARAM if len exceeds the buffered data
+   */
+  static int uart_rx_consume_impl(hal_handle_t handle, size_t len);
+
   /**
    * @brief Get bytes available in UART receive buffer
    *
+   * Single atomic load of the RX ring fill level.
+   *
    * @param handle UART handle
-   * @return 0 (simplified implementation)
+   * @return Number of bytes buffered in the RX ring
    */
   static int uart_available_impl(hal_handle_t handle);
 
@@ -148,7 +438,10 @@ struct PosixPlatform
   /**
    * @brief Get milliseconds since startup
    *
-   * Uses clock_gettime(CLOCK_MONOTONIC).
+   * Reads the selected clock source. hal_init() switches the default
+   * from CLOCK_MONOTONIC to the calibrated TSC when it is available
+   * (x86-64 with an invariant TSC, see V4_HAL_POSIX_TSC_CLOCK), or to
+   * virtual time when built with V4_HAL_POSIX_VIRTUAL_TIME.
    *
    * @return Milliseconds since startup
    */
@@ -157,16 +450,65 @@ struct PosixPlatform
   /**
    * @brief Get microseconds since startup
    *
-   * Uses clock_gettime(CLOCK_MONOTONIC).
+   * Same clock source as millis_impl(), except that HAL_CLOCK_COARSE
+   * keeps full precision here by reading CLOCK_MONOTONIC.
    *
    * @return Microseconds since startup
    */
   static uint64_t micros_impl();
 
+  /**
+   * @brief Select the clock behind millis_impl()/micros_impl()
+   *
+   * COARSE reads CLOCK_MONOTONIC_COARSE, RAW reads CLOCK_MONOTONIC_RAW
+   * (each falls back to CLOCK_MONOTONIC where the host lacks it). TSC
+   * calibrates the TSC on first use.
+   *
+   * VIRTUAL continues from the current time on a simulated counter that
+   * only delays advance. Leaving it keeps time monotonic: the real
+   * sources then run ahead by the time that was skipped.
+   *
+   * @param source Clock source
+   * @return HAL_OK on success, HAL_ERR_NOTSUP if the TSC is unusable
+   */
+  static int timer_set_source_impl(hal_clock_source_t source);
+
+  /**
+   * @brief Get the selected clock source
+   *
+   * @return Current clock source
+   */
+  static hal_clock_source_t timer_get_source_impl();
+
+  /**
+   * @brief Busy-wait tail of delay_us_impl() and delay_until_us_impl()
+   *
+   * 0 (the default) makes them pure sleeps. Override with
+   * -DV4_HAL_POSIX_DELAY_SPIN_US, e.g. 60 to absorb Linux timer slack.
+   */
+  static constexpr uint32_t delay_spin_us()
+  {
+    return V4_HAL_POSIX_DELAY_SPIN_US;
+  }
+
+  /**
+   * @brief Real time a virtual-time waiter tolerates without progress
+   *
+   * A thread that has delayed in virtual time and then blocks elsewhere
+   * (join, I/O) holds the virtual clock; after this long the other
+   * waiters advance without it. Override with
+   * -DV4_HAL_POSIX_VIRTUAL_STALL_US.
+   */
+  static constexpr uint32_t virtual_stall_us()
+  {
+    return V4_HAL_POSIX_VIRTUAL_STALL_US;
+  }
+
   /**
    * @brief Blocking delay in milliseconds
    *
-   * Uses usleep().
+   * Sleeps on an absolute CLOCK_MONOTONIC deadline; in virtual time it
+   * returns as soon as the simulated clock reaches the deadline.
    *
    * @param ms Milliseconds to delay
    */
@@ -175,12 +517,45 @@ struct PosixPlatform
   /**
    * @brief Blocking delay in microseconds
    *
-   * Uses usleep().
+   * Same as delay_us_precise_impl(us, delay_spin_us()).
    *
    * @param us Microseconds to delay
    */
   static void delay_us_impl(uint32_t us);
 
+  /**
+   * @brief Precise delay in microseconds
+   *
+   * Sleeps with clock_nanosleep(TIMER_ABSTIME) until spin_us before the
+   * deadline, then spins on micros_impl() for the rest.
+   *
+   * @param us      Microseconds to delay
+   * @param spin_us Busy-wait tail in microseconds
+   */
+  static void delay_us_precise_impl(uint32_t us, uint32_t spin_us);
+
+  /**
+   * @brief Delay until micros_impl() reaches deadline_us
+   *
+   * Uses the same sleep-then-spin path with delay_spin_us().
+   *
+   * @param deadline_us Absolute deadline in micros_impl() time
+   */
+  static void delay_until_us_impl(uint64_t deadline_us);
+
+  /**
+   * @brief Start the software timer driver thread
+   *
+   * @param service Called whenever the deadline it last returned is due
+   * @return HAL_OK on success, HAL_ERR_NOMEM if the thread cannot start
+   */
+  static int timer_service_start_impl(uint64_t (*service)());
+
+  /**
+   * @brief Wake the software timer driver for an immediate service pass
+   */
+  static void timer_service_kick_impl();
+
   /* ======================================================================= */
   /* Console I/O Implementation                                              */
   /* ======================================================================= */
@@ -188,7 +563,8 @@ struct PosixPlatform
   /**
    * @brief Write data to console output
    *
-   * Uses write(STDOUT_FILENO).
+   * Uses write(STDOUT_FILENO), or copies into the console ring in
+   * HAL_CONSOLE_BUFFERED mode.
    *
    * @param buf Data buffer
    * @param len Number of bytes to write
@@ -199,7 +575,8 @@ struct PosixPlatform
   /**
    * @brief Read data from console input
    *
-   * Uses read(STDIN_FILENO). Blocking read.
+   * Uses read(STDIN_FILENO). Blocking read. Flushes buffered output
+   * first so prompts appear before the read blocks.
    *
    * @param buf Destination buffer
    * @param len Maximum bytes to read
@@ -207,23 +584,162 @@ struct PosixPlatform
    */
   static int console_read_impl(uint8_t* buf, size_t len);
 
+  /**
+   * @brief Select the console output mode
+   *
+   * HAL_CONSOLE_BUFFERED starts the flusher thread on first use; it
+   * drains the ring with write(STDOUT_FILENO) at most
+   * V4_HAL_POSIX_CONSOLE_FLUSH_US after a write.
+   *
+   * @param mode Output mode
+   * @return HAL_OK on success, HAL_ERR_NOMEM if the thread cannot start
+   */
+  static int console_set_mode_impl(hal_console_mode_t mode);
+
+  /**
+   * @brief Wait until the flusher has written every buffered byte
+   *
+   * @return HAL_OK
+   */
+  static int console_flush_impl();
+
   /* ======================================================================= */
   /* Interrupt Control Implementation                                        */
   /* ======================================================================= */
 
+  /**
+   * @brief The critical section is a futex lock, so holders may block
+   */
+  static constexpr bool critical_allows_blocking()
+  {
+    return true;
+  }
+
   /**
    * @brief Enter critical section
    *
-   * Uses pthread_mutex for thread safety on POSIX systems.
+   * Recursive lock: the owning thread may enter again, and must exit as
+   * often as it entered. Uncontended, entering is one CAS; contended, it
+   * spins adaptively and then sleeps on a futex. Contention is charged to
+   * the caller of this function.
    */
   static void critical_enter_impl();
 
+  /**
+   * @brief Enter critical section on behalf of a call site
+   *
+   * @param site Address charged with any contention (e.g. a return address)
+   */
+  static void critical_enter_impl(const void* site);
+
   /**
    * @brief Exit critical section
    *
-   * Releases pthread_mutex.
+   * Releases the lock when the outermost enter is matched, waking one
+   * sleeping waiter if there is any.
    */
   static void critical_exit_impl();
+
+  /**
+   * @brief Read contention counters
+   *
+   * @param stats Receives the counters
+   * @return HAL_OK
+   */
+  static int critical_stats_impl(hal_critical_stats_t* stats);
+
+  /**
+   * @brief Copy out contended call sites, most contended first
+   *
+   * @param sites Output array
+   * @param max Capacity of sites
+   * @return Number of entries written
+   */
+  static size_t critical_sites_impl(hal_critical_site_t* sites, size_t max);
+
+  /**
+   * @brief Clear contention counters and call sites
+   */
+  static void critical_stats_reset_impl();
+
+  /**
+   * @brief Initialize a lock as an unlocked futex
+   *
+   * @param lock Lock to initialize
+   */
+  static void lock_init_impl(hal_lock_t* lock);
+
+  /**
+   * @brief Acquire a lock
+   *
+   * Same algorithm as critical_enter_impl() on the lock's own futex
+   * word; contended acquisitions increment lock->contended.
+   *
+   * @param lock Initialized lock
+   */
+  static void lock_acquire_impl(hal_lock_t* lock);
+
+  /**
+   * @brief Release a lock
+   *
+   * @param lock Lock held by the caller
+   */
+  static void lock_release_impl(hal_lock_t* lock);
+
+  /* ======================================================================= */
+  /* Context Implementation                                                  */
+  /* ======================================================================= */
+
+  /**
+   * @brief Allocate a simulated board from the context arena
+   *
+   * @return New context, nullptr if out of memory
+   */
+  static hal_context_t* context_create_impl();
+
+  /**
+   * @brief Take the context off the interrupt dispatcher, stop its
+   *        recorder and replay, and return it to the arena
+   *
+   * @param ctx Context from context_create_impl()
+   * @return HAL_OK on success, HAL_ERR_BUSY if bound to any thread or
+   *         still holding UART handles (other than UART_INIT ones) or
+   *         software timers
+   */
+  static int context_destroy_impl(hal_context_t* ctx);
+
+  /**
+   * @brief Keep ctx from being destroyed while an object created in it
+   *        (a software timer) exists
+   */
+  static void context_retain_impl(hal_context_t* ctx);
+
+  /**
+   * @brief Drop a reference taken with context_retain_impl()
+   */
+  static void context_release_impl(hal_context_t* ctx);
+
+  /**
+   * @brief UART_INIT handle table of the calling thread's context
+   *
+   * max_uart_ports() entries, indexed by port. hal_context_destroy()
+   * closes the handles left in it.
+   */
+  static hal_handle_t* context_sys_uart_impl();
+
+  /**
+   * @brief Bind the calling thread to ctx (nullptr = default context)
+   *
+   * The binding keeps ctx from being destroyed until the thread rebinds.
+   *
+   * @return Previous binding
+   */
+  static hal_context_t* context_bind_impl(hal_context_t* ctx);
+
+  /**
+   * @brief Context bound to the calling thread (nullptr = default)
+   */
+  static hal_context_t* context_current_impl();
 };
 
 }  // namespace hal
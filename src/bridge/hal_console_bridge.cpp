@@ -6,8 +6,17 @@
  *
  * Bridges between C API (hal.h) and C++17 internal implementation.
  * Platform selection is done at compile time via preprocessor macros.
+ *
+ * Optional platform hooks (detected at compile time):
+ * - static int console_set_mode_impl(hal_console_mode_t mode)
+ * - static int console_flush_impl()
+ *     Buffered console output; without them only HAL_CONSOLE_DIRECT exists
  */
 
+#include <type_traits>
+
+#include "v4/hal_error.h"
+
 // Platform selection (compile-time)
 #ifdef HAL_PLATFORM_POSIX
 #include "../../ports/posix/platform_posix.hpp"
@@ -23,6 +32,23 @@ using Platform = v4::hal::Ch32v203Platform;
     "No HAL platform defined. Define HAL_PLATFORM_POSIX, HAL_PLATFORM_ESP32, or HAL_PLATFORM_CH32V203."
 #endif
 
+namespace
+{
+
+template <typename P, typename = void>
+struct has_console_buffer_impl : std::false_type
+{
+};
+
+template <typename P>
+struct has_console_buffer_impl<
+    P, std::void_t<decltype(P::console_set_mode_impl(HAL_CONSOLE_DIRECT))>>
+    : std::true_type
+{
+};
+
+}  // namespace
+
 /* ========================================================================= */
 /* extern "C" Console I/O API Implementation                                 */
 /* ========================================================================= */
@@ -39,4 +65,23 @@ extern "C"
     return Platform::console_read_impl(buf, len);
   }
 
+  int hal_console_set_mode(hal_console_mode_t mode)
+  {
+    if (mode != HAL_CONSOLE_DIRECT && mode != HAL_CONSOLE_BUFFERED)
+      return HAL_ERR_PARAM;
+
+    if constexpr (has_console_buffer_impl<Platform>::value)
+      return Platform::console_set_mode_impl(mode);
+    else
+      return mode == HAL_CONSOLE_DIRECT ? HAL_OK : HAL_ERR_NOTSUP;
+  }
+
+  int hal_console_flush(void)
+  {
+    if constexpr (has_console_buffer_impl<Platform>::value)
+      return Platform::console_flush_impl();
+    else
+      return HAL_OK;
+  }
+
 }  // extern "C"
@@ -0,0 +1,99 @@
+#include "v4/hal.h"
+
+/**
+ * @file hal_context_bridge.cpp
+ * @brief extern "C" bridge for simulation contexts
+ *
+ * Bridges between C API (hal.h) and C++17 internal implementation.
+ * Platform selection is done at compile time via preprocessor macros.
+ *
+ * Optional platform hooks (detected at compile time):
+ * - static hal_context_t* context_create_impl()
+ * - static int context_destroy_impl(hal_context_t* ctx)
+ * - static hal_context_t* context_bind_impl(hal_context_t* ctx)
+ * - static hal_context_t* context_current_impl()
+ *     Several simulated boards per process; without them there is only
+ *     the default context
+ */
+
+#include <type_traits>
+
+#include "v4/hal_error.h"
+
+// Platform selection (compile-time)
+#ifdef HAL_PLATFORM_POSIX
+#include "../../ports/posix/platform_posix.hpp"
+using Platform = v4::hal::PosixPlatform;
+#elif defined(HAL_PLATFORM_ESP32)
+#include "../../ports/esp32/platform_esp32.hpp"
+using Platform = v4::hal::Esp32Platform;
+#elif defined(HAL_PLATFORM_CH32V203)
+#include "../../ports/ch32v203/platform_ch32v203.hpp"
+using Platform = v4::hal::Ch32v203Platform;
+#else
+#error \
+    "No HAL platform defined. Define HAL_PLATFORM_POSIX, HAL_PLATFORM_ESP32, or HAL_PLATFORM_CH32V203."
+#endif
+
+namespace
+{
+
+// Detected through context_create_impl; the other hooks come with it
+template <typename P, typename = void>
+struct has_context_impl : std::false_type
+{
+};
+
+template <typename P>
+struct has_context_impl<P, std::void_t<decltype(P::context_create_impl())>>
+    : std::true_type
+{
+};
+
+}  // namespace
+
+/* ========================================================================= */
+/* extern "C" Context API Implementation                                     */
+/* ========================================================================= */
+
+extern "C"
+{
+  hal_context_t* hal_context_create(void)
+  {
+    if constexpr (has_context_impl<Platform>::value)
+      return Platform::context_create_impl();
+    else
+      return nullptr;
+  }
+
+  int hal_context_destroy(hal_context_t* ctx)
+  {
+    if (!ctx)
+      return HAL_ERR_PARAM;
+
+    if constexpr (has_context_impl<Platform>::value)
+      return Platform::context_destroy_impl(ctx);
+    else
+      return HAL_ERR_NOTSUP;
+  }
+
+  hal_context_t* hal_context_bind(hal_context_t* ctx)
+  {
+    if constexpr (has_context_impl<Platform>::value)
+      return Platform::context_bind_impl(ctx);
+    else
+    {
+      (void)ctx;
+      return nullptr;
+    }
+  }
+
+  hal_context_t* hal_context_current(void)
+  {
+    if constexpr (has_context_impl<Platform>::value)
+      return Platform::context_current_impl();
+    else
+      return nullptr;
+  }
+
+}  // extern "C"
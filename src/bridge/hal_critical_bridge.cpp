@@ -1,22 +1,42 @@
+#include "v4/hal.h"
+
 /**
  * @file hal_critical_bridge.cpp
- * @brief C-language bridge for critical section API
+ * @brief extern "C" bridge for critical section and lock operations
  *
- * Provides C-compatible wrappers for C++ critical section implementation.
+ * Bridges between C API (hal.h) and C++17 internal implementation.
+ * Platform selection is done at compile time via preprocessor macros.
  */
 
-#include "v4/hal.h"
-#include "v4/hal_platform.hpp"
-#include "v4/internal/critical_impl.hpp"
+#include "../internal/critical_impl.hpp"
+
+// Platform selection (compile-time)
+#ifdef HAL_PLATFORM_POSIX
+#include "../../ports/posix/platform_posix.hpp"
+using Platform = v4::hal::PosixPlatform;
+#elif defined(HAL_PLATFORM_ESP32)
+#include "../../ports/esp32/platform_esp32.hpp"
+using Platform = v4::hal::Esp32Platform;
+#elif defined(HAL_PLATFORM_CH32V203)
+#include "../../ports/ch32v203/platform_ch32v203.hpp"
+using Platform = v4::hal::Ch32v203Platform;
+#else
+#error \
+    "No HAL platform defined. Define HAL_PLATFORM_POSIX, HAL_PLATFORM_ESP32, or HAL_PLATFORM_CH32V203."
+#endif
 
-using Platform = HAL_PLATFORM_TYPE;
 using Critical = v4::hal::CriticalImpl<Platform>;
 
+/* ========================================================================= */
+/* extern "C" Critical Section API Implementation                            */
+/* ========================================================================= */
+
 extern "C"
 {
   void hal_critical_enter(void)
   {
-    Critical::critical_enter();
+    // The caller's address attributes contention to its call site
+    Critical::critical_enter(__builtin_return_address(0));
   }
 
   void hal_critical_exit(void)
@@ -24,4 +44,34 @@ extern "C"
     Critical::critical_exit();
   }
 
+  int hal_critical_stats(hal_critical_stats_t* stats)
+  {
+    return Critical::stats(stats);
+  }
+
+  size_t hal_critical_sites(hal_critical_site_t* sites, size_t max)
+  {
+    return Critical::sites(sites, max);
+  }
+
+  void hal_critical_stats_reset(void)
+  {
+    Critical::stats_reset();
+  }
+
+  int hal_lock_init(hal_lock_t* lock, const char* name)
+  {
+    return Critical::lock_init(lock, name);
+  }
+
+  void hal_lock_acquire(hal_lock_t* lock)
+  {
+    Critical::lock_acquire(lock);
+  }
+
+  void hal_lock_release(hal_lock_t* lock)
+  {
+    Critical::lock_release(lock);
+  }
+
 }  // extern "C"
@@ -53,33 +53,55 @@ extern "C"
     return GpioImpl::toggle(pin);
   }
 
-  // GPIO interrupt stubs (not yet implemented)
+  int hal_gpio_write_mask(uint64_t set_mask, uint64_t clear_mask)
+  {
+    return GpioImpl::write_mask(set_mask, clear_mask);
+  }
+
+  int hal_gpio_read_port(uint64_t* value)
+  {
+    return GpioImpl::read_port(value);
+  }
+
+  int hal_gpio_mode_mask(uint64_t mask, hal_gpio_mode_t mode)
+  {
+    return GpioImpl::mode_mask(mask, mode);
+  }
+
+  int hal_gpio_write_bank(int bank, uint64_t set_mask, uint64_t clear_mask)
+  {
+    return GpioImpl::write_bank(bank, set_mask, clear_mask);
+  }
+
+  int hal_gpio_read_bank(int bank, uint64_t* value)
+  {
+    return GpioImpl::read_bank(bank, value);
+  }
+
+  int hal_gpio_mode_bank(int bank, uint64_t mask, hal_gpio_mode_t mode)
+  {
+    return GpioImpl::mode_bank(bank, mask, mode);
+  }
+
   int hal_gpio_irq_attach(int pin, hal_gpio_irq_edge_t edge,
                           hal_gpio_irq_handler_t handler, void* user_data)
   {
-    (void)pin;
-    (void)edge;
-    (void)handler;
-    (void)user_data;
-    return HAL_ERR_NOTSUP;  // Not supported yet
+    return GpioImpl::irq_attach(pin, edge, handler, user_data);
   }
 
   int hal_gpio_irq_detach(int pin)
   {
-    (void)pin;
-    return HAL_ERR_NOTSUP;
+    return GpioImpl::irq_detach(pin);
   }
 
   int hal_gpio_irq_enable(int pin)
   {
-    (void)pin;
-    return HAL_ERR_NOTSUP;
+    return GpioImpl::irq_enable(pin);
   }
 
   int hal_gpio_irq_disable(int pin)
   {
-    (void)pin;
-    return HAL_ERR_NOTSUP;
+    return GpioImpl::irq_disable(pin);
   }
 
 }  // extern "C"
@@ -53,4 +53,24 @@ extern "C"
     TimerImpl::delay_us(us);
   }
 
+  void hal_delay_us_precise(uint32_t us, uint32_t spin_us)
+  {
+    TimerImpl::delay_us_precise(us, spin_us);
+  }
+
+  void hal_delay_until_us(uint64_t deadline_us)
+  {
+    TimerImpl::delay_until_us(deadline_us);
+  }
+
+  int hal_timer_set_source(hal_clock_source_t source)
+  {
+    return TimerImpl::set_source(source);
+  }
+
+  hal_clock_source_t hal_timer_get_source(void)
+  {
+    return TimerImpl::source();
+  }
+
 }  // extern "C"
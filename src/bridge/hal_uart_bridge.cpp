@@ -48,11 +48,48 @@ extern "C"
     return UartImpl::write(handle, buf, len);
   }
 
+  int hal_uart_writev(hal_handle_t handle, const hal_iovec_t* iov, size_t iovcnt)
+  {
+    return UartImpl::writev(handle, iov, iovcnt);
+  }
+
+  int hal_uart_flush(hal_handle_t handle)
+  {
+    return UartImpl::flush(handle);
+  }
+
   int hal_uart_read(hal_handle_t handle, uint8_t* buf, size_t len)
   {
     return UartImpl::read(handle, buf, len);
   }
 
+  int hal_uart_read_timeout(hal_handle_t handle, uint8_t* buf, size_t len,
+                            uint32_t timeout_us)
+  {
+    return UartImpl::read_timeout(handle, buf, len, timeout_us);
+  }
+
+  int hal_uart_read_until(hal_handle_t handle, uint8_t* buf, size_t len,
+                          uint8_t delimiter, uint32_t timeout_us)
+  {
+    return UartImpl::read_until(handle, buf, len, delimiter, timeout_us);
+  }
+
+  int hal_uart_readv(hal_handle_t handle, const hal_iovec_t* iov, size_t iovcnt)
+  {
+    return UartImpl::readv(handle, iov, iovcnt);
+  }
+
+  int hal_uart_rx_peek(hal_handle_t handle, const uint8_t** data, size_t* len)
+  {
+    return UartImpl::rx_peek(handle, data, len);
+  }
+
+  int hal_uart_rx_consume(hal_handle_t handle, size_t len)
+  {
+    return UartImpl::rx_consume(handle, len);
+  }
+
   int hal_uart_available(hal_handle_t handle)
   {
     return UartImpl::available(handle);
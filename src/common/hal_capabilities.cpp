@@ -16,7 +16,8 @@
  *
  * @return Pointer to platform capability structure
  */
-__attribute__((weak)) const hal_capabilities_t* hal_platform_capabilities(void)
+extern "C" __attribute__((weak)) const hal_capabilities_t* hal_platform_capabilities(
+    void)
 {
   static const hal_capabilities_t default_caps = {
       0,  // gpio_count
@@ -28,6 +29,7 @@ __attribute__((weak)) const hal_capabilities_t* hal_platform_capabilities(void)
       0,  // has_pwm
       0,  // has_rtc
       0,  // has_dma
+      0,  // has_contexts
       0,  // reserved
   };
   return &default_caps;
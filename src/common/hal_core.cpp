@@ -24,7 +24,7 @@
  *
  * @return HAL_OK on success, negative error code on failure
  */
-__attribute__((weak)) int hal_platform_init(void)
+extern "C" __attribute__((weak)) int hal_platform_init(void)
 {
   return HAL_OK;
 }
@@ -39,7 +39,7 @@ __attribute__((weak)) int hal_platform_init(void)
  *
  * @return HAL_OK on success, negative error code on failure
  */
-__attribute__((weak)) int hal_platform_reset(void)
+extern "C" __attribute__((weak)) int hal_platform_reset(void)
 {
   return HAL_OK;
 }
@@ -52,7 +52,7 @@ __attribute__((weak)) int hal_platform_reset(void)
  *
  * Default implementation does nothing.
  */
-__attribute__((weak)) void hal_platform_deinit(void)
+extern "C" __attribute__((weak)) void hal_platform_deinit(void)
 {
   // Default: no-op
 }
@@ -0,0 +1,163 @@
+/**
+ * @file hal_queue.cpp
+ * @brief Lock-free queue C API (hal_queue_* functions)
+ *
+ * Runtime-sized counterpart of SpscQueue/MpscQueue in
+ * src/internal/queue.hpp, working on caller-provided storage. Each slot
+ * is a 32-bit sequence number followed by the element; SPSC queues
+ * ignore the sequence numbers, MPSC queues use them to publish slots as
+ * in MpscQueue.
+ */
+
+#include <atomic>
+#include <cstring>
+
+#include "v4/hal.h"
+#include "v4/hal_error.h"
+
+namespace
+{
+
+using Index = std::atomic<uint32_t>;
+
+static_assert(sizeof(Index) == sizeof(uint32_t) && Index::is_always_lock_free,
+              "queue indices must be plain 32-bit integers");
+
+inline Index& head_of(hal_queue_t* q)
+{
+  return *reinterpret_cast<Index*>(&q->head);
+}
+
+inline Index& tail_of(hal_queue_t* q)
+{
+  return *reinterpret_cast<Index*>(&q->tail);
+}
+
+inline Index& sequence_of(hal_queue_t* q, uint32_t pos)
+{
+  return *reinterpret_cast<Index*>(q->slots + (pos & q->mask) * q->slot_size);
+}
+
+inline uint8_t* item_of(hal_queue_t* q, uint32_t pos)
+{
+  return q->slots + (pos & q->mask) * q->slot_size + sizeof(uint32_t);
+}
+
+int spsc_push(hal_queue_t* q, const void* item)
+{
+  uint32_t head = head_of(q).load(std::memory_order_relaxed);
+  if (head - tail_of(q).load(std::memory_order_acquire) > q->mask)
+    return 0;
+  std::memcpy(item_of(q, head), item, q->elem_size);
+  head_of(q).store(head + 1, std::memory_order_release);
+  return 1;
+}
+
+int spsc_pop(hal_queue_t* q, void* item)
+{
+  uint32_t tail = tail_of(q).load(std::memory_order_relaxed);
+  if (head_of(q).load(std::memory_order_acquire) == tail)
+    return 0;
+  std::memcpy(item, item_of(q, tail), q->elem_size);
+  tail_of(q).store(tail + 1, std::memory_order_release);
+  return 1;
+}
+
+int mpsc_push(hal_queue_t* q, const void* item)
+{
+  uint32_t pos = head_of(q).load(std::memory_order_relaxed);
+  for (;;)
+  {
+    auto diff =
+        static_cast<int32_t>(sequence_of(q, pos).load(std::memory_order_acquire) - pos);
+    if (diff == 0)
+    {
+      if (head_of(q).compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+        break;
+    }
+    else if (diff < 0)
+    {
+      return 0;  // Consumer has not freed this slot yet
+    }
+    else
+    {
+      pos = head_of(q).load(std::memory_order_relaxed);  // Another producer took it
+    }
+  }
+
+  std::memcpy(item_of(q, pos), item, q->elem_size);
+  sequence_of(q, pos).store(pos + 1, std::memory_order_release);
+  return 1;
+}
+
+int mpsc_pop(hal_queue_t* q, void* item)
+{
+  uint32_t pos = tail_of(q).load(std::memory_order_relaxed);
+  if (sequence_of(q, pos).load(std::memory_order_acquire) != pos + 1)
+    return 0;
+
+  std::memcpy(item, item_of(q, pos), q->elem_size);
+  sequence_of(q, pos).store(pos + q->mask + 1, std::memory_order_release);
+  tail_of(q).store(pos + 1, std::memory_order_release);
+  return 1;
+}
+
+}  // namespace
+
+/* ========================================================================= */
+/* extern "C" Queue API Implementation                                       */
+/* ========================================================================= */
+
+extern "C"
+{
+  int hal_queue_init(hal_queue_t* queue, hal_queue_mode_t mode, void* storage,
+                     size_t elem_size, size_t capacity)
+  {
+    if (!queue || !storage || elem_size == 0 || elem_size > UINT32_MAX / 2)
+      return HAL_ERR_PARAM;
+    if (capacity < 2 || (capacity & (capacity - 1)) != 0 || capacity > (size_t{1} << 31))
+      return HAL_ERR_PARAM;
+    if (reinterpret_cast<uintptr_t>(storage) % alignof(uint32_t) != 0)
+      return HAL_ERR_PARAM;
+    if (mode != HAL_QUEUE_SPSC && mode != HAL_QUEUE_MPSC)
+      return HAL_ERR_PARAM;
+
+    std::memset(queue, 0, sizeof(*queue));
+    queue->slots = static_cast<uint8_t*>(storage);
+    queue->slot_size = HAL_QUEUE_SLOT_SIZE(static_cast<uint32_t>(elem_size));
+    queue->elem_size = static_cast<uint32_t>(elem_size);
+    queue->mask = static_cast<uint32_t>(capacity - 1);
+    queue->mode = mode;
+
+    for (uint32_t i = 0; i < capacity; i++)
+      sequence_of(queue, i).store(i, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    return HAL_OK;
+  }
+
+  int hal_queue_push(hal_queue_t* queue, const void* item)
+  {
+    if (!queue || !item)
+      return HAL_ERR_PARAM;
+    return (queue->mode == HAL_QUEUE_MPSC) ? mpsc_push(queue, item)
+                                           : spsc_push(queue, item);
+  }
+
+  int hal_queue_pop(hal_queue_t* queue, void* item)
+  {
+    if (!queue || !item)
+      return HAL_ERR_PARAM;
+    return (queue->mode == HAL_QUEUE_MPSC) ? mpsc_pop(queue, item)
+                                           : spsc_pop(queue, item);
+  }
+
+  size_t hal_queue_size(const hal_queue_t* queue)
+  {
+    if (!queue)
+      return 0;
+    auto* q = const_cast<hal_queue_t*>(queue);
+    uint32_t tail = tail_of(q).load(std::memory_order_acquire);  // Before head
+    return head_of(q).load(std::memory_order_acquire) - tail;
+  }
+
+}  // extern "C"
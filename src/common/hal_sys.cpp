@@ -0,0 +1,287 @@
+/**
+ * @file hal_sys.cpp
+ * @brief SYS dispatch table for V4 HAL
+ *
+ * Each handler adapts one hal_* call to the cell convention described in
+ * hal_sys.h. The table is a constant expression built from hal_sys.def,
+ * so it lives in read-only memory and duplicate ids fail to compile.
+ * hal_submit_batch() runs a sequence of table entries, holding the
+ * critical section between delays where the platform allows blocking in
+ * it.
+ */
+
+#include "v4/hal_sys.h"
+
+#include <cstring>
+#include <type_traits>
+
+#include "../internal/critical_impl.hpp"
+#include "v4/hal.h"
+#include "v4/hal_error.h"
+
+// Platform selection (compile-time)
+#ifdef HAL_PLATFORM_POSIX
+#include "../../ports/posix/platform_posix.hpp"
+using Platform = v4::hal::PosixPlatform;
+#elif defined(HAL_PLATFORM_ESP32)
+#include "../../ports/esp32/platform_esp32.hpp"
+using Platform = v4::hal::Esp32Platform;
+#elif defined(HAL_PLATFORM_CH32V203)
+#include "../../ports/ch32v203/platform_ch32v203.hpp"
+using Platform = v4::hal::Ch32v203Platform;
+#else
+#error \
+    "No HAL platform defined. Define HAL_PLATFORM_POSIX, HAL_PLATFORM_ESP32, or HAL_PLATFORM_CH32V203."
+#endif
+
+namespace
+{
+
+using Critical = v4::hal::CriticalImpl<Platform>;
+
+#define HAL_SYS(name, sys_id, pops, pushes, effect)                     \
+  static_assert(pops <= HAL_SYS_MAX_CELLS && pushes <= HAL_SYS_MAX_CELLS, \
+                #name " exceeds HAL_SYS_MAX_CELLS");
+#include "v4/hal_sys.def"
+#undef HAL_SYS
+
+constexpr int kSysUartPorts = Platform::max_uart_ports();
+
+template <typename P, typename = void>
+struct has_context_sys_uart_impl : std::false_type
+{
+};
+
+template <typename P>
+struct has_context_sys_uart_impl<P, std::void_t<decltype(P::context_sys_uart_impl())>>
+    : std::true_type
+{
+};
+
+// Handles opened by UART_INIT, indexed by port. Platforms with contexts
+// keep one table per context, so VMs on different boards never share one.
+hal_handle_t* sys_uart_table()
+{
+  if constexpr (has_context_sys_uart_impl<Platform>::value)
+  {
+    return Platform::context_sys_uart_impl();
+  }
+  else
+  {
+    static hal_handle_t table[kSysUartPorts];
+    return table;
+  }
+}
+
+hal_handle_t sys_uart_handle(hal_sys_cell_t port)
+{
+  return (port >= 0 && port < kSysUartPorts) ? sys_uart_table()[port] : nullptr;
+}
+
+/* ========================================================================= */
+/* Handlers (named sys_<name> after hal_sys.def)                             */
+/* ========================================================================= */
+
+void sys_GPIO_INIT(hal_sys_cell_t* args)
+{
+  // SYS numbering differs from hal_gpio_mode_t
+  static constexpr hal_gpio_mode_t kModes[] = {HAL_GPIO_INPUT, HAL_GPIO_OUTPUT,
+                                               HAL_GPIO_INPUT_PULLUP,
+                                               HAL_GPIO_INPUT_PULLDOWN};
+  hal_sys_cell_t mode = args[1];
+  if (mode < 0 || mode >= static_cast<hal_sys_cell_t>(sizeof(kModes) / sizeof(kModes[0])))
+    args[0] = HAL_ERR_PARAM;
+  else
+    args[0] = hal_gpio_mode(args[0], kModes[mode]);
+}
+
+void sys_GPIO_WRITE(hal_sys_cell_t* args)
+{
+  args[0] = hal_gpio_write(args[0], args[1] ? HAL_GPIO_HIGH : HAL_GPIO_LOW);
+}
+
+void sys_GPIO_READ(hal_sys_cell_t* args)
+{
+  hal_gpio_value_t value = HAL_GPIO_LOW;
+  int err = hal_gpio_read(args[0], &value);
+  args[0] = value;
+  args[1] = err;
+}
+
+void sys_UART_INIT(hal_sys_cell_t* args)
+{
+  hal_sys_cell_t port = args[0];
+  if (port < 0 || port >= kSysUartPorts || args[1] <= 0)
+  {
+    args[0] = HAL_ERR_PARAM;
+    return;
+  }
+
+  hal_handle_t* sys_uart = sys_uart_table();
+  if (sys_uart[port])
+  {
+    hal_uart_close(sys_uart[port]);
+    sys_uart[port] = nullptr;
+  }
+
+  hal_uart_config_t config = {};
+  config.baudrate = args[1];
+  config.data_bits = 8;
+  config.stop_bits = 1;
+  sys_uart[port] = hal_uart_open(port, &config);
+  args[0] = sys_uart[port] ? HAL_OK : HAL_ERR_NODEV;
+}
+
+void sys_UART_PUTC(hal_sys_cell_t* args)
+{
+  hal_handle_t uart = sys_uart_handle(args[0]);
+  if (!uart)
+  {
+    args[0] = HAL_ERR_NODEV;
+    return;
+  }
+
+  uint8_t c = static_cast<uint8_t>(args[1]);
+  int ret = hal_uart_write(uart, &c, 1);
+  args[0] = (ret < 0) ? ret : (ret == 1) ? HAL_OK : HAL_ERR_BUSY;
+}
+
+void sys_UART_GETC(hal_sys_cell_t* args)
+{
+  hal_handle_t uart = sys_uart_handle(args[0]);
+  uint8_t c = 0;
+  int ret = uart ? hal_uart_read(uart, &c, 1) : HAL_ERR_NODEV;
+  args[0] = c;
+  args[1] = (ret < 0) ? ret : (ret == 1) ? HAL_OK : HAL_ERR_TIMEOUT;  // No data
+}
+
+void sys_MILLIS(hal_sys_cell_t* args)
+{
+  args[0] = static_cast<hal_sys_cell_t>(hal_millis());
+}
+
+void sys_MICROS(hal_sys_cell_t* args)
+{
+  uint64_t us = hal_micros();
+  args[0] = static_cast<hal_sys_cell_t>(static_cast<uint32_t>(us));
+  args[1] = static_cast<hal_sys_cell_t>(static_cast<uint32_t>(us >> 32));
+}
+
+void sys_DELAY_MS(hal_sys_cell_t* args)
+{
+  if (args[0] > 0)
+    hal_delay_ms(static_cast<uint32_t>(args[0]));
+}
+
+void sys_DELAY_US(hal_sys_cell_t* args)
+{
+  if (args[0] > 0)
+    hal_delay_us(static_cast<uint32_t>(args[0]));
+}
+
+void sys_SYSTEM_RESET(hal_sys_cell_t*)
+{
+  hal_reset();
+}
+
+// Delays give up a batch's critical section instead of stalling every
+// other hal_critical_enter() caller for their duration
+constexpr bool sys_blocks(uint8_t id)
+{
+  return id == HAL_SYS_DELAY_MS || id == HAL_SYS_DELAY_US;
+}
+
+/* ========================================================================= */
+/* Table construction                                                        */
+/* ========================================================================= */
+
+constexpr hal_sys_entry_t sys_entry(unsigned id)
+{
+  switch (id)
+  {
+#define HAL_SYS(name, sys_id, pops, pushes, effect) \
+  case sys_id:                                      \
+    return {sys_##name, pops, pushes, #name, effect};
+#include "v4/hal_sys.def"
+#undef HAL_SYS
+    default:
+      return {nullptr, 0, 0, nullptr, nullptr};
+  }
+}
+
+}  // namespace
+
+// 256 sys_entry() calls, one per id
+#define HAL_SYS_ROW4(n) sys_entry(n), sys_entry(n + 1), sys_entry(n + 2), sys_entry(n + 3)
+#define HAL_SYS_ROW16(n) \
+  HAL_SYS_ROW4(n), HAL_SYS_ROW4(n + 4), HAL_SYS_ROW4(n + 8), HAL_SYS_ROW4(n + 12)
+#define HAL_SYS_ROW64(n) \
+  HAL_SYS_ROW16(n), HAL_SYS_ROW16(n + 16), HAL_SYS_ROW16(n + 32), HAL_SYS_ROW16(n + 48)
+
+// Declared extern in hal_sys.h; constexpr guarantees constant initialization
+constexpr hal_sys_entry_t hal_sys_table[256] = {HAL_SYS_ROW64(0u), HAL_SYS_ROW64(64u),
+                                                HAL_SYS_ROW64(128u), HAL_SYS_ROW64(192u)};
+
+#undef HAL_SYS_ROW64
+#undef HAL_SYS_ROW16
+#undef HAL_SYS_ROW4
+
+extern "C"
+{
+  int hal_sys_call(uint8_t id, hal_sys_cell_t* args)
+  {
+    const hal_sys_entry_t& entry = hal_sys_table[id];
+    if (!entry.fn)
+      return HAL_ERR_NOTSUP;
+    entry.fn(args);
+    return HAL_OK;
+  }
+
+  int hal_submit_batch(const hal_op_t* ops, size_t n, hal_sys_cell_t* results)
+  {
+    if (n == 0)
+      return 0;
+    if (!ops || !results)
+      return HAL_ERR_PARAM;
+
+    for (size_t i = 0; i < n; i++)
+    {
+      if (!hal_sys_table[ops[i].sys].fn)
+        return HAL_ERR_NOTSUP;
+    }
+
+    if constexpr (Critical::allows_blocking())
+      Critical::critical_enter(__builtin_return_address(0));
+
+    hal_sys_cell_t* out = results;
+    for (size_t i = 0; i < n; i++)
+    {
+      const hal_sys_entry_t& entry = hal_sys_table[ops[i].sys];
+      hal_sys_cell_t cells[HAL_SYS_MAX_CELLS];
+      std::memcpy(cells, ops[i].args, sizeof(cells));
+      if constexpr (Critical::allows_blocking())
+      {
+        if (sys_blocks(ops[i].sys))
+        {
+          Critical::critical_exit();
+          entry.fn(cells);
+          Critical::critical_enter(__builtin_return_address(0));
+        }
+        else
+        {
+          entry.fn(cells);
+        }
+      }
+      else
+      {
+        entry.fn(cells);
+      }
+      std::memcpy(out, cells, entry.out * sizeof(hal_sys_cell_t));
+      out += entry.out;
+    }
+
+    if constexpr (Critical::allows_blocking())
+      Critical::critical_exit();
+    return static_cast<int>(out - results);
+  }
+}
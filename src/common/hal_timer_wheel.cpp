@@ -0,0 +1,350 @@
+#include "v4/hal.h"
+
+/**
+ * @file hal_timer_wheel.cpp
+ * @brief Software timers (hal_timer_* API)
+ *
+ * Keeps every software timer in one hierarchical TimerWheel whose tick is
+ * V4_HAL_TIMER_TICK_US microseconds of TimerBase<Platform>::micros().
+ * The platform supplies a single driver context (a POSIX thread, an
+ * esp_timer callback) that calls timer_service() when the earliest
+ * deadline is due; the service advances the wheel, re-arms periodic
+ * timers and runs the callbacks outside the wheel lock so they may start
+ * or stop timers themselves. Each callback runs bound to the context
+ * (hal_context_bind()) its timer was created in.
+ *
+ * Platform requirements (hal_timer_create() returns NULL without them):
+ * - static int timer_service_start_impl(uint64_t (*service)())
+ *     Start the driver once. It must call service() when the deadline it
+ *     returned (micros() time, UINT64_MAX = none) is reached.
+ * - static void timer_service_kick_impl()
+ *     Make the driver call service() as soon as possible.
+ *
+ * Optional, with contexts:
+ * - static void context_retain_impl(hal_context_t* ctx)
+ * - static void context_release_impl(hal_context_t* ctx)
+ *     Pin the creator's context until the timer is freed, so it cannot
+ *     be destroyed (and reused) under a pending callback.
+ *
+ * The wheel is guarded by its own hal_lock_t, so timer traffic does not
+ * contend with the global critical section. A callback may
+ * still be running when hal_timer_stop()/hal_timer_delete() return on
+ * another thread.
+ */
+
+#include <new>
+#include <type_traits>
+
+#include "../internal/critical_impl.hpp"
+#include "../internal/timer_impl.hpp"
+#include "../internal/timer_wheel.hpp"
+#include "v4/hal_error.h"
+
+// Platform selection (compile-time)
+#ifdef HAL_PLATFORM_POSIX
+#include "../../ports/posix/platform_posix.hpp"
+using Platform = v4::hal::PosixPlatform;
+#elif defined(HAL_PLATFORM_ESP32)
+#include "../../ports/esp32/platform_esp32.hpp"
+using Platform = v4::hal::Esp32Platform;
+#elif defined(HAL_PLATFORM_CH32V203)
+#include "../../ports/ch32v203/platform_ch32v203.hpp"
+using Platform = v4::hal::Ch32v203Platform;
+#else
+#error \
+    "No HAL platform defined. Define HAL_PLATFORM_POSIX, HAL_PLATFORM_ESP32, or HAL_PLATFORM_CH32V203."
+#endif
+
+#ifndef V4_HAL_TIMER_TICK_US
+#define V4_HAL_TIMER_TICK_US 1000
+#endif
+
+namespace
+{
+
+using v4::hal::TimerWheel;
+using v4::hal::TimerWheelNode;
+using TimerImpl = v4::hal::TimerBase<Platform>;
+using Critical = v4::hal::CriticalImpl<Platform>;
+
+constexpr uint64_t kTickUs = V4_HAL_TIMER_TICK_US;
+static_assert(kTickUs > 0, "V4_HAL_TIMER_TICK_US must be positive");
+
+template <typename P, typename = void>
+struct has_timer_service_impl : std::false_type
+{
+};
+
+template <typename P>
+struct has_timer_service_impl<
+    P, std::void_t<decltype(P::timer_service_start_impl(nullptr))>> : std::true_type
+{
+};
+
+template <typename P, typename = void>
+struct has_context_retain_impl : std::false_type
+{
+};
+
+template <typename P>
+struct has_context_retain_impl<P, std::void_t<decltype(P::context_retain_impl(nullptr))>>
+    : std::true_type
+{
+};
+
+struct SoftTimer : TimerWheelNode
+{
+  hal_timer_callback_t callback;
+  void* user_data;
+  hal_context_t* context;  // Bound while the callback runs
+  uint64_t period_ticks;  // 0 = one-shot
+  uint32_t generation;    // Bumped by start/stop; stale expiries are dropped
+  uint32_t fire_generation;
+  SoftTimer* fire_next;
+  bool firing;
+  bool deleted;
+};
+
+struct TimerService
+{
+  TimerWheel wheel;
+  uint64_t armed_us = TimerWheel::kNever;  // Deadline the driver sleeps towards
+  bool started = false;
+};
+
+TimerService service;
+
+// Free a timer once neither the API nor the service refers to it
+void timer_free(SoftTimer* t)
+{
+  if constexpr (has_context_retain_impl<Platform>::value)
+  {
+    if (t->context)
+      Platform::context_release_impl(t->context);
+  }
+  delete t;
+}
+
+hal_lock_t* wheel_lock()
+{
+  static hal_lock_t lock = []()
+  {
+    hal_lock_t l;
+    Critical::lock_init(&l, "timer_wheel");
+    return l;
+  }();
+  return &lock;
+}
+
+class WheelLock
+{
+ public:
+  WheelLock()
+  {
+    Critical::lock_acquire(wheel_lock());
+  }
+  ~WheelLock()
+  {
+    Critical::lock_release(wheel_lock());
+  }
+  WheelLock(const WheelLock&) = delete;
+  WheelLock& operator=(const WheelLock&) = delete;
+};
+
+uint64_t tick_to_us(uint64_t tick)
+{
+  return tick == TimerWheel::kNever ? TimerWheel::kNever : tick * kTickUs;
+}
+
+// Called with the wheel lock held; returns the next driver deadline
+uint64_t rearm_locked()
+{
+  service.armed_us = tick_to_us(service.wheel.next_event());
+  return service.armed_us;
+}
+
+/**
+ * Driver entry point: expire due timers and run their callbacks.
+ *
+ * @return Next deadline in micros() time, UINT64_MAX if none
+ */
+uint64_t timer_service()
+{
+  SoftTimer* due = nullptr;
+  {
+    WheelLock lock;
+    uint64_t now_tick = TimerImpl::micros() / kTickUs;
+    TimerWheelNode* expired = nullptr;
+    service.wheel.advance(now_tick, &expired);
+
+    while (expired)
+    {
+      auto* t = static_cast<SoftTimer*>(expired);
+      expired = expired->next;
+
+      if (t->period_ticks)
+      {
+        // Keep the phase; skip periods that are already over
+        uint64_t next = t->expires + t->period_ticks;
+        if (next <= now_tick)
+          next += ((now_tick - next) / t->period_ticks + 1) * t->period_ticks;
+        service.wheel.insert(t, next);
+      }
+
+      t->firing = true;
+      t->fire_generation = t->generation;
+      t->fire_next = due;
+      due = t;
+    }
+  }
+
+  while (due)
+  {
+    SoftTimer* t = due;
+    due = due->fire_next;
+
+    bool run;
+    {
+      WheelLock lock;
+      run = !t->deleted && t->generation == t->fire_generation;
+    }
+    if (run)
+    {
+      hal_context_t* previous = hal_context_bind(t->context);
+      t->callback(t, t->user_data);
+      hal_context_bind(previous);
+    }
+
+    bool free_now;
+    {
+      WheelLock lock;
+      t->firing = false;
+      free_now = t->deleted;
+    }
+    if (free_now)
+      timer_free(t);
+  }
+
+  WheelLock lock;
+  return rearm_locked();
+}
+
+}  // namespace
+
+/* ========================================================================= */
+/* extern "C" Software Timer API Implementation                              */
+/* ========================================================================= */
+
+extern "C"
+{
+  hal_handle_t hal_timer_create(hal_timer_callback_t callback, void* user_data)
+  {
+    if (!callback)
+      return nullptr;
+
+    if constexpr (has_timer_service_impl<Platform>::value)
+    {
+      bool start = false;
+      {
+        WheelLock lock;
+        if (!service.started)
+        {
+          service.started = true;
+          start = true;
+        }
+      }
+      if (start && Platform::timer_service_start_impl(timer_service) != HAL_OK)
+      {
+        WheelLock lock;
+        service.started = false;
+        return nullptr;
+      }
+
+      auto* t = new (std::nothrow) SoftTimer();
+      if (!t)
+        return nullptr;
+      t->callback = callback;
+      t->user_data = user_data;
+      t->context = hal_context_current();
+      if constexpr (has_context_retain_impl<Platform>::value)
+      {
+        if (t->context)
+          Platform::context_retain_impl(t->context);
+      }
+      return t;
+    }
+    else
+    {
+      (void)user_data;
+      return nullptr;
+    }
+  }
+
+  int hal_timer_start(hal_handle_t timer, uint64_t timeout_us, uint64_t period_us)
+  {
+    if (!timer)
+      return HAL_ERR_PARAM;
+
+    auto* t = static_cast<SoftTimer*>(timer);
+    bool kick = false;
+    {
+      WheelLock lock;
+      if (t->deleted)
+        return HAL_ERR_PARAM;
+
+      // Round up so a timer never fires early
+      uint64_t deadline = TimerImpl::micros() + timeout_us;
+      uint64_t expires = (deadline + kTickUs - 1) / kTickUs;
+      service.wheel.remove(t);
+      service.wheel.reset(TimerImpl::micros() / kTickUs);  // Only if empty
+
+      t->period_ticks = period_us ? (period_us + kTickUs - 1) / kTickUs : 0;
+      t->generation++;
+      service.wheel.insert(t, expires);
+
+      if (tick_to_us(expires) < service.armed_us)
+      {
+        service.armed_us = tick_to_us(expires);
+        kick = true;
+      }
+    }
+
+    if constexpr (has_timer_service_impl<Platform>::value)
+    {
+      if (kick)
+        Platform::timer_service_kick_impl();
+    }
+    return HAL_OK;
+  }
+
+  int hal_timer_stop(hal_handle_t timer)
+  {
+    if (!timer)
+      return HAL_ERR_PARAM;
+
+    auto* t = static_cast<SoftTimer*>(timer);
+    WheelLock lock;
+    service.wheel.remove(t);
+    t->generation++;
+    return HAL_OK;
+  }
+
+  int hal_timer_delete(hal_handle_t timer)
+  {
+    if (!timer)
+      return HAL_ERR_PARAM;
+
+    auto* t = static_cast<SoftTimer*>(timer);
+    bool free_now;
+    {
+      WheelLock lock;
+      service.wheel.remove(t);
+      t->deleted = true;
+      free_now = !t->firing;  // Otherwise freed by the service after the callback
+    }
+    if (free_now)
+      timer_free(t);
+    return HAL_OK;
+  }
+
+}  // extern "C"
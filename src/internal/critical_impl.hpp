@@ -9,15 +9,88 @@
  * Platforms must implement:
  * - void critical_enter_impl()
  * - void critical_exit_impl()
+ *
+ * Optional (detected at compile time):
+ * - void critical_enter_impl(const void* site)
+ *     Enter on behalf of call site `site`, for contention attribution
+ * - int critical_stats_impl(hal_critical_stats_t* stats)
+ * - size_t critical_sites_impl(hal_critical_site_t* sites, size_t max)
+ * - void critical_stats_reset_impl()
+ * - void lock_init_impl(hal_lock_t* lock)
+ * - void lock_acquire_impl(hal_lock_t* lock)
+ * - void lock_release_impl(hal_lock_t* lock)
+ *     Per-object locks; without them every hal_lock_t maps to the global
+ *     critical section
+ * - static constexpr bool critical_allows_blocking()
+ *     True if code holding the critical section may sleep or do I/O (it is
+ *     a lock rather than masked interrupts); assumed false when absent
  */
 
-#include "v4/hal_platform.hpp"
+#include <cstddef>
+#include <type_traits>
+
+#include "v4/hal_error.h"
+#include "v4/hal_types.h"
 
 namespace v4
 {
 namespace hal
 {
 
+namespace detail
+{
+
+template <typename P, typename = void>
+struct has_critical_site_impl : std::false_type
+{
+};
+
+template <typename P>
+struct has_critical_site_impl<
+    P, std::void_t<decltype(P::critical_enter_impl(static_cast<const void*>(nullptr)))>>
+    : std::true_type
+{
+};
+
+// Detected through critical_stats_impl; the sites and reset hooks come with it
+template <typename P, typename = void>
+struct has_critical_stats_impl : std::false_type
+{
+};
+
+template <typename P>
+struct has_critical_stats_impl<
+    P, std::void_t<decltype(P::critical_stats_impl(static_cast<hal_critical_stats_t*>(
+           nullptr)))>> : std::true_type
+{
+};
+
+// Detected through lock_acquire_impl; lock_init_impl/lock_release_impl come with it
+template <typename P, typename = void>
+struct has_lock_impl : std::false_type
+{
+};
+
+template <typename P>
+struct has_lock_impl<
+    P, std::void_t<decltype(P::lock_acquire_impl(static_cast<hal_lock_t*>(nullptr)))>>
+    : std::true_type
+{
+};
+
+template <typename P, typename = void>
+struct has_critical_blocking_impl : std::false_type
+{
+};
+
+template <typename P>
+struct has_critical_blocking_impl<P, std::void_t<decltype(P::critical_allows_blocking())>>
+    : std::true_type
+{
+};
+
+}  // namespace detail
+
 /**
  * @brief Critical section implementation (CRTP base)
  *
@@ -35,10 +108,18 @@ class CriticalImpl
    *
    * Disables interrupts to create a critical section.
    * Must support nesting - each enter must be paired with an exit.
+   *
+   * @param site Call site charged with any contention (may be null)
    */
-  static void critical_enter()
+  static void critical_enter(const void* site = nullptr)
   {
-    Platform::critical_enter_impl();
+    if constexpr (detail::has_critical_site_impl<Platform>::value)
+      Platform::critical_enter_impl(site);
+    else
+    {
+      (void)site;
+      Platform::critical_enter_impl();
+    }
   }
 
   /**
@@ -52,6 +133,113 @@ class CriticalImpl
     Platform::critical_exit_impl();
   }
 
+  /**
+   * @brief Whether the critical section may be held across blocking calls
+   */
+  static constexpr bool allows_blocking()
+  {
+    if constexpr (detail::has_critical_blocking_impl<Platform>::value)
+      return Platform::critical_allows_blocking();
+    else
+      return false;
+  }
+
+  /**
+   * @brief Read contention counters
+   *
+   * @param stats Receives the counters
+   * @return HAL_OK on success, HAL_ERR_PARAM if stats is null,
+   *         HAL_ERR_NOTSUP if the platform does not count contention
+   */
+  static int stats(hal_critical_stats_t* stats)
+  {
+    if (!stats)
+      return HAL_ERR_PARAM;
+
+    if constexpr (detail::has_critical_stats_impl<Platform>::value)
+      return Platform::critical_stats_impl(stats);
+    else
+      return HAL_ERR_NOTSUP;
+  }
+
+  /**
+   * @brief List contended call sites, most contended first
+   *
+   * @param sites Output array
+   * @param max Capacity of sites
+   * @return Number of entries written
+   */
+  static size_t sites(hal_critical_site_t* sites, size_t max)
+  {
+    if (!sites || max == 0)
+      return 0;
+
+    if constexpr (detail::has_critical_stats_impl<Platform>::value)
+      return Platform::critical_sites_impl(sites, max);
+    else
+      return 0;
+  }
+
+  /**
+   * @brief Clear contention counters and call sites
+   */
+  static void stats_reset()
+  {
+    if constexpr (detail::has_critical_stats_impl<Platform>::value)
+      Platform::critical_stats_reset_impl();
+  }
+
+  /**
+   * @brief Initialize a lock
+   *
+   * @param lock Lock to initialize
+   * @param name Diagnostic name (not copied)
+   * @return HAL_OK on success, HAL_ERR_PARAM if lock is null
+   */
+  static int lock_init(hal_lock_t* lock, const char* name)
+  {
+    if (!lock)
+      return HAL_ERR_PARAM;
+
+    lock->contended = 0;
+    lock->name = name;
+    if constexpr (detail::has_lock_impl<Platform>::value)
+      Platform::lock_init_impl(lock);
+    return HAL_OK;
+  }
+
+  /**
+   * @brief Acquire a lock
+   *
+   * @param lock Initialized lock
+   */
+  static void lock_acquire(hal_lock_t* lock)
+  {
+    if constexpr (detail::has_lock_impl<Platform>::value)
+      Platform::lock_acquire_impl(lock);
+    else
+    {
+      (void)lock;
+      Platform::critical_enter_impl();
+    }
+  }
+
+  /**
+   * @brief Release a lock
+   *
+   * @param lock Lock held by the caller
+   */
+  static void lock_release(hal_lock_t* lock)
+  {
+    if constexpr (detail::has_lock_impl<Platform>::value)
+      Platform::lock_release_impl(lock);
+    else
+    {
+      (void)lock;
+      Platform::critical_exit_impl();
+    }
+  }
+
  protected:
   ~CriticalImpl() = default;
 };
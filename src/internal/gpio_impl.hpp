@@ -14,8 +14,27 @@
  * - static int gpio_mode_impl(int pin, hal_gpio_mode_t mode)
  * - static int gpio_write_impl(int pin, hal_gpio_value_t value)
  * - static int gpio_read_impl(int pin, hal_gpio_value_t* value)
+ *
+ * Optional (GpioBase falls back to a read followed by a write):
+ * - static int gpio_toggle_impl(int pin)
+ *
+ * Optional (GpioBase falls back to one single-pin call per bit); bank n
+ * covers pins 64*n .. 64*n+63 and is range-checked before the call:
+ * - static int gpio_write_bank_impl(int bank, uint64_t set_mask, uint64_t clear_mask)
+ * - static int gpio_read_bank_impl(int bank, uint64_t* value)
+ * - static int gpio_mode_bank_impl(int bank, uint64_t mask, hal_gpio_mode_t mode)
+ *
+ * Optional (GpioBase returns HAL_ERR_NOTSUP without them):
+ * - static int gpio_irq_attach_impl(int pin, hal_gpio_irq_edge_t edge,
+ *                                   hal_gpio_irq_handler_t handler, void* user_data)
+ * - static int gpio_irq_detach_impl(int pin)
+ * - static int gpio_irq_enable_impl(int pin)
+ * - static int gpio_irq_disable_impl(int pin)
  */
 
+#include <cstdint>
+#include <type_traits>
+
 #include "v4/hal_error.h"
 #include "v4/hal_types.h"
 
@@ -24,6 +43,47 @@ namespace v4
 namespace hal
 {
 
+namespace detail
+{
+
+template <typename P, typename = void>
+struct has_gpio_toggle_impl : std::false_type
+{
+};
+
+template <typename P>
+struct has_gpio_toggle_impl<P, std::void_t<decltype(P::gpio_toggle_impl(0))>>
+    : std::true_type
+{
+};
+
+// Detected through gpio_write_bank_impl; the read/mode bank hooks come with it
+template <typename P, typename = void>
+struct has_gpio_bank_impl : std::false_type
+{
+};
+
+template <typename P>
+struct has_gpio_bank_impl<P, std::void_t<decltype(P::gpio_write_bank_impl(
+                                 0, uint64_t{}, uint64_t{}))>> : std::true_type
+{
+};
+
+// Detected through gpio_irq_attach_impl; the other IRQ hooks come with it
+template <typename P, typename = void>
+struct has_gpio_irq_impl : std::false_type
+{
+};
+
+template <typename P>
+struct has_gpio_irq_impl<P, std::void_t<decltype(P::gpio_irq_attach_impl(
+                                0, HAL_GPIO_IRQ_BOTH, hal_gpio_irq_handler_t{},
+                                nullptr))>> : std::true_type
+{
+};
+
+}  // namespace detail
+
 /**
  * @brief GPIO base class with CRTP pattern
  *
@@ -89,21 +149,287 @@ class GpioBase
   /**
    * @brief Toggle GPIO pin value
    *
-   * Reads current pin state and writes the opposite value.
-   * Useful for LED blinking and other periodic toggles.
+   * Uses the platform's single-step gpio_toggle_impl when provided,
+   * otherwise reads the current pin state and writes the opposite value
+   * (not atomic with respect to other writers).
    *
    * @param pin GPIO pin number
    * @return HAL_OK on success, negative error code on failure
    */
   static int toggle(int pin)
   {
-    hal_gpio_value_t current;
-    int ret = read(pin, &current);
-    if (ret != HAL_OK)
-      return ret;
+    if constexpr (detail::has_gpio_toggle_impl<Platform>::value)
+    {
+      if (pin < 0 || pin >= Platform::max_gpio_pins())
+      {
+        return HAL_ERR_PARAM;
+      }
+      return Platform::gpio_toggle_impl(pin);
+    }
+    else
+    {
+      hal_gpio_value_t current;
+      int ret = read(pin, &current);
+      if (ret != HAL_OK)
+        return ret;
+
+      hal_gpio_value_t new_val =
+          (current == HAL_GPIO_HIGH) ? HAL_GPIO_LOW : HAL_GPIO_HIGH;
+      return write(pin, new_val);
+    }
+  }
+
+  /**
+   * @brief Number of 64-pin banks needed to cover every pin
+   */
+  static constexpr int bank_count()
+  {
+    return (Platform::max_gpio_pins() + 63) / 64;
+  }
+
+  /**
+   * @brief Mask covering the valid pins of one bank
+   *
+   * @param bank Bank index (pins 64*bank .. 64*bank+63)
+   * @return Valid pin bits, 0 for an out-of-range bank
+   */
+  static constexpr uint64_t bank_mask(int bank)
+  {
+    if (bank < 0 || bank >= bank_count())
+      return 0;
+    int pins = Platform::max_gpio_pins() - bank * 64;
+    return (pins >= 64) ? ~uint64_t{0} : (uint64_t{1} << pins) - 1;
+  }
+
+  /**
+   * @brief Mask covering the valid pins of bank 0
+   */
+  static constexpr uint64_t pin_mask()
+  {
+    return bank_mask(0);
+  }
+
+  /**
+   * @brief Set and clear several output pins of one bank at once
+   *
+   * @param bank       Bank index (bit n = pin 64*bank + n)
+   * @param set_mask   Pins to drive high
+   * @param clear_mask Pins to drive low
+   * @return HAL_OK on success, HAL_ERR_PARAM on invalid bank or masks
+   */
+  static int write_bank(int bank, uint64_t set_mask, uint64_t clear_mask)
+  {
+    uint64_t valid = bank_mask(bank);
+    if (!valid || ((set_mask | clear_mask) & ~valid) != 0 || (set_mask & clear_mask) != 0)
+    {
+      return HAL_ERR_PARAM;
+    }
+
+    if constexpr (detail::has_gpio_bank_impl<Platform>::value)
+    {
+      return Platform::gpio_write_bank_impl(bank, set_mask, clear_mask);
+    }
+    else
+    {
+      for (uint64_t todo = set_mask | clear_mask; todo; todo &= todo - 1)
+      {
+        int bit = __builtin_ctzll(todo);
+        hal_gpio_value_t value =
+            (set_mask >> bit) & 1 ? HAL_GPIO_HIGH : HAL_GPIO_LOW;
+        int ret = Platform::gpio_write_impl(bank * 64 + bit, value);
+        if (ret != HAL_OK)
+          return ret;
+      }
+      return HAL_OK;
+    }
+  }
+
+  /**
+   * @brief Read the level of every pin of one bank at once
+   *
+   * @param bank  Bank index
+   * @param value Receives pin levels (bit n = pin 64*bank + n)
+   * @return HAL_OK on success, HAL_ERR_PARAM on invalid arguments
+   */
+  static int read_bank(int bank, uint64_t* value)
+  {
+    uint64_t valid = bank_mask(bank);
+    if (!value || !valid)
+    {
+      return HAL_ERR_PARAM;
+    }
+
+    if constexpr (detail::has_gpio_bank_impl<Platform>::value)
+    {
+      return Platform::gpio_read_bank_impl(bank, value);
+    }
+    else
+    {
+      uint64_t levels = 0;
+      for (uint64_t todo = valid; todo; todo &= todo - 1)
+      {
+        int bit = __builtin_ctzll(todo);
+        hal_gpio_value_t level;
+        int ret = Platform::gpio_read_impl(bank * 64 + bit, &level);
+        if (ret != HAL_OK)
+          return ret;
+        if (level == HAL_GPIO_HIGH)
+          levels |= uint64_t{1} << bit;
+      }
+      *value = levels;
+      return HAL_OK;
+    }
+  }
+
+  /**
+   * @brief Configure several pins of one bank with the same mode
+   *
+   * @param bank Bank index
+   * @param mask Pins to configure (bit n = pin 64*bank + n)
+   * @param mode Pin mode
+   * @return HAL_OK on success, HAL_ERR_PARAM on invalid bank or mask
+   */
+  static int mode_bank(int bank, uint64_t mask, hal_gpio_mode_t mode)
+  {
+    uint64_t valid = bank_mask(bank);
+    if (!valid || (mask & ~valid) != 0)
+    {
+      return HAL_ERR_PARAM;
+    }
+
+    if constexpr (detail::has_gpio_bank_impl<Platform>::value)
+    {
+      return Platform::gpio_mode_bank_impl(bank, mask, mode);
+    }
+    else
+    {
+      for (uint64_t todo = mask; todo; todo &= todo - 1)
+      {
+        int ret = Platform::gpio_mode_impl(bank * 64 + __builtin_ctzll(todo), mode);
+        if (ret != HAL_OK)
+          return ret;
+      }
+      return HAL_OK;
+    }
+  }
+
+  /**
+   * @brief Set and clear several output pins of bank 0 at once
+   *
+   * @param set_mask   Pins to drive high (bit n = pin n)
+   * @param clear_mask Pins to drive low
+   * @return HAL_OK on success, HAL_ERR_PARAM on invalid or overlapping masks
+   */
+  static int write_mask(uint64_t set_mask, uint64_t clear_mask)
+  {
+    return write_bank(0, set_mask, clear_mask);
+  }
+
+  /**
+   * @brief Read the level of every pin of bank 0 at once
+   *
+   * @param value Receives pin levels (bit n = pin n)
+   * @return HAL_OK on success, HAL_ERR_PARAM on invalid arguments
+   */
+  static int read_port(uint64_t* value)
+  {
+    return read_bank(0, value);
+  }
+
+  /**
+   * @brief Configure several pins of bank 0 with the same mode
+   *
+   * @param mask Pins to configure (bit n = pin n)
+   * @param mode Pin mode
+   * @return HAL_OK on success, HAL_ERR_PARAM on invalid mask
+   */
+  static int mode_mask(uint64_t mask, hal_gpio_mode_t mode)
+  {
+    return mode_bank(0, mask, mode);
+  }
+
+  /**
+   * @brief Attach interrupt handler to GPIO pin
+   *
+   * @param pin       GPIO pin number
+   * @param edge      Edge(s) to trigger on
+   * @param handler   Callback function
+   * @param user_data User context passed to handler
+   * @return HAL_OK on success, HAL_ERR_NOTSUP if the platform has no IRQ support
+   */
+  static int irq_attach(int pin, hal_gpio_irq_edge_t edge, hal_gpio_irq_handler_t handler,
+                        void* user_data)
+  {
+    if (pin < 0 || pin >= Platform::max_gpio_pins() || !handler)
+    {
+      return HAL_ERR_PARAM;
+    }
+    if ((edge & HAL_GPIO_IRQ_BOTH) == 0 || (edge & ~HAL_GPIO_IRQ_BOTH) != 0)
+    {
+      return HAL_ERR_PARAM;
+    }
+
+    if constexpr (detail::has_gpio_irq_impl<Platform>::value)
+      return Platform::gpio_irq_attach_impl(pin, edge, handler, user_data);
+    else
+      return HAL_ERR_NOTSUP;
+  }
+
+  /**
+   * @brief Detach interrupt handler from GPIO pin
+   *
+   * @param pin GPIO pin number
+   * @return HAL_OK on success, negative error code on failure
+   */
+  static int irq_detach(int pin)
+  {
+    if (pin < 0 || pin >= Platform::max_gpio_pins())
+    {
+      return HAL_ERR_PARAM;
+    }
+
+    if constexpr (detail::has_gpio_irq_impl<Platform>::value)
+      return Platform::gpio_irq_detach_impl(pin);
+    else
+      return HAL_ERR_NOTSUP;
+  }
+
+  /**
+   * @brief Enable GPIO interrupt
+   *
+   * @param pin GPIO pin number
+   * @return HAL_OK on success, negative error code on failure
+   */
+  static int irq_enable(int pin)
+  {
+    if (pin < 0 || pin >= Platform::max_gpio_pins())
+    {
+      return HAL_ERR_PARAM;
+    }
+
+    if constexpr (detail::has_gpio_irq_impl<Platform>::value)
+      return Platform::gpio_irq_enable_impl(pin);
+    else
+      return HAL_ERR_NOTSUP;
+  }
+
+  /**
+   * @brief Disable GPIO interrupt
+   *
+   * @param pin GPIO pin number
+   * @return HAL_OK on success, negative error code on failure
+   */
+  static int irq_disable(int pin)
+  {
+    if (pin < 0 || pin >= Platform::max_gpio_pins())
+    {
+      return HAL_ERR_PARAM;
+    }
 
-    hal_gpio_value_t new_val = (current == HAL_GPIO_HIGH) ? HAL_GPIO_LOW : HAL_GPIO_HIGH;
-    return write(pin, new_val);
+    if constexpr (detail::has_gpio_irq_impl<Platform>::value)
+      return Platform::gpio_irq_disable_impl(pin);
+    else
+      return HAL_ERR_NOTSUP;
   }
 };
 
@@ -0,0 +1,176 @@
+#ifndef V4_HAL_PIN_BANK_HPP
+#define V4_HAL_PIN_BANK_HPP
+
+/**
+ * @file pin_bank.hpp
+ * @brief Fixed-size lock-free pin bitmap
+ *
+ * Provides a compile-time sized bitmap of atomic 64-bit words used by
+ * simulation ports to hold pin levels, modes and interrupt masks. A
+ * single-pin access touches exactly one word (one shift, one mask, one
+ * atomic RMW); bank-wide operations work a whole word of pins at a time
+ * over contiguous, cache-line aligned storage.
+ *
+ * Word n holds pins 64*n .. 64*n+63 with pin p at bit (p % 64), which is
+ * the layout of the hal_gpio_*_bank() C API.
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "ring_buffer.hpp"
+
+namespace v4
+{
+namespace hal
+{
+
+/**
+ * @brief Atomic bitmap of Pins bits
+ *
+ * All operations are lock-free and may be called from any thread. RMW
+ * operations return the prior value of the word they touched so callers
+ * can derive exact edges.
+ *
+ * @tparam Pins Number of pins (bits)
+ */
+template <size_t Pins>
+class PinBank
+{
+  static_assert(Pins > 0, "PinBank needs at least one pin");
+
+ public:
+  using Word = uint64_t;
+
+  static constexpr size_t kWordBits = 64;
+  static constexpr size_t kWords = (Pins + kWordBits - 1) / kWordBits;
+
+  /**
+   * @brief Word index holding pin
+   */
+  static constexpr size_t word_of(int pin)
+  {
+    return static_cast<size_t>(pin) / kWordBits;
+  }
+
+  /**
+   * @brief Bit of pin within its word
+   */
+  static constexpr Word bit_of(int pin)
+  {
+    return Word{1} << (static_cast<size_t>(pin) % kWordBits);
+  }
+
+  /**
+   * @brief Bits of word w that map to existing pins
+   */
+  static constexpr Word valid_mask(size_t w)
+  {
+    return (w + 1 < kWords || Pins % kWordBits == 0)
+               ? ~Word{0}
+               : (Word{1} << (Pins % kWordBits)) - 1;
+  }
+
+  /* ----------------------------------------------------------------------- */
+  /* Single-pin operations                                                   */
+  /* ----------------------------------------------------------------------- */
+
+  bool test(int pin) const
+  {
+    return (words_[word_of(pin)].load(std::memory_order_acquire) & bit_of(pin)) != 0;
+  }
+
+  /**
+   * @brief Set pin bit
+   * @return Prior value of the pin's word
+   */
+  Word set(int pin)
+  {
+    return words_[word_of(pin)].fetch_or(bit_of(pin), std::memory_order_acq_rel);
+  }
+
+  /**
+   * @brief Clear pin bit
+   * @return Prior value of the pin's word
+   */
+  Word clear(int pin)
+  {
+    return words_[word_of(pin)].fetch_and(~bit_of(pin), std::memory_order_acq_rel);
+  }
+
+  /**
+   * @brief Invert pin bit
+   * @return Prior value of the pin's word
+   */
+  Word flip(int pin)
+  {
+    return words_[word_of(pin)].fetch_xor(bit_of(pin), std::memory_order_acq_rel);
+  }
+
+  /* ----------------------------------------------------------------------- */
+  /* Word operations                                                         */
+  /* ----------------------------------------------------------------------- */
+
+  Word load(size_t w) const
+  {
+    return words_[w].load(std::memory_order_acquire);
+  }
+
+  Word fetch_or(size_t w, Word mask)
+  {
+    return words_[w].fetch_or(mask, std::memory_order_acq_rel);
+  }
+
+  Word fetch_and(size_t w, Word mask)
+  {
+    return words_[w].fetch_and(mask, std::memory_order_acq_rel);
+  }
+
+  Word exchange(size_t w, Word value)
+  {
+    return words_[w].exchange(value, std::memory_order_acq_rel);
+  }
+
+  /**
+   * @brief Set and clear bits of one word in a single atomic step
+   *
+   * Uses one fetch_or or fetch_and when only one mask is non-empty,
+   * otherwise one CAS loop.
+   *
+   * @return Prior value of the word
+   */
+  Word update(size_t w, Word set_mask, Word clear_mask)
+  {
+    if (!clear_mask)
+      return fetch_or(w, set_mask);
+    if (!set_mask)
+      return fetch_and(w, ~clear_mask);
+
+    Word old_word = words_[w].load(std::memory_order_relaxed);
+    while (!words_[w].compare_exchange_weak(old_word, (old_word | set_mask) & ~clear_mask,
+                                            std::memory_order_acq_rel))
+    {
+    }
+    return old_word;
+  }
+
+  /**
+   * @brief True if any bit in the bank is set
+   */
+  bool any() const
+  {
+    Word acc = 0;
+    for (size_t w = 0; w < kWords; w++)
+      acc |= words_[w].load(std::memory_order_acquire);
+    return acc != 0;
+  }
+
+ private:
+  alignas(kCacheLineSize) std::atomic<Word> words_[kWords] = {};
+};
+
+}  // namespace hal
+}  // namespace v4
+
+#endif  // V4_HAL_PIN_BANK_HPP
@@ -0,0 +1,218 @@
+#ifndef V4_HAL_QUEUE_HPP
+#define V4_HAL_QUEUE_HPP
+
+/**
+ * @file queue.hpp
+ * @brief Fixed-capacity lock-free element queues
+ *
+ * Provides typed bounded queues for handing data from interrupt handlers
+ * (or the POSIX IRQ dispatch thread) to the main loop:
+ * - SpscQueue: one producer, one consumer; push and pop are one acquire
+ *   load, a copy and one release store.
+ * - MpscQueue: any number of producers, one consumer. Producers claim a
+ *   slot with one CAS on the head and publish it through the slot's
+ *   sequence number (Vyukov's bounded queue), so no producer ever waits
+ *   for another to finish.
+ *
+ * Neither queue locks or allocates, so both are safe to push from an
+ * ISR. Capacity is a compile-time power of two and the storage is inline;
+ * producer and consumer indices sit on separate cache lines. Indices are
+ * free-running 32-bit counters.
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "ring_buffer.hpp"
+
+namespace v4
+{
+namespace hal
+{
+
+/**
+ * @brief Single-producer/single-consumer element queue
+ *
+ * Exactly one context may push and exactly one may pop.
+ *
+ * @tparam T        Element type (trivially copyable)
+ * @tparam Capacity Number of elements (power of two)
+ */
+template <typename T, size_t Capacity>
+class SpscQueue
+{
+  static_assert(std::is_trivially_copyable<T>::value,
+                "SpscQueue elements must be trivially copyable");
+  static_assert(Capacity != 0 && (Capacity & (Capacity - 1)) == 0 &&
+                    Capacity <= (size_t{1} << 31),
+                "SpscQueue capacity must be a power of two");
+
+  static constexpr uint32_t kMask = Capacity - 1;
+
+  alignas(kCacheLineSize) std::atomic<uint32_t> head_{0};  // Written by producer
+  alignas(kCacheLineSize) std::atomic<uint32_t> tail_{0};  // Written by consumer
+  alignas(kCacheLineSize) T slots_[Capacity];
+
+ public:
+  static constexpr size_t capacity()
+  {
+    return Capacity;
+  }
+
+  /**
+   * @brief Number of queued elements
+   */
+  size_t size() const
+  {
+    // Tail first: head only moves forward, so a later head is never behind it
+    uint32_t tail = tail_.load(std::memory_order_acquire);
+    return head_.load(std::memory_order_acquire) - tail;
+  }
+
+  /**
+   * @brief Append an element (producer only)
+   *
+   * @return false if the queue is full
+   */
+  bool push(const T& item)
+  {
+    uint32_t head = head_.load(std::memory_order_relaxed);
+    if (head - tail_.load(std::memory_order_acquire) == Capacity)
+      return false;
+    slots_[head & kMask] = item;
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief Remove the oldest element (consumer only)
+   *
+   * @return false if the queue is empty
+   */
+  bool pop(T* item)
+  {
+    uint32_t tail = tail_.load(std::memory_order_relaxed);
+    if (head_.load(std::memory_order_acquire) == tail)
+      return false;
+    *item = slots_[tail & kMask];
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+};
+
+/**
+ * @brief Multi-producer/single-consumer element queue
+ *
+ * Any number of contexts may push concurrently; exactly one may pop.
+ * Elements from one producer are popped in the order it pushed them.
+ *
+ * @tparam T        Element type (trivially copyable)
+ * @tparam Capacity Number of elements (power of two)
+ */
+template <typename T, size_t Capacity>
+class MpscQueue
+{
+  static_assert(std::is_trivially_copyable<T>::value,
+                "MpscQueue elements must be trivially copyable");
+  static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0 &&
+                    Capacity <= (size_t{1} << 31),
+                "MpscQueue capacity must be a power of two of at least 2");
+
+  static constexpr uint32_t kMask = Capacity - 1;
+
+  struct Slot
+  {
+    // pos: free for the producer claiming pos; pos + 1: holds that element
+    std::atomic<uint32_t> sequence;
+    T item;
+  };
+
+  alignas(kCacheLineSize) std::atomic<uint32_t> head_{0};  // Claimed by producers
+  alignas(kCacheLineSize) std::atomic<uint32_t> tail_{0};  // Written by consumer
+  alignas(kCacheLineSize) Slot slots_[Capacity];
+
+ public:
+  MpscQueue()
+  {
+    for (uint32_t i = 0; i < Capacity; i++)
+      slots_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+
+  MpscQueue(const MpscQueue&) = delete;
+  MpscQueue& operator=(const MpscQueue&) = delete;
+
+  static constexpr size_t capacity()
+  {
+    return Capacity;
+  }
+
+  /**
+   * @brief Number of queued elements, including ones still being written
+   */
+  size_t size() const
+  {
+    // Tail first: head only moves forward, so a later head is never behind it
+    uint32_t tail = tail_.load(std::memory_order_acquire);
+    return head_.load(std::memory_order_acquire) - tail;
+  }
+
+  /**
+   * @brief Append an element (any producer)
+   *
+   * @return false if the queue is full
+   */
+  bool push(const T& item)
+  {
+    uint32_t pos = head_.load(std::memory_order_relaxed);
+    Slot* slot;
+    for (;;)
+    {
+      slot = &slots_[pos & kMask];
+      uint32_t seq = slot->sequence.load(std::memory_order_acquire);
+      auto diff = static_cast<int32_t>(seq - pos);
+      if (diff == 0)
+      {
+        if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+          break;
+      }
+      else if (diff < 0)
+      {
+        return false;  // Consumer has not freed this slot yet
+      }
+      else
+      {
+        pos = head_.load(std::memory_order_relaxed);  // Another producer took it
+      }
+    }
+
+    slot->item = item;
+    slot->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief Remove the oldest element (consumer only)
+   *
+   * @return false if the queue is empty or the oldest element is still
+   *         being written
+   */
+  bool pop(T* item)
+  {
+    uint32_t pos = tail_.load(std::memory_order_relaxed);
+    Slot& slot = slots_[pos & kMask];
+    if (slot.sequence.load(std::memory_order_acquire) != pos + 1)
+      return false;
+
+    *item = slot.item;
+    slot.sequence.store(pos + Capacity, std::memory_order_release);
+    tail_.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+};
+
+}  // namespace hal
+}  // namespace v4
+
+#endif  // V4_HAL_QUEUE_HPP
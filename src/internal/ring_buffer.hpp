@@ -0,0 +1,180 @@
+#ifndef V4_HAL_RING_BUFFER_HPP
+#define V4_HAL_RING_BUFFER_HPP
+
+/**
+ * @file ring_buffer.hpp
+ * @brief Fixed-size lock-free byte ring buffers
+ *
+ * Provides a single-producer/single-consumer byte ring used by platform
+ * ports to decouple I/O threads from HAL callers. Capacity is a
+ * compile-time power of two so index wrapping is a single mask, and the
+ * storage lives inline (no dynamic allocation).
+ *
+ * Producer and consumer indices are free-running counters placed on
+ * separate cache lines; the fill level is always head - tail.
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace v4
+{
+namespace hal
+{
+
+/**
+ * @brief Cache line size used for padding shared atomics
+ */
+constexpr size_t kCacheLineSize = 64;
+
+/**
+ * @brief Single-producer/single-consumer byte ring
+ *
+ * Exactly one thread may call the producer methods (write_span, commit,
+ * push) and exactly one thread may call the consumer methods (peek,
+ * consume, pop). size() may be called from either side.
+ *
+ * @tparam Capacity Ring size in bytes (must be a power of two)
+ */
+template <size_t Capacity>
+class SpscByteRing
+{
+  static_assert(Capacity != 0 && (Capacity & (Capacity - 1)) == 0,
+                "SpscByteRing capacity must be a power of two");
+
+  static constexpr size_t kMask = Capacity - 1;
+
+  alignas(kCacheLineSize) std::atomic<size_t> head_{0};  // Written by producer
+  alignas(kCacheLineSize) std::atomic<size_t> tail_{0};  // Written by consumer
+  alignas(kCacheLineSize) uint8_t buf_[Capacity];
+
+ public:
+  /**
+   * @brief Ring capacity in bytes
+   */
+  static constexpr size_t capacity()
+  {
+    return Capacity;
+  }
+
+  /**
+   * @brief Number of bytes ready to be consumed
+   */
+  size_t size() const
+  {
+    return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_relaxed);
+  }
+
+  /* ----------------------------------------------------------------------- */
+  /* Producer side                                                           */
+  /* ----------------------------------------------------------------------- */
+
+  /**
+   * @brief Get the contiguous free region at the write position
+   *
+   * Lets the producer fill the ring in place (e.g. read(fd, p, n))
+   * before publishing the bytes with commit().
+   *
+   * @param p Receives pointer to the free region
+   * @return Length of the contiguous free region (0 if full)
+   */
+  size_t write_span(uint8_t** p)
+  {
+    size_t head = head_.load(std::memory_order_relaxed);
+    size_t free = Capacity - (head - tail_.load(std::memory_order_acquire));
+    size_t off = head & kMask;
+    *p = &buf_[off];
+    return (free < Capacity - off) ? free : Capacity - off;
+  }
+
+  /**
+   * @brief Number of bytes that can be written without overflowing
+   */
+  size_t space() const
+  {
+    return Capacity - (head_.load(std::memory_order_relaxed) -
+                       tail_.load(std::memory_order_acquire));
+  }
+
+  /**
+   * @brief Publish n bytes previously written via write_span()
+   */
+  void commit(size_t n)
+  {
+    head_.store(head_.load(std::memory_order_relaxed) + n, std::memory_order_release);
+  }
+
+  /**
+   * @brief Copy bytes into the ring
+   *
+   * @return Number of bytes accepted (less than len if the ring fills)
+   */
+  size_t push(const uint8_t* src, size_t len)
+  {
+    size_t head = head_.load(std::memory_order_relaxed);
+    size_t free = Capacity - (head - tail_.load(std::memory_order_acquire));
+    if (len > free)
+      len = free;
+
+    size_t off = head & kMask;
+    size_t first = (len < Capacity - off) ? len : Capacity - off;
+    std::memcpy(&buf_[off], src, first);
+    std::memcpy(&buf_[0], src + first, len - first);
+    head_.store(head + len, std::memory_order_release);
+    return len;
+  }
+
+  /* ----------------------------------------------------------------------- */
+  /* Consumer side                                                           */
+  /* ----------------------------------------------------------------------- */
+
+  /**
+   * @brief Get the contiguous readable region at the read position
+   *
+   * @param p Receives pointer to the readable region
+   * @return Length of the contiguous readable region (0 if empty)
+   */
+  size_t peek(const uint8_t** p) const
+  {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    size_t used = head_.load(std::memory_order_acquire) - tail;
+    size_t off = tail & kMask;
+    *p = &buf_[off];
+    return (used < Capacity - off) ? used : Capacity - off;
+  }
+
+  /**
+   * @brief Release n bytes previously returned by peek()
+   */
+  void consume(size_t n)
+  {
+    tail_.store(tail_.load(std::memory_order_relaxed) + n, std::memory_order_release);
+  }
+
+  /**
+   * @brief Copy bytes out of the ring
+   *
+   * @return Number of bytes copied (less than len if the ring drains)
+   */
+  size_t pop(uint8_t* dst, size_t len)
+  {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    size_t used = head_.load(std::memory_order_acquire) - tail;
+    if (len > used)
+      len = used;
+
+    size_t off = tail & kMask;
+    size_t first = (len < Capacity - off) ? len : Capacity - off;
+    std::memcpy(dst, &buf_[off], first);
+    std::memcpy(dst + first, &buf_[0], len - first);
+    tail_.store(tail + len, std::memory_order_release);
+    return len;
+  }
+};
+
+}  // namespace hal
+}  // namespace v4
+
+#endif  // V4_HAL_RING_BUFFER_HPP
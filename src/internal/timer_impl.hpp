@@ -6,22 +6,75 @@
  * @brief Timer internal implementation using CRTP
  *
  * Provides platform-agnostic timer operations for time measurement
- * and delays. Uses CRTP for compile-time polymorphism.
+ * and delays, plus a drift-free PeriodicTimer. Uses CRTP for
+ * compile-time polymorphism.
  *
  * Platform requirements:
  * - static uint32_t millis_impl()
  * - static uint64_t micros_impl()
  * - static void delay_ms_impl(uint32_t ms)
  * - static void delay_us_impl(uint32_t us)
+ *
+ * Optional (TimerBase falls back to delay_us_impl() plus a micros_impl() spin):
+ * - static void delay_us_precise_impl(uint32_t us, uint32_t spin_us)
+ * - static void delay_until_us_impl(uint64_t deadline_us)
+ *
+ * Optional (TimerBase only offers HAL_CLOCK_MONOTONIC without them):
+ * - static int timer_set_source_impl(hal_clock_source_t source)
+ * - static hal_clock_source_t timer_get_source_impl()
  */
 
 #include <cstdint>
+#include <type_traits>
+
+#include "v4/hal_error.h"
+#include "v4/hal_types.h"
 
 namespace v4
 {
 namespace hal
 {
 
+namespace detail
+{
+
+// Detected through timer_set_source_impl; timer_get_source_impl comes with it
+template <typename P, typename = void>
+struct has_timer_source_impl : std::false_type
+{
+};
+
+template <typename P>
+struct has_timer_source_impl<
+    P, std::void_t<decltype(P::timer_set_source_impl(HAL_CLOCK_MONOTONIC))>>
+    : std::true_type
+{
+};
+
+template <typename P, typename = void>
+struct has_delay_precise_impl : std::false_type
+{
+};
+
+template <typename P>
+struct has_delay_precise_impl<P, std::void_t<decltype(P::delay_us_precise_impl(0u, 0u))>>
+    : std::true_type
+{
+};
+
+template <typename P, typename = void>
+struct has_delay_until_impl : std::false_type
+{
+};
+
+template <typename P>
+struct has_delay_until_impl<P, std::void_t<decltype(P::delay_until_us_impl(uint64_t{}))>>
+    : std::true_type
+{
+};
+
+}  // namespace detail
+
 /**
  * @brief Timer base class with CRTP pattern
  *
@@ -88,6 +141,94 @@ class TimerBase
     Platform::delay_us_impl(us);
   }
 
+  /**
+   * @brief Precise blocking delay in microseconds
+   *
+   * Sleeps for all but the last spin_us microseconds, then busy-waits on
+   * micros() until the delay has elapsed. A larger spin_us trades CPU
+   * time for accuracy against the scheduler's wake-up latency.
+   *
+   * @param us      Microseconds to delay
+   * @param spin_us Busy-wait tail in microseconds
+   */
+  static void delay_us_precise(uint32_t us, uint32_t spin_us)
+  {
+    if constexpr (detail::has_delay_precise_impl<Platform>::value)
+    {
+      Platform::delay_us_precise_impl(us, spin_us);
+    }
+    else
+    {
+      uint64_t deadline = Platform::micros_impl() + us;
+      if (us > spin_us)
+        Platform::delay_us_impl(us - spin_us);
+      while (Platform::micros_impl() < deadline)
+      {
+      }
+    }
+  }
+
+  /**
+   * @brief Block until micros() reaches an absolute deadline
+   *
+   * Periodic loops that advance deadline_us by a fixed period do not
+   * accumulate the loop body time as drift. Returns immediately if the
+   * deadline has passed.
+   *
+   * @param deadline_us Absolute deadline in micros() time
+   */
+  static void delay_until_us(uint64_t deadline_us)
+  {
+    if constexpr (detail::has_delay_until_impl<Platform>::value)
+    {
+      Platform::delay_until_us_impl(deadline_us);
+    }
+    else
+    {
+      for (uint64_t now = Platform::micros_impl(); now < deadline_us;
+           now = Platform::micros_impl())
+      {
+        uint64_t remaining = deadline_us - now;
+        if (remaining > UINT32_MAX)
+          remaining = UINT32_MAX;
+        Platform::delay_us_impl(static_cast<uint32_t>(remaining));
+      }
+    }
+  }
+
+  /**
+   * @brief Select the clock source behind millis() and micros()
+   *
+   * @param source Clock source
+   * @return HAL_OK on success, HAL_ERR_PARAM for an unknown source,
+   *         HAL_ERR_NOTSUP if the platform cannot provide it
+   */
+  static int set_source(hal_clock_source_t source)
+  {
+    if (source < HAL_CLOCK_MONOTONIC || source > HAL_CLOCK_VIRTUAL)
+    {
+      return HAL_ERR_PARAM;
+    }
+
+    if constexpr (detail::has_timer_source_impl<Platform>::value)
+      return Platform::timer_set_source_impl(source);
+    else
+      return (source == HAL_CLOCK_MONOTONIC) ? HAL_OK : HAL_ERR_NOTSUP;
+  }
+
+  /**
+   * @brief Get the clock source behind millis() and micros()
+   *
+   * @return Current clock source
+   */
+  static hal_clock_source_t source()
+  {
+    if constexpr (detail::has_timer_source_impl<Platform>::value)
+      return Platform::timer_get_source_impl();
+    else
+      return HAL_CLOCK_MONOTONIC;
+  }
+
   /**
    * @brief Calculate elapsed time in milliseconds
    *
@@ -119,6 +260,109 @@ class TimerBase
   }
 };
 
+/**
+ * @brief Fixed-rate loop pacing on absolute deadlines
+ *
+ * Each wait() sleeps until the next period boundary with
+ * TimerBase::delay_until_us(), so the loop body time never accumulates as
+ * drift. A body that runs past its boundary is an overrun: wait() then
+ * returns at once, skips every boundary that already passed and realigns
+ * to the original phase rather than running a burst of catch-up periods.
+ *
+ * @code
+ * PeriodicTimer<Platform> tick(1000);  // 1 kHz
+ * for (;;)
+ * {
+ *   control_step();
+ *   tick.wait();
+ * }
+ * @endcode
+ *
+ * @tparam Platform Platform implementation class
+ */
+template <typename Platform>
+class PeriodicTimer
+{
+ public:
+  /**
+   * @brief Start a periodic schedule
+   *
+   * The first boundary is one period after construction.
+   *
+   * @param period_us Period in microseconds (0 is treated as 1)
+   */
+  explicit PeriodicTimer(uint64_t period_us)
+      : period_us_(period_us ? period_us : 1),
+        next_us_(TimerBase<Platform>::micros() + period_us_)
+  {
+  }
+
+  /**
+   * @brief Wait for the next period boundary
+   *
+   * @return Number of whole periods skipped by an overrun (0 when on time)
+   */
+  uint64_t wait()
+  {
+    uint64_t now = TimerBase<Platform>::micros();
+    if (now <= next_us_)
+    {
+      TimerBase<Platform>::delay_until_us(next_us_);
+      next_us_ += period_us_;
+      return 0;
+    }
+
+    uint64_t skipped = (now - next_us_) / period_us_;
+    overruns_++;
+    missed_ += skipped;
+    next_us_ += (skipped + 1) * period_us_;
+    return skipped;
+  }
+
+  /**
+   * @brief Restart the schedule one period from now
+   */
+  void reset()
+  {
+    next_us_ = TimerBase<Platform>::micros() + period_us_;
+  }
+
+  /**
+   * @brief Absolute time of the next boundary, in micros() time
+   */
+  uint64_t next_wakeup_us() const
+  {
+    return next_us_;
+  }
+
+  uint64_t period_us() const
+  {
+    return period_us_;
+  }
+
+  /**
+   * @brief Number of wait() calls that found their boundary already passed
+   */
+  uint32_t overruns() const
+  {
+    return overruns_;
+  }
+
+  /**
+   * @brief Total number of periods skipped by overruns
+   */
+  uint64_t missed_periods() const
+  {
+    return missed_;
+  }
+
+ private:
+  uint64_t period_us_;
+  uint64_t next_us_;
+  uint32_t overruns_ = 0;
+  uint64_t missed_ = 0;
+};
+
 }  // namespace hal
 }  // namespace v4
 
@@ -0,0 +1,255 @@
+#ifndef V4_HAL_TIMER_WHEEL_HPP
+#define V4_HAL_TIMER_WHEEL_HPP
+
+/**
+ * @file timer_wheel.hpp
+ * @brief Hierarchical timer wheel
+ *
+ * Provides the timeout store behind the hal_timer_* API. Timers are
+ * intrusive nodes hashed by expiry tick into one of kLevels wheels of
+ * kSlots slots; level L covers deltas below 2^(kSlotBits*(L+1)) ticks.
+ * Insertion and cancellation are O(1) list operations. When the tick
+ * crosses a slot boundary of level L, that slot is cascaded (re-hashed)
+ * into the finer levels, so each timer is touched at most kLevels times.
+ *
+ * A 64-bit occupancy mask per level lets next_event() find the next tick
+ * at which anything happens in O(kLevels), so a driver can sleep until
+ * then and advance() can jump over empty ticks.
+ *
+ * The wheel performs no locking and no allocation.
+ */
+
+#include <cstddef>
+#include <cstdint>
+
+namespace v4
+{
+namespace hal
+{
+
+/**
+ * @brief Intrusive wheel entry
+ *
+ * Embed (or derive from) this in the timer object. A node is linked in
+ * at most one slot at a time.
+ */
+struct TimerWheelNode
+{
+  TimerWheelNode* next = nullptr;
+  TimerWheelNode** pprev = nullptr;  // Points at the link that points here
+  uint64_t expires = 0;              // Expiry tick
+  uint16_t slot = 0;                 // level * kSlots + index
+
+  bool linked() const
+  {
+    return pprev != nullptr;
+  }
+};
+
+/**
+ * @brief Hashed hierarchical timer wheel
+ *
+ * Ticks are abstract; the owner maps them to time. A timer inserted with
+ * an expiry at or before the current tick fires on the next advance().
+ * Timers further out than the wheel's range are parked in the last level
+ * and re-hashed when they come around.
+ */
+class TimerWheel
+{
+ public:
+  static constexpr int kSlotBits = 6;
+  static constexpr int kSlots = 1 << kSlotBits;
+  static constexpr int kLevels = 5;
+  static constexpr uint64_t kSlotMask = kSlots - 1;
+  static constexpr uint64_t kRange = uint64_t{1} << (kSlotBits * kLevels);
+  static constexpr uint64_t kNever = UINT64_MAX;
+
+  /**
+   * @brief Next tick to be processed by advance()
+   */
+  uint64_t current() const
+  {
+    return current_;
+  }
+
+  /**
+   * @brief Number of linked timers
+   */
+  size_t size() const
+  {
+    return count_;
+  }
+
+  /**
+   * @brief Move an empty wheel to a new current tick
+   *
+   * @return false if timers are linked (the wheel is left unchanged)
+   */
+  bool reset(uint64_t tick)
+  {
+    if (count_)
+      return false;
+    current_ = tick;
+    return true;
+  }
+
+  /**
+   * @brief Link node to expire at tick expires
+   */
+  void insert(TimerWheelNode* node, uint64_t expires)
+  {
+    node->expires = expires;
+    link(node);
+    count_++;
+  }
+
+  /**
+   * @brief Unlink node (no-op if not linked)
+   */
+  void remove(TimerWheelNode* node)
+  {
+    if (!node->linked())
+      return;
+    unlink(node);
+    count_--;
+  }
+
+  /**
+   * @brief Earliest tick at which advance() has work to do
+   *
+   * Exact for timers in level 0; for coarser levels it is the tick at
+   * which their slot cascades, which is never later than their expiry.
+   *
+   * @return Tick, or kNever if the wheel is empty
+   */
+  uint64_t next_event() const
+  {
+    uint64_t best = kNever;
+    for (int level = 0; level < kLevels; level++)
+    {
+      if (!occupied_[level])
+        continue;
+
+      int shift = kSlotBits * level;
+      uint64_t unit = (current_ + (uint64_t{1} << shift) - 1) >> shift;
+      unsigned base = static_cast<unsigned>(unit & kSlotMask);
+      uint64_t mask = occupied_[level];
+      uint64_t rotated = (mask >> base) | (base ? mask << (kSlots - base) : 0);
+      uint64_t event = (unit + __builtin_ctzll(rotated)) << shift;
+      if (event < best)
+        best = event;
+    }
+    return best;
+  }
+
+  /**
+   * @brief Process every tick up to and including tick
+   *
+   * Expired nodes are unlinked and chained through their next pointer
+   * onto *expired (most recent first); the caller may re-insert them once
+   * advance() returns.
+   *
+   * @param tick    Last tick to process
+   * @param expired Receives the expired nodes
+   */
+  void advance(uint64_t tick, TimerWheelNode** expired)
+  {
+    while (current_ <= tick)
+    {
+      uint64_t t = next_event();
+      if (t > tick)
+      {
+        current_ = tick + 1;
+        return;
+      }
+
+      current_ = t;
+      if ((t & kSlotMask) == 0)
+        cascade(t);
+
+      TimerWheelNode*& head = slots_[0][t & kSlotMask];
+      while (head)
+      {
+        TimerWheelNode* node = head;
+        unlink(node);
+        count_--;
+        node->next = *expired;
+        *expired = node;
+      }
+      current_ = t + 1;
+    }
+  }
+
+ private:
+  void link(TimerWheelNode* node)
+  {
+    uint64_t expires = node->expires < current_ ? current_ : node->expires;
+    uint64_t delta = expires - current_;
+    if (delta >= kRange)
+    {
+      expires = current_ + kRange - 1;  // Parked; re-hashed on cascade
+      delta = kRange - 1;
+    }
+
+    int level = 0;
+    while (delta >= (uint64_t{1} << (kSlotBits * (level + 1))))
+      level++;
+    unsigned index = static_cast<unsigned>((expires >> (kSlotBits * level)) & kSlotMask);
+
+    TimerWheelNode*& head = slots_[level][index];
+    node->next = head;
+    if (head)
+      head->pprev = &node->next;
+    head = node;
+    node->pprev = &head;
+    node->slot = static_cast<uint16_t>(level * kSlots + index);
+    occupied_[level] |= uint64_t{1} << index;
+  }
+
+  void unlink(TimerWheelNode* node)
+  {
+    *node->pprev = node->next;
+    if (node->next)
+      node->next->pprev = node->pprev;
+
+    int level = node->slot / kSlots;
+    int index = node->slot % kSlots;
+    if (!slots_[level][index])
+      occupied_[level] &= ~(uint64_t{1} << index);
+
+    node->next = nullptr;
+    node->pprev = nullptr;
+  }
+
+  // Re-hash the coarser slots that start at tick t (t is slot-aligned)
+  void cascade(uint64_t t)
+  {
+    for (int level = 1; level < kLevels; level++)
+    {
+      unsigned index = static_cast<unsigned>((t >> (kSlotBits * level)) & kSlotMask);
+      TimerWheelNode* list = slots_[level][index];
+      slots_[level][index] = nullptr;
+      occupied_[level] &= ~(uint64_t{1} << index);
+
+      while (list)
+      {
+        TimerWheelNode* node = list;
+        list = node->next;
+        link(node);
+      }
+
+      if (index != 0)
+        break;
+    }
+  }
+
+  TimerWheelNode* slots_[kLevels][kSlots] = {};
+  uint64_t occupied_[kLevels] = {};
+  uint64_t current_ = 0;
+  size_t count_ = 0;
+};
+
+}  // namespace hal
+}  // namespace v4
+
+#endif  // V4_HAL_TIMER_WHEEL_HPP
@@ -13,11 +13,23 @@
  * - static hal_handle_t uart_open_impl(int port, const hal_uart_config_t* config)
  * - static int uart_close_impl(hal_handle_t handle)
  * - static int uart_write_impl(hal_handle_t handle, const uint8_t* buf, size_t len)
+ * - static int uart_flush_impl(hal_handle_t handle)
  * - static int uart_read_impl(hal_handle_t handle, uint8_t* buf, size_t len)
+ * - static int uart_read_timeout_impl(hal_handle_t handle, uint8_t* buf, size_t len,
+ *                                     uint32_t timeout_us)
+ * - static int uart_rx_peek_impl(hal_handle_t handle, const uint8_t** data, size_t* len)
+ * - static int uart_rx_consume_impl(hal_handle_t handle, size_t len)
  * - static int uart_available_impl(hal_handle_t handle)
+ * - static uint64_t micros_impl()
+ *
+ * Optional (UartBase falls back to looping over write/read):
+ * - static int uart_writev_impl(hal_handle_t handle, const hal_iovec_t* iov, size_t n)
+ * - static int uart_readv_impl(hal_handle_t handle, const hal_iovec_t* iov, size_t n)
  */
 
 #include <cstdint>
+#include <cstring>
+#include <type_traits>
 
 #include "v4/hal_error.h"
 #include "v4/hal_types.h"
@@ -39,6 +51,37 @@ struct UartHandle
   void* platform_data; /**< Platform-specific data */
 };
 
+namespace detail
+{
+
+template <typename P, typename = void>
+struct has_uart_writev_impl : std::false_type
+{
+};
+
+template <typename P>
+struct has_uart_writev_impl<
+    P, std::void_t<decltype(P::uart_writev_impl(
+           hal_handle_t{}, static_cast<const hal_iovec_t*>(nullptr), size_t{}))>>
+    : std::true_type
+{
+};
+
+template <typename P, typename = void>
+struct has_uart_readv_impl : std::false_type
+{
+};
+
+template <typename P>
+struct has_uart_readv_impl<
+    P, std::void_t<decltype(P::uart_readv_impl(
+           hal_handle_t{}, static_cast<const hal_iovec_t*>(nullptr), size_t{}))>>
+    : std::true_type
+{
+};
+
+}  // namespace detail
+
 /**
  * @brief UART base class with CRTP pattern
  *
@@ -97,6 +140,61 @@ class UartBase
     return Platform::uart_write_impl(handle, buf, len);
   }
 
+  /**
+   * @brief Gather-write data to UART
+   *
+   * Uses the platform's uart_writev_impl when provided, otherwise writes
+   * each segment with uart_write_impl and stops at the first short write.
+   *
+   * @param handle UART handle
+   * @param iov    Segment array
+   * @param iovcnt Number of segments
+   * @return Number of bytes written, or negative error code
+   */
+  static int writev(hal_handle_t handle, const hal_iovec_t* iov, size_t iovcnt)
+  {
+    if (!handle || (!iov && iovcnt))
+      return HAL_ERR_PARAM;
+    for (size_t i = 0; i < iovcnt; i++)
+    {
+      if (!iov[i].base && iov[i].len)
+        return HAL_ERR_PARAM;
+    }
+
+    if constexpr (detail::has_uart_writev_impl<Platform>::value)
+    {
+      return Platform::uart_writev_impl(handle, iov, iovcnt);
+    }
+    else
+    {
+      int total = 0;
+      for (size_t i = 0; i < iovcnt; i++)
+      {
+        int ret = Platform::uart_write_impl(
+            handle, static_cast<const uint8_t*>(iov[i].base), iov[i].len);
+        if (ret < 0)
+          return (total > 0) ? total : ret;
+        total += ret;
+        if (static_cast<size_t>(ret) < iov[i].len)
+          break;
+      }
+      return total;
+    }
+  }
+
+  /**
+   * @brief Flush buffered transmit data
+   *
+   * @param handle UART handle
+   * @return HAL_OK on success, or negative error code
+   */
+  static int flush(hal_handle_t handle)
+  {
+    if (!handle)
+      return HAL_ERR_PARAM;
+    return Platform::uart_flush_impl(handle);
+  }
+
   /**
    * @brief Read data from UART
    *
@@ -114,6 +212,167 @@ class UartBase
     return Platform::uart_read_impl(handle, buf, len);
   }
 
+  /**
+   * @brief Read data from UART, waiting up to a timeout
+   *
+   * @param handle     UART handle
+   * @param buf        Destination buffer
+   * @param len        Bytes to read
+   * @param timeout_us Timeout in microseconds, or HAL_UART_WAIT_FOREVER
+   * @return Number of bytes read (short on timeout), or negative error code
+   */
+  static int read_timeout(hal_handle_t handle, uint8_t* buf, size_t len,
+                          uint32_t timeout_us)
+  {
+    if (!handle || !buf)
+      return HAL_ERR_PARAM;
+    if (len == 0)
+      return 0;
+    return Platform::uart_read_timeout_impl(handle, buf, len, timeout_us);
+  }
+
+  /**
+   * @brief Read data from UART up to and including a delimiter
+   *
+   * Scans buffered data in place through rx_peek and only blocks (via
+   * uart_read_timeout_impl) when the receive buffer is empty.
+   *
+   * @param handle     UART handle
+   * @param buf        Destination buffer
+   * @param len        Size of buf
+   * @param delimiter  Byte that ends the read
+   * @param timeout_us Timeout in microseconds, or HAL_UART_WAIT_FOREVER
+   * @return Number of bytes read, or negative error code
+   */
+  static int read_until(hal_handle_t handle, uint8_t* buf, size_t len, uint8_t delimiter,
+                        uint32_t timeout_us)
+  {
+    if (!handle || !buf)
+      return HAL_ERR_PARAM;
+
+    const bool forever = (timeout_us == HAL_UART_WAIT_FOREVER);
+    const uint64_t deadline = Platform::micros_impl() + timeout_us;
+    size_t total = 0;
+
+    while (total < len)
+    {
+      const uint8_t* data;
+      size_t avail;
+      int ret = Platform::uart_rx_peek_impl(handle, &data, &avail);
+      if (ret < 0)
+        return (total > 0) ? static_cast<int>(total) : ret;
+
+      if (avail != 0)
+      {
+        size_t n = (avail < len - total) ? avail : len - total;
+        const void* hit = std::memchr(data, delimiter, n);
+        if (hit)
+          n = static_cast<size_t>(static_cast<const uint8_t*>(hit) - data) + 1;
+        std::memcpy(buf + total, data, n);
+        Platform::uart_rx_consume_impl(handle, n);
+        total += n;
+        if (hit)
+          break;
+        continue;
+      }
+
+      // Nothing buffered: sleep until the next byte arrives
+      uint32_t wait_us = HAL_UART_WAIT_FOREVER;
+      if (!forever)
+      {
+        uint64_t now = Platform::micros_impl();
+        if (now >= deadline)
+          break;
+        wait_us = static_cast<uint32_t>(deadline - now);
+      }
+      ret = Platform::uart_read_timeout_impl(handle, buf + total, 1, wait_us);
+      if (ret < 0)
+        return (total > 0) ? static_cast<int>(total) : ret;
+      if (ret == 0)
+        break;
+      if (buf[total++] == delimiter)
+        break;
+    }
+    return static_cast<int>(total);
+  }
+
+  /**
+   * @brief Scatter-read data from UART
+   *
+   * Non-blocking. Uses the platform's uart_readv_impl when provided,
+   * otherwise reads each segment with uart_read_impl and stops at the
+   * first short read.
+   *
+   * @param handle UART handle
+   * @param iov    Segment array
+   * @param iovcnt Number of segments
+   * @return Number of bytes read, or negative error code
+   */
+  static int readv(hal_handle_t handle, const hal_iovec_t* iov, size_t iovcnt)
+  {
+    if (!handle || (!iov && iovcnt))
+      return HAL_ERR_PARAM;
+    for (size_t i = 0; i < iovcnt; i++)
+    {
+      if (!iov[i].base && iov[i].len)
+        return HAL_ERR_PARAM;
+    }
+
+    if constexpr (detail::has_uart_readv_impl<Platform>::value)
+    {
+      return Platform::uart_readv_impl(handle, iov, iovcnt);
+    }
+    else
+    {
+      int total = 0;
+      for (size_t i = 0; i < iovcnt; i++)
+      {
+        auto* dst = static_cast<uint8_t*>(iov[i].base);
+        int ret = Platform::uart_read_impl(handle, dst, iov[i].len);
+        if (ret < 0)
+          return (total > 0) ? total : ret;
+        total += ret;
+        if (static_cast<size_t>(ret) < iov[i].len)
+          break;
+      }
+      return total;
+    }
+  }
+
+  /**
+   * @brief Borrow a view of received data without copying
+   *
+   * The view covers the contiguous bytes at the read position and stays
+   * valid until the next consume/read on the same handle.
+   *
+   * @param handle UART handle
+   * @param data   Receives pointer to received data
+   * @param len    Receives number of contiguous bytes (0 if none)
+   * @return HAL_OK on success, or negative error code
+   */
+  static int rx_peek(hal_handle_t handle, const uint8_t** data, size_t* len)
+  {
+    if (!handle || !data || !len)
+      return HAL_ERR_PARAM;
+    return Platform::uart_rx_peek_impl(handle, data, len);
+  }
+
+  /**
+   * @brief Release bytes previously returned by rx_peek()
+   *
+   * @param handle UART handle
+   * @param len    Number of bytes to release
+   * @return HAL_OK on success, or negative error code
+   */
+  static int rx_consume(hal_handle_t handle, size_t len)
+  {
+    if (!handle)
+      return HAL_ERR_PARAM;
+    if (len == 0)
+      return HAL_OK;
+    return Platform::uart_rx_consume_impl(handle, len);
+  }
+
   /**
    * @brief Get number of bytes available in receive buffer
    *
@@ -205,6 +464,28 @@ class Uart
     return UartBase<Platform>::write(handle_, buf, len);
   }
 
+  /**
+   * @brief Gather-write data to UART
+   *
+   * @param iov    Segment array
+   * @param iovcnt Number of segments
+   * @return Number of bytes written, or negative error code
+   */
+  int writev(const hal_iovec_t* iov, size_t iovcnt)
+  {
+    return UartBase<Platform>::writev(handle_, iov, iovcnt);
+  }
+
+  /**
+   * @brief Flush buffered transmit data
+   *
+   * @return HAL_OK on success, or negative error code
+   */
+  int flush()
+  {
+    return UartBase<Platform>::flush(handle_);
+  }
+
   /**
    * @brief Read data from UART
    *
@@ -217,6 +498,68 @@ class Uart
     return UartBase<Platform>::read(handle_, buf, len);
   }
 
+  /**
+   * @brief Read data from UART, waiting up to a timeout
+   *
+   * @param buf        Destination buffer
+   * @param len        Bytes to read
+   * @param timeout_us Timeout in microseconds, or HAL_UART_WAIT_FOREVER
+   * @return Number of bytes read (short on timeout), or negative error code
+   */
+  int read_timeout(uint8_t* buf, size_t len, uint32_t timeout_us)
+  {
+    return UartBase<Platform>::read_timeout(handle_, buf, len, timeout_us);
+  }
+
+  /**
+   * @brief Read data from UART up to and including a delimiter
+   *
+   * @param buf        Destination buffer
+   * @param len        Size of buf
+   * @param delimiter  Byte that ends the read
+   * @param timeout_us Timeout in microseconds, or HAL_UART_WAIT_FOREVER
+   * @return Number of bytes read, or negative error code
+   */
+  int read_until(uint8_t* buf, size_t len, uint8_t delimiter, uint32_t timeout_us)
+  {
+    return UartBase<Platform>::read_until(handle_, buf, len, delimiter, timeout_us);
+  }
+
+  /**
+   * @brief Scatter-read data from UART
+   *
+   * @param iov    Segment array
+   * @param iovcnt Number of segments
+   * @return Number of bytes read, or negative error code
+   */
+  int readv(const hal_iovec_t* iov, size_t iovcnt)
+  {
+    return UartBase<Platform>::readv(handle_, iov, iovcnt);
+  }
+
+  /**
+   * @brief Borrow a view of received data without copying
+   *
+   * @param data Receives pointer to received data
+   * @param len  Receives number of contiguous bytes (0 if none)
+   * @return HAL_OK on success, or negative error code
+   */
+  int rx_peek(const uint8_t** data, size_t* len)
+  {
+    return UartBase<Platform>::rx_peek(handle_, data, len);
+  }
+
+  /**
+   * @brief Release bytes previously returned by rx_peek()
+   *
+   * @param len Number of bytes to release
+   * @return HAL_OK on success, or negative error code
+   */
+  int rx_consume(size_t len)
+  {
+    return UartBase<Platform>::rx_consume(handle_, len);
+  }
+
   /**
    * @brief Get bytes available in receive buffer
    *
@@ -0,0 +1,73 @@
+#ifndef V4_HAL_VARINT_HPP
+#define V4_HAL_VARINT_HPP
+
+/**
+ * @file varint.hpp
+ * @brief Unsigned LEB128 variable-length integers
+ *
+ * Values are stored 7 bits per byte, least significant group first, with
+ * the top bit set on every byte but the last, so small values (time
+ * deltas, pin numbers) take one or two bytes. Used by the simulation
+ * trace formats.
+ */
+
+#include <cstddef>
+#include <cstdint>
+
+namespace v4
+{
+namespace hal
+{
+
+/**
+ * @brief Longest encoding of a 64-bit value
+ */
+constexpr size_t kVarintMaxBytes = 10;
+
+/**
+ * @brief Encode v
+ *
+ * @param v   Value
+ * @param out Receives up to kVarintMaxBytes bytes
+ * @return Number of bytes written
+ */
+inline size_t varint_encode(uint64_t v, uint8_t* out)
+{
+  size_t n = 0;
+  while (v >= 0x80)
+  {
+    out[n++] = static_cast<uint8_t>(v | 0x80);
+    v >>= 7;
+  }
+  out[n++] = static_cast<uint8_t>(v);
+  return n;
+}
+
+/**
+ * @brief Decode one value
+ *
+ * @param p   Encoded bytes
+ * @param len Bytes available at p
+ * @param v   Receives the value
+ * @return Number of bytes consumed, 0 if p holds no complete value (or
+ *         one longer than kVarintMaxBytes)
+ */
+inline size_t varint_decode(const uint8_t* p, size_t len, uint64_t* v)
+{
+  uint64_t value = 0;
+  for (size_t i = 0; i < len && i < kVarintMaxBytes; i++)
+  {
+    value |= static_cast<uint64_t>(p[i] & 0x7f) << (7 * i);
+    if (!(p[i] & 0x80))
+    {
+      *v = value;
+      return i + 1;
+    }
+  }
+  return 0;
+}
+
+}  // namespace hal
+}  // namespace v4
+
+#endif  // V4_HAL_VARINT_HPP
@@ -6,7 +6,29 @@
 #define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
 #include <doctest/doctest.h>
 
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/internal/queue.hpp"
+#include "../src/internal/timer_impl.hpp"
+#include "../src/internal/timer_wheel.hpp"
+#include "../src/internal/varint.hpp"
 #include "v4/hal.hpp"
+#include "v4/hal_sys.h"
+#include "v4/hal_sim.h"
 
 TEST_CASE("Error class")
 {
@@ -106,9 +128,191 @@ TEST_CASE("GpioPin")
   }
 }
 
+TEST_CASE("GPIO port operations")
+{
+  const uint64_t bus = 0xFull << 24;  // Pins 24-27
+  v4::hal::gpio_mode_mask(bus, HAL_GPIO_OUTPUT);
+
+  v4::hal::gpio_write_mask(0x5ull << 24, 0xAull << 24);
+  CHECK((v4::hal::gpio_read_port() & bus) == (0x5ull << 24));
+  CHECK(v4::hal::GpioPin(26, HAL_GPIO_OUTPUT).read() == HAL_GPIO_HIGH);
+
+  // Pins outside both masks keep their level
+  v4::hal::gpio_write_mask(0x2ull << 24, 0);
+  CHECK((v4::hal::gpio_read_port() & bus) == (0x7ull << 24));
+
+  CHECK(hal_gpio_write_mask(1ull << 24, 1ull << 24) == HAL_ERR_PARAM);
+  CHECK(hal_gpio_read_port(nullptr) == HAL_ERR_PARAM);
+
+  // Inputs cannot be driven
+  v4::hal::gpio_mode_mask(bus, HAL_GPIO_INPUT);
+  CHECK(hal_gpio_write_mask(1ull << 24, 0) == HAL_ERR_PARAM);
+
+  SUBCASE("Banks")
+  {
+    const int pins = hal_get_capabilities()->gpio_count;
+    const int banks = (pins + 63) / 64;
+    if (pins < 64)
+      CHECK(hal_gpio_write_mask(1ull << pins, 0) == HAL_ERR_PARAM);
+
+    // Last pin of the last bank
+    const int bank = (pins - 1) / 64;
+    const uint64_t bit = 1ull << ((pins - 1) % 64);
+    v4::hal::gpio_mode_bank(bank, bit, HAL_GPIO_OUTPUT);
+    v4::hal::gpio_write_bank(bank, bit, 0);
+    CHECK((v4::hal::gpio_read_bank(bank) & bit) != 0);
+    CHECK(v4::hal::GpioPin(pins - 1, HAL_GPIO_OUTPUT).read() == HAL_GPIO_HIGH);
+    v4::hal::gpio_write_bank(bank, 0, bit);
+    CHECK((v4::hal::gpio_read_bank(bank) & bit) == 0);
+
+    uint64_t value;
+    CHECK(hal_gpio_read_bank(banks, &value) == HAL_ERR_PARAM);
+    CHECK(hal_gpio_read_bank(-1, &value) == HAL_ERR_PARAM);
+    CHECK(hal_gpio_mode_bank(banks, 1, HAL_GPIO_OUTPUT) == HAL_ERR_PARAM);
+  }
+}
+
+TEST_CASE("GPIO concurrent access")
+{
+  // Each thread owns one pin; with a shared non-atomic bitmap the
+  // read-modify-writes would clobber each other's bits
+  const int kThreads = 4;
+  const int kToggles = 10001;
+  for (int t = 0; t < kThreads; t++)
+    hal_gpio_mode(16 + t, HAL_GPIO_OUTPUT);
+  v4::hal::gpio_write_mask(0, 0xFull << 16);
+
+  std::thread workers[kThreads];
+  for (int t = 0; t < kThreads; t++)
+  {
+    workers[t] = std::thread([t] {
+      for (int i = 0; i < kToggles; i++)
+        hal_gpio_toggle(16 + t);
+    });
+  }
+  for (auto& w : workers)
+    w.join();
+
+  // An odd number of toggles leaves every pin high
+  CHECK((v4::hal::gpio_read_port() & (0xFull << 16)) == (0xFull << 16));
+}
+
+static std::atomic<uint32_t> irq_hits{0};
+
+static void count_irq(int pin, void* user_data)
+{
+  irq_hits.fetch_or(1u << pin);
+  static_cast<std::atomic<int>*>(user_data)->fetch_add(1);
+}
+
+// Wait for the IRQ dispatch thread to deliver at least n calls
+static bool wait_irq_count(const std::atomic<int>& count, int n)
+{
+  uint32_t start = v4::hal::millis();
+  while (count.load() < n && v4::hal::millis() - start < 1000)
+    v4::hal::delay_ms(1);
+  return count.load() >= n;
+}
+
+TEST_CASE("GPIO interrupts")
+{
+  std::atomic<int> count{0};
+  irq_hits = 0;
+  v4::hal::GpioPin a(20, HAL_GPIO_INPUT);
+  v4::hal::GpioPin b(21, HAL_GPIO_INPUT);
+  hal_sim_gpio_input(20, HAL_GPIO_LOW);
+  hal_sim_gpio_input(21, HAL_GPIO_HIGH);
+
+  REQUIRE(hal_gpio_irq_attach(20, HAL_GPIO_IRQ_RISING, count_irq, &count) == HAL_OK);
+  REQUIRE(hal_gpio_irq_attach(21, HAL_GPIO_IRQ_FALLING, count_irq, &count) == HAL_OK);
+  CHECK(hal_gpio_irq_attach(20, HAL_GPIO_IRQ_BOTH, count_irq, &count) == HAL_ERR_BUSY);
+
+  SUBCASE("Edges dispatch to per-pin handlers")
+  {
+    hal_sim_gpio_input(20, HAL_GPIO_HIGH);
+    hal_sim_gpio_input(21, HAL_GPIO_LOW);
+    CHECK(wait_irq_count(count, 2));
+    CHECK(irq_hits.load() == ((1u << 20) | (1u << 21)));
+    CHECK(a.read() == HAL_GPIO_HIGH);
+
+    // Opposite edges are ignored
+    hal_sim_gpio_input(20, HAL_GPIO_LOW);
+    hal_sim_gpio_input(21, HAL_GPIO_HIGH);
+    v4::hal::delay_ms(20);
+    CHECK(count.load() == 2);
+  }
+
+  SUBCASE("Disabled pins are masked")
+  {
+    REQUIRE(hal_gpio_irq_disable(20) == HAL_OK);
+    hal_sim_gpio_input(20, HAL_GPIO_HIGH);
+    v4::hal::delay_ms(20);
+    CHECK(count.load() == 0);
+
+    REQUIRE(hal_gpio_irq_enable(20) == HAL_OK);
+    hal_sim_gpio_input(20, HAL_GPIO_LOW);
+    hal_sim_gpio_input(20, HAL_GPIO_HIGH);
+    CHECK(wait_irq_count(count, 1));
+  }
+
+  SUBCASE("Output writes raise interrupts")
+  {
+    v4::hal::GpioPin out(22, HAL_GPIO_OUTPUT);
+    out.write(HAL_GPIO_LOW);
+    REQUIRE(hal_gpio_irq_attach(22, HAL_GPIO_IRQ_BOTH, count_irq, &count) == HAL_OK);
+    CHECK(hal_sim_gpio_input(22, HAL_GPIO_HIGH) == HAL_ERR_PARAM);
+    out.write(HAL_GPIO_HIGH);
+    out.write(HAL_GPIO_LOW);
+    CHECK(wait_irq_count(count, 1));
+    CHECK(hal_gpio_irq_detach(22) == HAL_OK);
+  }
+
+  CHECK(hal_gpio_irq_detach(20) == HAL_OK);
+  CHECK(hal_gpio_irq_detach(21) == HAL_OK);
+  CHECK(hal_gpio_irq_detach(21) == HAL_ERR_PARAM);
+}
+
+static hal_uart_config_t uart_config(int baudrate,
+                                     hal_uart_backend_t backend = HAL_UART_BACKEND_DEFAULT,
+                                     const char* path = nullptr)
+{
+  hal_uart_config_t config = {};
+  config.baudrate = baudrate;
+  config.data_bits = 8;
+  config.stop_bits = 1;
+  config.backend = backend;
+  config.path = path;
+  return config;
+}
+
+// Connect a client to a socket-backed UART and wait until it is accepted
+static int uart_connect(v4::hal::Uart& uart, const char* path)
+{
+  int client = socket(AF_UNIX, SOCK_STREAM, 0);
+  struct sockaddr_un addr = {};
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path, path);
+  if (connect(client, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0)
+  {
+    close(client);
+    return -1;
+  }
+
+  // UART writes are discarded until the client is accepted; a probe byte
+  // arriving in the RX ring shows the connection is live
+  if (write(client, "?", 1) != 1)
+    return client;
+  uint32_t start = v4::hal::millis();
+  while (uart.available() == 0 && v4::hal::millis() - start < 1000)
+    v4::hal::delay_ms(1);
+  uint8_t probe;
+  uart.read(&probe, 1);
+  return client;
+}
+
 TEST_CASE("Uart")
 {
-  hal_uart_config_t config = {115200, 8, 1, 0};
+  hal_uart_config_t config = uart_config(115200);
 
   SUBCASE("Construction")
   {
@@ -132,6 +336,288 @@ TEST_CASE("Uart")
     CHECK(avail >= 0);
   }
 
+  SUBCASE("Receive via RX ring")
+  {
+    // Feed port 0 (stdin) from a pipe
+    int fds[2];
+    REQUIRE(pipe(fds) == 0);
+    int saved_stdin = dup(STDIN_FILENO);
+    dup2(fds[0], STDIN_FILENO);
+
+    {
+      v4::hal::Uart uart(0, config);
+      REQUIRE(write(fds[1], "ping", 4) == 4);
+
+      uint32_t start = v4::hal::millis();
+      while (uart.available() < 4 && v4::hal::millis() - start < 1000)
+        v4::hal::delay_ms(1);
+
+      CHECK(uart.available() == 4);
+      uint8_t buf[8] = {};
+      CHECK(uart.read(buf, sizeof(buf)) == 4);
+      CHECK(std::memcmp(buf, "ping", 4) == 0);
+      CHECK(uart.available() == 0);
+    }
+
+    dup2(saved_stdin, STDIN_FILENO);
+    close(saved_stdin);
+    close(fds[0]);
+    close(fds[1]);
+  }
+
+  SUBCASE("One STDIO port owns stdin")
+  {
+    int fds[2];
+    REQUIRE(pipe(fds) == 0);
+    int saved_stdin = dup(STDIN_FILENO);
+    dup2(fds[0], STDIN_FILENO);
+
+    v4::hal::Context a;
+    v4::hal::Context b;
+    hal_handle_t first;
+    hal_handle_t second;
+    {
+      v4::hal::ContextBinding bind(a);
+      first = hal_uart_open(0, &config);
+    }
+    {
+      v4::hal::ContextBinding bind(b);
+      second = hal_uart_open(0, &config);
+    }
+    REQUIRE(first);
+    REQUIRE(second);
+    uint8_t buf[8] = {};
+    CHECK(hal_console_read(buf, sizeof(buf)) == HAL_ERR_BUSY);
+
+    REQUIRE(write(fds[1], "ab", 2) == 2);
+    CHECK(hal_uart_read_timeout(first, buf, 2, 1000000) == 2);
+    CHECK(std::memcmp(buf, "ab", 2) == 0);
+    CHECK(hal_uart_read_timeout(second, buf, 1, 20000) == 0);
+
+    // Closing the owner hands stdin to the other port
+    CHECK(hal_uart_close(first) == HAL_OK);
+    REQUIRE(write(fds[1], "c", 1) == 1);
+    CHECK(hal_uart_read_timeout(second, buf, 1, 1000000) == 1);
+    CHECK(buf[0] == 'c');
+    CHECK(hal_uart_close(second) == HAL_OK);
+
+    dup2(saved_stdin, STDIN_FILENO);
+    close(saved_stdin);
+    close(fds[0]);
+    close(fds[1]);
+  }
+
+  SUBCASE("Receive stdin redirected from a file")
+  {
+    char path[] = "/tmp/v4hal-test-stdin-XXXXXX";
+    int fd = mkstemp(path);
+    REQUIRE(fd >= 0);
+    REQUIRE(write(fd, "file", 4) == 4);
+    lseek(fd, 0, SEEK_SET);
+    int saved_stdin = dup(STDIN_FILENO);
+    dup2(fd, STDIN_FILENO);
+
+    {
+      v4::hal::Uart uart(0, config);
+      uint8_t buf[8] = {};
+      CHECK(uart.read_timeout(buf, 4, 1000000) == 4);
+      CHECK(std::memcmp(buf, "file", 4) == 0);
+    }
+
+    dup2(saved_stdin, STDIN_FILENO);
+    close(saved_stdin);
+    close(fd);
+    unlink(path);
+  }
+
+  SUBCASE("Unix socket backend")
+  {
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/v4hal-test-%d.sock", static_cast<int>(getpid()));
+    hal_uart_config_t sock_config = uart_config(115200, HAL_UART_BACKEND_SOCKET, path);
+    v4::hal::Uart uart(1, sock_config);
+
+    int client = socket(AF_UNIX, SOCK_STREAM, 0);
+    struct sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+    REQUIRE(connect(client, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) == 0);
+    REQUIRE(write(client, "hello", 5) == 5);
+
+    uint32_t start = v4::hal::millis();
+    while (uart.available() < 5 && v4::hal::millis() - start < 1000)
+      v4::hal::delay_ms(1);
+
+    uint8_t buf[8] = {};
+    CHECK(uart.read(buf, sizeof(buf)) == 5);
+    CHECK(std::memcmp(buf, "hello", 5) == 0);
+
+    CHECK(uart.write(reinterpret_cast<const uint8_t*>("ok"), 2) == 2);
+    char reply[4] = {};
+    CHECK(read(client, reply, sizeof(reply)) == 2);
+    CHECK(std::memcmp(reply, "ok", 2) == 0);
+    close(client);
+  }
+
+  SUBCASE("TX coalescing")
+  {
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/v4hal-test-%d.sock", static_cast<int>(getpid()));
+    hal_uart_config_t tx_config = uart_config(115200, HAL_UART_BACKEND_SOCKET, path);
+    tx_config.tx_mode = HAL_UART_TX_BLOCK;
+    tx_config.tx_flush_us = 20000;
+    v4::hal::Uart uart(1, tx_config);
+    int client = uart_connect(uart, path);
+    REQUIRE(client >= 0);
+    fcntl(client, F_SETFL, O_NONBLOCK);
+
+    // Byte-at-a-time writes are held back until an explicit flush
+    for (const char* p = "abc"; *p; p++)
+      uart.write(reinterpret_cast<const uint8_t*>(p), 1);
+    char reply[8] = {};
+    CHECK(read(client, reply, sizeof(reply)) < 0);
+    uart.flush();
+    CHECK(read(client, reply, sizeof(reply)) == 3);
+    CHECK(std::memcmp(reply, "abc", 3) == 0);
+
+    // Unflushed data goes out once the latency deadline passes
+    uart.write(reinterpret_cast<const uint8_t*>("d"), 1);
+    int n = -1;
+    uint32_t start = v4::hal::millis();
+    while (n < 0 && v4::hal::millis() - start < 1000)
+    {
+      v4::hal::delay_ms(1);
+      n = static_cast<int>(read(client, reply, sizeof(reply)));
+    }
+    CHECK(n == 1);
+    CHECK(v4::hal::millis() - start >= 10);
+    close(client);
+  }
+
+  SUBCASE("Scatter-gather I/O")
+  {
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/v4hal-test-%d.sock", static_cast<int>(getpid()));
+    hal_uart_config_t sg_config = uart_config(115200, HAL_UART_BACKEND_SOCKET, path);
+    sg_config.tx_mode = HAL_UART_TX_UNBUFFERED;
+    v4::hal::Uart uart(1, sg_config);
+    int client = uart_connect(uart, path);
+    REQUIRE(client >= 0);
+
+    // Header, payload and CRC leave as one contiguous frame
+    char header[] = "HDR";
+    char payload[] = "payload";
+    char crc[] = "CR";
+    hal_iovec_t tx[] = {{header, 3}, {payload, 7}, {crc, 2}};
+    CHECK(uart.writev(tx, 3) == 12);
+    char frame[16] = {};
+    CHECK(read(client, frame, sizeof(frame)) == 12);
+    CHECK(std::memcmp(frame, "HDRpayloadCR", 12) == 0);
+
+    // One read fills several segments in order
+    REQUIRE(write(client, "0123456789", 10) == 10);
+    uint32_t start = v4::hal::millis();
+    while (uart.available() < 10 && v4::hal::millis() - start < 1000)
+      v4::hal::delay_ms(1);
+    char a[4] = {};
+    char b[16] = {};
+    hal_iovec_t rx[] = {{a, 4}, {b, sizeof(b)}};
+    CHECK(uart.readv(rx, 2) == 10);
+    CHECK(std::memcmp(a, "0123", 4) == 0);
+    CHECK(std::memcmp(b, "456789", 6) == 0);
+    close(client);
+  }
+
+  SUBCASE("Zero-copy receive")
+  {
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/v4hal-test-%d.sock", static_cast<int>(getpid()));
+    hal_uart_config_t peek_config = uart_config(115200, HAL_UART_BACKEND_SOCKET, path);
+    v4::hal::Uart uart(1, peek_config);
+    int client = uart_connect(uart, path);
+    REQUIRE(client >= 0);
+
+    const uint8_t* data = nullptr;
+    size_t len = 1;
+    uart.rx_peek(&data, &len);
+    CHECK(len == 0);
+
+    REQUIRE(write(client, "GET /\n", 6) == 6);
+    uint32_t start = v4::hal::millis();
+    while (uart.available() < 6 && v4::hal::millis() - start < 1000)
+      v4::hal::delay_ms(1);
+
+    // Tokenize in place, then release only the first token
+    uart.rx_peek(&data, &len);
+    REQUIRE(len == 6);
+    CHECK(std::memcmp(data, "GET", 3) == 0);
+    uart.rx_consume(4);
+    CHECK(uart.available() == 2);
+    CHECK_THROWS_AS(uart.rx_consume(3), v4::hal::Error);
+
+    uint8_t rest[4] = {};
+    CHECK(uart.read(rest, sizeof(rest)) == 2);
+    CHECK(std::memcmp(rest, "/\n", 2) == 0);
+    close(client);
+  }
+
+  SUBCASE("Timed reads")
+  {
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/v4hal-test-%d.sock", static_cast<int>(getpid()));
+    hal_uart_config_t timed_config = uart_config(115200, HAL_UART_BACKEND_SOCKET, path);
+    v4::hal::Uart uart(1, timed_config);
+    int client = uart_connect(uart, path);
+    REQUIRE(client >= 0);
+
+    // Nothing arrives: returns empty once the timeout passes
+    uint8_t buf[16] = {};
+    uint64_t start = v4::hal::micros();
+    CHECK(uart.read_timeout(buf, 4, 20000) == 0);
+    CHECK(v4::hal::micros() - start >= 20000);
+
+    // A late writer wakes the blocked reader
+    ssize_t sent = 0;
+    std::thread writer([client, &sent] {
+      v4::hal::delay_ms(10);
+      sent = write(client, "wxyz", 4);
+    });
+    CHECK(uart.read_timeout(buf, 4, 1000000) == 4);
+    CHECK(std::memcmp(buf, "wxyz", 4) == 0);
+    writer.join();
+    CHECK(sent == 4);
+
+    // Records are split at the delimiter; the remainder stays buffered
+    REQUIRE(write(client, "one\ntwo", 7) == 7);
+    int n = uart.read_until(buf, sizeof(buf), '\n', 1000000);
+    CHECK(n == 4);
+    CHECK(std::memcmp(buf, "one\n", 4) == 0);
+    CHECK(uart.read_until(buf, sizeof(buf), '\n', 20000) == 3);
+    CHECK(std::memcmp(buf, "two", 3) == 0);
+    close(client);
+  }
+
+  SUBCASE("PTY backend")
+  {
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/v4hal-test-%d.pty", static_cast<int>(getpid()));
+    hal_uart_config_t pty_config = uart_config(115200, HAL_UART_BACKEND_PTY, path);
+    v4::hal::Uart uart(2, pty_config);
+
+    int peer = open(path, O_RDWR | O_NOCTTY);
+    REQUIRE(peer >= 0);
+    REQUIRE(write(peer, "AT\r", 3) == 3);
+
+    uint32_t start = v4::hal::millis();
+    while (uart.available() < 3 && v4::hal::millis() - start < 1000)
+      v4::hal::delay_ms(1);
+
+    uint8_t buf[8] = {};
+    CHECK(uart.read(buf, sizeof(buf)) == 3);
+    CHECK(std::memcmp(buf, "AT\r", 3) == 0);
+    close(peer);
+  }
+
   SUBCASE("Move semantics")
   {
     v4::hal::Uart uart1(0, config);
@@ -143,7 +629,7 @@ TEST_CASE("Uart")
   SUBCASE("Move assignment")
   {
     v4::hal::Uart uart1(0, config);
-    hal_uart_config_t config2 = {9600, 8, 1, 0};
+    hal_uart_config_t config2 = uart_config(9600);
     v4::hal::Uart uart2(1, config2);
     uart2 = std::move(uart1);
     uint8_t data[] = "Test";
@@ -174,6 +660,1466 @@ TEST_CASE("Timer utilities")
   {
     CHECK_NOTHROW(v4::hal::delay_us(100));
   }
+
+  SUBCASE("Clock stays monotonic across hal_init()")
+  {
+    // hal_init() may switch the POSIX clock to the calibrated TSC
+    uint64_t before = v4::hal::micros();
+    v4::hal::HalSystem hal;
+    uint64_t after = v4::hal::micros();
+    CHECK(after >= before);
+
+    v4::hal::delay_ms(5);
+    uint64_t elapsed = v4::hal::micros() - after;
+    CHECK(elapsed >= 5000);
+    CHECK(elapsed < 500000);
+
+    uint32_t ms = v4::hal::millis();
+    uint64_t us = v4::hal::micros();
+    CHECK(us / 1000 >= ms);
+    CHECK(us / 1000 - ms <= 1);
+  }
+
+  SUBCASE("Precise delays")
+  {
+    uint64_t start = v4::hal::micros();
+    v4::hal::delay_us_precise(500, 200);
+    uint64_t elapsed = v4::hal::micros() - start;
+    CHECK(elapsed >= 500);
+    CHECK(elapsed < 50000);
+
+    // Pure spin
+    start = v4::hal::micros();
+    v4::hal::delay_us_precise(100, 100);
+    CHECK(v4::hal::micros() - start >= 100);
+  }
+
+  SUBCASE("delay_until_us()")
+  {
+    const uint64_t period = 2000;
+    uint64_t start = v4::hal::micros();
+    uint64_t deadline = start;
+    for (int i = 0; i < 5; i++)
+    {
+      v4::hal::delay_us(300);  // Loop body time must not accumulate
+      deadline += period;
+      v4::hal::delay_until_us(deadline);
+      CHECK(v4::hal::micros() >= deadline);
+    }
+    CHECK(v4::hal::micros() - start < 5 * period + 20000);
+
+    // A past deadline returns at once
+    uint64_t now = v4::hal::micros();
+    v4::hal::delay_until_us(now - 1000);
+    CHECK(v4::hal::micros() - now < 20000);
+  }
+
+  SUBCASE("Clock sources")
+  {
+    const hal_clock_source_t initial = v4::hal::timer_get_source();
+    for (hal_clock_source_t source :
+         {HAL_CLOCK_MONOTONIC, HAL_CLOCK_COARSE, HAL_CLOCK_RAW, HAL_CLOCK_TSC})
+    {
+      CAPTURE(source);
+      int ret = hal_timer_set_source(source);
+      if (source == HAL_CLOCK_TSC && ret == HAL_ERR_NOTSUP)
+        continue;  // No usable TSC on this host
+      REQUIRE(ret == HAL_OK);
+      CHECK(v4::hal::timer_get_source() == source);
+
+      uint64_t us = v4::hal::micros();
+      uint32_t ms = v4::hal::millis();
+      v4::hal::delay_ms(20);
+      CHECK(v4::hal::micros() - us >= 20000);
+      CHECK(v4::hal::millis() - ms >= 10);  // Coarse ticks may lag by a few ms
+    }
+
+    CHECK(hal_timer_set_source(static_cast<hal_clock_source_t>(99)) == HAL_ERR_PARAM);
+    v4::hal::timer_set_source(initial);
+  }
+
+  SUBCASE("Switching sources never steps time backwards")
+  {
+    const hal_clock_source_t initial = v4::hal::timer_get_source();
+    const hal_clock_source_t sources[] = {HAL_CLOCK_MONOTONIC, HAL_CLOCK_COARSE,
+                                          HAL_CLOCK_RAW, HAL_CLOCK_TSC};
+    bool monotonic = true;
+    for (int i = 0; i < 200; i++)
+    {
+      uint64_t us = v4::hal::micros();
+      uint32_t ms = v4::hal::millis();
+      if (hal_timer_set_source(sources[i % 4]) != HAL_OK)
+        continue;  // No usable TSC on this host
+      monotonic = monotonic && v4::hal::micros() >= us &&
+                  static_cast<int32_t>(v4::hal::millis() - ms) >= 0;
+    }
+    CHECK(monotonic);
+    v4::hal::timer_set_source(initial);
+  }
+}
+
+// Manually advanced clock for deterministic TimerBase tests
+struct FakeClockPlatform
+{
+  static inline uint64_t now = 0;
+
+  static uint32_t millis_impl()
+  {
+    return static_cast<uint32_t>(now / 1000);
+  }
+  static uint64_t micros_impl()
+  {
+    return now;
+  }
+  static void delay_ms_impl(uint32_t ms)
+  {
+    now += uint64_t{ms} * 1000;
+  }
+  static void delay_us_impl(uint32_t us)
+  {
+    now += us;
+  }
+  static void delay_until_us_impl(uint64_t deadline_us)
+  {
+    if (deadline_us > now)
+      now = deadline_us;
+  }
+};
+
+TEST_CASE("PeriodicTimer")
+{
+  using Clock = FakeClockPlatform;
+  Clock::now = 5000;
+  v4::hal::PeriodicTimer<Clock> tick(1000);
+  CHECK(tick.next_wakeup_us() == 6000);
+
+  SUBCASE("On time")
+  {
+    for (int i = 0; i < 3; i++)
+    {
+      Clock::now += 300;  // Loop body
+      CHECK(tick.wait() == 0);
+      CHECK(Clock::now == 6000 + 1000u * i);
+    }
+    CHECK(tick.overruns() == 0);
+  }
+
+  SUBCASE("Overrun skips passed boundaries")
+  {
+    Clock::now += 3500;  // Past 6000, 7000 and 8000
+    CHECK(tick.wait() == 2);
+    CHECK(Clock::now == 8500);  // Returns at once
+    CHECK(tick.next_wakeup_us() == 9000);
+    CHECK(tick.overruns() == 1);
+    CHECK(tick.missed_periods() == 2);
+
+    CHECK(tick.wait() == 0);
+    CHECK(Clock::now == 9000);  // Back on the original phase
+  }
+
+  SUBCASE("reset()")
+  {
+    Clock::now = 20000;
+    tick.reset();
+    CHECK(tick.wait() == 0);
+    CHECK(Clock::now == 21000);
+  }
+}
+
+TEST_CASE("TimerWheel")
+{
+  using v4::hal::TimerWheel;
+  using v4::hal::TimerWheelNode;
+  TimerWheel wheel;
+  wheel.reset(1000);
+
+  SUBCASE("Fires each timer exactly at its tick")
+  {
+    std::mt19937_64 rng(42);
+    std::vector<TimerWheelNode> nodes(500);
+    std::vector<uint64_t> due(nodes.size());
+    for (size_t i = 0; i < nodes.size(); i++)
+    {
+      // Mix of near, cascading and beyond-range expiries
+      uint64_t range = (i % 3 == 0) ? 64 : (i % 3 == 1) ? 300000 : 3 * TimerWheel::kRange;
+      due[i] = 1000 + rng() % range;
+      wheel.insert(&nodes[i], due[i]);
+    }
+    CHECK(wheel.size() == nodes.size());
+
+    size_t fired = 0;
+    bool exact = true;
+    uint64_t now = 1000;
+    while (wheel.size())
+    {
+      uint64_t next = wheel.next_event();
+      REQUIRE(next >= wheel.current());
+      now = next + rng() % 4;  // Driver may wake late
+      TimerWheelNode* expired = nullptr;
+      wheel.advance(now, &expired);
+      for (; expired; expired = expired->next, fired++)
+      {
+        size_t i = static_cast<size_t>(expired - nodes.data());
+        exact = exact && due[i] <= now && due[i] + 4 > now;
+      }
+    }
+    CHECK(exact);
+    CHECK(fired == nodes.size());
+  }
+
+  SUBCASE("remove()")
+  {
+    TimerWheelNode a, b;
+    wheel.insert(&a, 1010);
+    wheel.insert(&b, 5000);
+    wheel.remove(&a);
+    wheel.remove(&a);  // No-op
+    CHECK(wheel.size() == 1);
+    CHECK(wheel.next_event() <= 5000);
+
+    TimerWheelNode* expired = nullptr;
+    wheel.advance(4999, &expired);
+    CHECK(expired == nullptr);
+    wheel.advance(5000, &expired);
+    CHECK(expired == &b);
+    CHECK(wheel.next_event() == TimerWheel::kNever);
+  }
+
+  SUBCASE("Past expiry fires on next advance()")
+  {
+    TimerWheelNode a;
+    wheel.insert(&a, 10);
+    CHECK(wheel.next_event() == 1000);
+    TimerWheelNode* expired = nullptr;
+    wheel.advance(1000, &expired);
+    CHECK(expired == &a);
+  }
+}
+
+TEST_CASE("Software timers")
+{
+  v4::hal::HalSystem hal;
+
+  struct Counter
+  {
+    std::atomic<int> calls{0};
+    std::atomic<uint64_t> first_us{0};
+  };
+  auto on_expiry = [](hal_handle_t, void* user_data)
+  {
+    auto* c = static_cast<Counter*>(user_data);
+    uint64_t zero = 0;
+    c->first_us.compare_exchange_strong(zero, hal_micros());
+    c->calls++;
+  };
+  auto wait_for = [](const std::atomic<int>& calls, int n)
+  {
+    for (int i = 0; i < 500 && calls.load() < n; i++)
+      hal_delay_ms(1);
+    return calls.load() >= n;
+  };
+
+  SUBCASE("One-shot")
+  {
+    Counter c;
+    v4::hal::SoftTimer timer(on_expiry, &c);
+    uint64_t start = hal_micros();
+    timer.start(5000);
+    CHECK(wait_for(c.calls, 1));
+    CHECK(c.first_us.load() >= start + 5000);
+    hal_delay_ms(20);
+    CHECK(c.calls.load() == 1);
+  }
+
+  SUBCASE("Periodic")
+  {
+    Counter c;
+    v4::hal::SoftTimer timer(on_expiry, &c);
+    timer.start(2000, 2000);
+    CHECK(wait_for(c.calls, 5));
+    timer.stop();
+    hal_delay_ms(5);  // Let a callback in flight finish
+    int stopped = c.calls.load();
+    hal_delay_ms(10);
+    CHECK(c.calls.load() == stopped);
+  }
+
+  SUBCASE("Stop before expiry")
+  {
+    Counter c;
+    v4::hal::SoftTimer timer(on_expiry, &c);
+    timer.start(10000);
+    timer.stop();
+    hal_delay_ms(20);
+    CHECK(c.calls.load() == 0);
+  }
+
+  SUBCASE("Earlier timer preempts a far one")
+  {
+    Counter far, near;
+    v4::hal::SoftTimer a(on_expiry, &far);
+    v4::hal::SoftTimer b(on_expiry, &near);
+    a.start(10000000);
+    b.start(2000);
+    CHECK(wait_for(near.calls, 1));
+    CHECK(far.calls.load() == 0);
+  }
+
+  SUBCASE("Invalid handle")
+  {
+    CHECK(hal_timer_create(nullptr, nullptr) == nullptr);
+    CHECK(hal_timer_start(nullptr, 1000, 0) == HAL_ERR_PARAM);
+    CHECK(hal_timer_stop(nullptr) == HAL_ERR_PARAM);
+    CHECK(hal_timer_delete(nullptr) == HAL_ERR_PARAM);
+  }
+}
+
+TEST_CASE("Virtual time")
+{
+  v4::hal::HalSystem hal;
+  hal_clock_source_t saved = hal_timer_get_source();
+  REQUIRE(hal_timer_set_source(HAL_CLOCK_VIRTUAL) == HAL_OK);
+  CHECK(hal_timer_get_source() == HAL_CLOCK_VIRTUAL);
+
+  SUBCASE("Delays complete without sleeping")
+  {
+    auto real_start = std::chrono::steady_clock::now();
+    uint64_t start = hal_micros();
+    hal_delay_ms(60000);
+    CHECK(hal_micros() - start == 60000000u);
+    hal_delay_us(7);
+    hal_delay_until_us(start + 60000100);
+    CHECK(hal_micros() - start == 60000100u);
+    CHECK(std::chrono::steady_clock::now() - real_start < std::chrono::seconds(1));
+  }
+
+  SUBCASE("Threads wake in deadline order")
+  {
+    std::mutex mutex;
+    std::vector<std::pair<uint64_t, int>> wakeups;
+    std::atomic<int> ready{0};
+    uint64_t start = hal_micros();
+
+    hal_sim_time_attach();  // Hold the clock until both workers are attached
+    auto worker = [&](int id, uint64_t period, int count)
+    {
+      hal_sim_time_attach();
+      ready++;
+      for (int i = 1; i <= count; i++)
+      {
+        hal_delay_until_us(start + period * i);
+        std::lock_guard<std::mutex> guard(mutex);
+        wakeups.emplace_back(hal_micros() - start, id);
+      }
+    };
+    std::thread a(worker, 0, 3000, 4);
+    std::thread b(worker, 1, 5000, 3);
+    while (ready.load() < 2)
+      std::this_thread::yield();
+    hal_sim_time_detach();  // Joining would otherwise stall the clock
+    a.join();
+    b.join();
+
+    std::vector<std::pair<uint64_t, int>> expected = {
+        {3000, 0}, {5000, 1}, {6000, 0}, {9000, 0}, {10000, 1}, {12000, 0}, {15000, 1}};
+    CHECK(wakeups == expected);
+  }
+
+  SUBCASE("Software timers follow virtual time")
+  {
+    std::atomic<int> calls{0};
+    auto on_expiry = [](hal_handle_t, void* user_data)
+    { (*static_cast<std::atomic<int>*>(user_data))++; };
+    v4::hal::SoftTimer timer(on_expiry, &calls);
+    hal_delay_until_us((hal_micros() / 1000 + 1) * 1000);  // Align to the wheel tick
+    timer.start(1000, 1000);
+    hal_delay_ms(10);
+    hal_delay_us(1);  // Let the callback due at the same instant run
+    CHECK(calls.load() == 10);
+  }
+
+  SUBCASE("UART timeouts run in virtual time")
+  {
+    hal_uart_config_t config = uart_config(115200, HAL_UART_BACKEND_NONE);
+    v4::hal::Uart idle(1, config);
+    auto real_start = std::chrono::steady_clock::now();
+    uint64_t start = hal_micros();
+    uint8_t buf[4];
+    CHECK(idle.read_timeout(buf, 1, 30000000) == 0);
+    CHECK(hal_micros() - start == 30000000u);
+    CHECK(idle.read_until(buf, sizeof(buf), '\n', 2000000) == 0);
+    CHECK(hal_micros() - start == 32000000u);
+    CHECK(std::chrono::steady_clock::now() - real_start < std::chrono::seconds(1));
+  }
+
+  SUBCASE("A blocked UART reader does not hold the clock")
+  {
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/v4hal-test-%d.fifo", static_cast<int>(getpid()));
+    hal_uart_config_t config = uart_config(115200, HAL_UART_BACKEND_FIFO, path);
+    v4::hal::Uart uart(2, config);
+
+    std::atomic<int> got{-1};
+    std::atomic<bool> attached{false};
+    std::thread reader(
+        [&]()
+        {
+          hal_sim_time_attach();
+          attached = true;
+          uint8_t b;
+          got = uart.read_timeout(&b, 1, HAL_UART_WAIT_FOREVER);
+        });
+    while (!attached.load())
+      std::this_thread::yield();
+
+    // Every step would otherwise wait V4_HAL_POSIX_VIRTUAL_STALL_US for the reader
+    auto real_start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 200; i++)
+      hal_delay_ms(1);
+    CHECK(std::chrono::steady_clock::now() - real_start < std::chrono::milliseconds(500));
+
+    char rx_path[72];
+    snprintf(rx_path, sizeof(rx_path), "%s.rx", path);
+    int fd = open(rx_path, O_WRONLY | O_NONBLOCK);
+    REQUIRE(fd >= 0);
+    CHECK(write(fd, "x", 1) == 1);
+    close(fd);
+    reader.join();
+    CHECK(got.load() == 1);
+  }
+
+  SUBCASE("hal_sim_time_advance()")
+  {
+    uint64_t start = hal_micros();
+    CHECK(hal_sim_time_advance(2500) == HAL_OK);
+    CHECK(hal_micros() == start + 2500);
+    CHECK(hal_millis() == (start + 2500) / 1000);
+  }
+
+  uint64_t left = hal_micros();
+  REQUIRE(hal_timer_set_source(saved) == HAL_OK);
+  CHECK(hal_micros() >= left);  // Leaving virtual time keeps time monotonic
+  CHECK(hal_sim_time_advance(1) == HAL_ERR_NOTSUP);
+}
+
+TEST_CASE("Critical section")
+{
+  SUBCASE("Nesting")
+  {
+    v4::hal::CriticalSection outer;
+    {
+      v4::hal::CriticalSection inner;  // Would deadlock on a plain mutex
+      hal_critical_enter();
+      hal_critical_exit();
+    }
+    CHECK(v4::hal::critical_stats().max_depth >= 3);
+  }
+
+  SUBCASE("Mutual exclusion")
+  {
+    long counter = 0;
+    auto work = [&counter]()
+    {
+      for (int i = 0; i < 20000; i++)
+      {
+        v4::hal::CriticalSection cs;
+        counter++;
+      }
+    };
+    std::thread a(work);
+    std::thread b(work);
+    work();
+    a.join();
+    b.join();
+    CHECK(counter == 60000);
+  }
+
+  SUBCASE("Contention is counted per call site")
+  {
+    hal_critical_stats_reset();
+    std::atomic<bool> entered{false};
+
+    hal_critical_enter();
+    std::thread waiter(
+        [&entered]()
+        {
+          hal_critical_enter();
+          entered = true;
+          hal_critical_exit();
+        });
+    for (int i = 0; i < 1000 && v4::hal::critical_stats().contended == 0; i++)
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));  // Let it go to sleep
+    CHECK_FALSE(entered.load());
+    hal_critical_exit();
+    waiter.join();
+    CHECK(entered.load());
+
+    hal_critical_stats_t stats = v4::hal::critical_stats();
+    CHECK(stats.contended == 1);
+    CHECK(stats.spin_acquired + stats.sleeps >= 1);
+
+    hal_critical_site_t sites[4];
+    REQUIRE(hal_critical_sites(sites, 4) == 1);
+    CHECK(sites[0].site != nullptr);
+    CHECK(sites[0].contended == 1);
+
+    hal_critical_stats_reset();
+    CHECK(v4::hal::critical_stats().contended == 0);
+    CHECK(hal_critical_sites(sites, 4) == 0);
+  }
+
+  SUBCASE("Exit releases the section its enter took")
+  {
+    v4::hal::Context board;
+    hal_context_bind(board.get());
+    hal_critical_enter();
+    hal_context_bind(nullptr);
+    hal_critical_enter();  // Nests in board's section
+    hal_critical_exit();
+    hal_critical_exit();
+
+    std::atomic<bool> entered{false};
+    std::thread other(
+        [&]()
+        {
+          v4::hal::ContextBinding bind(board);
+          v4::hal::CriticalSection cs;
+          entered = true;
+        });
+    for (int i = 0; i < 1000 && !entered.load(); i++)
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    REQUIRE(entered.load());
+    other.join();
+  }
+}
+
+TEST_CASE("Locks")
+{
+  CHECK(hal_lock_init(nullptr, "x") == HAL_ERR_PARAM);
+
+  v4::hal::Lock lock("test");
+  CHECK(std::string(lock.get()->name) == "test");
+
+  SUBCASE("Nesting")
+  {
+    v4::hal::ScopedLock outer(lock);
+    v4::hal::ScopedLock inner(lock);
+    CHECK(lock.get()->contended == 0);
+  }
+
+  SUBCASE("Mutual exclusion")
+  {
+    long counter = 0;
+    auto work = [&]()
+    {
+      for (int i = 0; i < 20000; i++)
+      {
+        v4::hal::ScopedLock guard(lock);
+        counter++;
+      }
+    };
+    std::thread a(work);
+    std::thread b(work);
+    work();
+    a.join();
+    b.join();
+    CHECK(counter == 60000);
+  }
+
+  SUBCASE("Independent locks do not contend")
+  {
+    v4::hal::Lock other("other");
+    std::atomic<bool> entered{false};
+
+    lock.acquire();
+    hal_critical_stats_reset();
+    std::thread waiter(
+        [&]()
+        {
+          v4::hal::ScopedLock guard(lock);
+          entered = true;
+        });
+    auto contended = [&]()
+    { return __atomic_load_n(&lock.get()->contended, __ATOMIC_RELAXED); };
+    for (int i = 0; i < 1000 && contended() == 0; i++)
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    {
+      v4::hal::ScopedLock guard(other);  // Free while lock is held
+      v4::hal::CriticalSection cs;       // So is the global critical section
+    }
+    CHECK_FALSE(entered.load());
+    lock.release();
+    waiter.join();
+
+    CHECK(entered.load());
+    CHECK(lock.get()->contended == 1);
+    CHECK(other.get()->contended == 0);
+    CHECK(v4::hal::critical_stats().contended == 0);
+  }
+}
+
+TEST_CASE("Queues")
+{
+  struct Item
+  {
+    uint32_t producer;
+    uint32_t seq;
+  };
+  constexpr int kProducers = 3;
+  constexpr uint32_t kItems = 20000;
+
+  // Pops until every producer's items arrived; checks per-producer order
+  auto drain = [&](auto&& pop)
+  {
+    uint32_t next[kProducers] = {};
+    uint32_t total = 0;
+    bool ordered = true;
+    Item item;
+    while (total < kProducers * kItems)
+    {
+      if (!pop(&item))
+      {
+        std::this_thread::yield();
+        continue;
+      }
+      ordered = ordered && item.producer < kProducers && item.seq == next[item.producer];
+      next[item.producer % kProducers]++;
+      total++;
+    }
+    return ordered;
+  };
+
+  SUBCASE("SpscQueue")
+  {
+    v4::hal::SpscQueue<Item, 4> q;
+    for (uint32_t i = 0; i < 4; i++)
+      CHECK(q.push({0, i}));
+    CHECK_FALSE(q.push({0, 4}));
+    CHECK(q.size() == 4);
+
+    Item item;
+    for (uint32_t i = 0; i < 4; i++)
+    {
+      REQUIRE(q.pop(&item));
+      CHECK(item.seq == i);
+    }
+    CHECK_FALSE(q.pop(&item));
+  }
+
+  SUBCASE("MpscQueue with concurrent producers")
+  {
+    static v4::hal::MpscQueue<Item, 64> q;
+    std::vector<std::thread> producers;
+    for (uint32_t p = 0; p < kProducers; p++)
+      producers.emplace_back(
+          [p]()
+          {
+            for (uint32_t i = 0; i < kItems; i++)
+              while (!q.push({p, i}))
+                std::this_thread::yield();
+          });
+    CHECK(drain([](Item* item) { return q.pop(item); }));
+    for (auto& t : producers)
+      t.join();
+    CHECK(q.size() == 0);
+  }
+
+  SUBCASE("C API")
+  {
+    alignas(4) static uint8_t storage[HAL_QUEUE_STORAGE_SIZE(sizeof(Item), 64)];
+    hal_queue_t q;
+    CHECK(hal_queue_init(&q, HAL_QUEUE_SPSC, storage, sizeof(Item), 48) == HAL_ERR_PARAM);
+    CHECK(hal_queue_init(&q, HAL_QUEUE_SPSC, nullptr, sizeof(Item), 64) == HAL_ERR_PARAM);
+    CHECK(hal_queue_init(nullptr, HAL_QUEUE_SPSC, storage, sizeof(Item), 64) ==
+          HAL_ERR_PARAM);
+
+    REQUIRE(hal_queue_init(&q, HAL_QUEUE_SPSC, storage, sizeof(Item), 2) == HAL_OK);
+    Item item = {0, 7};
+    CHECK(hal_queue_push(&q, &item) == 1);
+    CHECK(hal_queue_push(&q, &item) == 1);
+    CHECK(hal_queue_push(&q, &item) == 0);
+    CHECK(hal_queue_size(&q) == 2);
+    CHECK(hal_queue_pop(&q, &item) == 1);
+    CHECK(hal_queue_pop(&q, &item) == 1);
+    CHECK(hal_queue_pop(&q, &item) == 0);
+    CHECK(item.seq == 7);
+
+    REQUIRE(hal_queue_init(&q, HAL_QUEUE_MPSC, storage, sizeof(Item), 64) == HAL_OK);
+    std::vector<std::thread> producers;
+    for (uint32_t p = 0; p < kProducers; p++)
+      producers.emplace_back(
+          [p, &q]()
+          {
+            for (uint32_t i = 0; i < kItems; i++)
+            {
+              Item out = {p, i};
+              while (hal_queue_push(&q, &out) != 1)
+                std::this_thread::yield();
+            }
+          });
+    CHECK(drain([&q](Item* out) { return hal_queue_pop(&q, out) == 1; }));
+    for (auto& t : producers)
+      t.join();
+  }
+
+  SUBCASE("Push from a GPIO interrupt handler")
+  {
+    static uint8_t storage[HAL_QUEUE_STORAGE_SIZE(sizeof(int), 16)];
+    static hal_queue_t q;
+    REQUIRE(hal_queue_init(&q, HAL_QUEUE_SPSC, storage, sizeof(int), 16) == HAL_OK);
+
+    v4::hal::GpioPin pin(23, HAL_GPIO_INPUT);
+    hal_sim_gpio_input(23, HAL_GPIO_LOW);
+    REQUIRE(hal_gpio_irq_attach(
+                23, HAL_GPIO_IRQ_RISING, [](int p, void*) { hal_queue_push(&q, &p); },
+                nullptr) == HAL_OK);
+    hal_sim_gpio_input(23, HAL_GPIO_HIGH);
+
+    int received = -1;
+    for (int i = 0; i < 500 && hal_queue_pop(&q, &received) == 0; i++)
+      v4::hal::delay_ms(1);
+    CHECK(received == 23);
+    CHECK(hal_gpio_irq_detach(23) == HAL_OK);
+  }
+}
+
+TEST_CASE("GPIO recording")
+{
+  auto read_file = [](const char* path)
+  {
+    std::vector<uint8_t> data;
+    FILE* f = fopen(path, "rb");
+    REQUIRE(f);
+    uint8_t buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+      data.insert(data.end(), buf, buf + n);
+    fclose(f);
+    return data;
+  };
+  char path[] = "/tmp/v4_hal_trace_XXXXXX";
+  int fd = mkstemp(path);
+  REQUIRE(fd >= 0);
+  close(fd);
+
+  REQUIRE(hal_gpio_mode(28, HAL_GPIO_OUTPUT) == HAL_OK);
+  REQUIRE(hal_gpio_mode(29, HAL_GPIO_OUTPUT) == HAL_OK);
+  REQUIRE(hal_gpio_write(28, HAL_GPIO_LOW) == HAL_OK);
+  REQUIRE(hal_gpio_write(29, HAL_GPIO_LOW) == HAL_OK);
+
+  SUBCASE("Binary trace from several threads")
+  {
+    constexpr int kWrites = 1000;
+    uint64_t start = hal_micros();
+    REQUIRE(hal_sim_gpio_record_start(path, HAL_SIM_TRACE_BINARY) == HAL_OK);
+    std::thread other(
+        []()
+        {
+          for (int i = 0; i < kWrites; i++)
+            hal_gpio_write(29, (i % 2) ? HAL_GPIO_LOW : HAL_GPIO_HIGH);
+        });
+    for (int i = 0; i < kWrites; i++)
+      hal_gpio_write(28, (i % 2) ? HAL_GPIO_LOW : HAL_GPIO_HIGH);
+    other.join();
+    hal_gpio_mode(28, HAL_GPIO_INPUT);
+
+    hal_sim_trace_stats_t stats;
+    REQUIRE(hal_sim_gpio_record_stop(&stats) == HAL_OK);
+    uint64_t end = hal_micros();
+    CHECK(stats.dropped == 0);
+
+    std::vector<uint8_t> data = read_file(path);
+    REQUIRE(data.size() == stats.bytes);
+    REQUIRE(data.size() >= 16);
+    CHECK(memcmp(data.data(), "V4GT\x01", 5) == 0);
+    int pins = data[6] | data[7] << 8;
+    uint64_t t = 0;
+    for (int i = 0; i < 8; i++)
+      t |= static_cast<uint64_t>(data[8 + i]) << (8 * i);
+    CHECK(t >= start);
+
+    // Snapshot, then each pin's transitions in order
+    uint64_t records = 0;
+    int level_changes[2] = {};
+    int next_level[2] = {1, 1};
+    bool ordered = true;
+    int pin28_last_kind = -1;
+    for (size_t pos = 16; pos < data.size();)
+    {
+      uint64_t delta;
+      uint64_t code;
+      size_t a = v4::hal::varint_decode(&data[pos], data.size() - pos, &delta);
+      REQUIRE(a);
+      size_t c = v4::hal::varint_decode(&data[pos + a], data.size() - pos - a, &code);
+      REQUIRE(c);
+      pos += a + c;
+      t += delta;
+      if (records++ < static_cast<uint64_t>(2 * pins))
+        continue;
+
+      int pin = static_cast<int>(code >> 2);
+      int kind = static_cast<int>(code & 3);
+      if (pin == 28)
+        pin28_last_kind = kind;
+      if ((pin == 28 || pin == 29) && kind < 2)
+      {
+        ordered = ordered && kind == next_level[pin - 28];
+        next_level[pin - 28] ^= 1;
+        level_changes[pin - 28]++;
+      }
+    }
+    CHECK(records == stats.events);
+    CHECK(t <= end);
+    CHECK(ordered);
+    CHECK(level_changes[0] == kWrites);
+    CHECK(level_changes[1] == kWrites);
+    CHECK(pin28_last_kind == 2);  // Switched to input
+  }
+
+  SUBCASE("VCD trace")
+  {
+    REQUIRE(hal_sim_gpio_record_start(path, HAL_SIM_TRACE_VCD) == HAL_OK);
+    hal_gpio_write(28, HAL_GPIO_HIGH);
+    hal_delay_ms(2);
+    hal_gpio_write(28, HAL_GPIO_LOW);
+    REQUIRE(hal_sim_gpio_record_stop(nullptr) == HAL_OK);
+
+    std::vector<uint8_t> data = read_file(path);
+    std::string vcd(data.begin(), data.end());
+    CHECK(vcd.find("$timescale 1us $end") != std::string::npos);
+    CHECK(vcd.find("$var wire 1 Y pin28 $end") != std::string::npos);  // Var 2 * 28
+    CHECK(vcd.find("$enddefinitions $end\n#0\n") != std::string::npos);
+    size_t rise = vcd.find("\n1Y\n");
+    size_t fall = vcd.find("\n0Y\n", rise);
+    REQUIRE(rise != std::string::npos);
+    REQUIRE(fall != std::string::npos);
+    CHECK(vcd.rfind('#', fall) > rise);  // Later timestamp
+  }
+
+  SUBCASE("Errors")
+  {
+    CHECK(hal_sim_gpio_record_stop(nullptr) == HAL_ERR_PARAM);
+    CHECK(hal_sim_gpio_record_start(nullptr, HAL_SIM_TRACE_VCD) == HAL_ERR_PARAM);
+    CHECK(hal_sim_gpio_record_start("/nonexistent/dir/trace", HAL_SIM_TRACE_VCD) ==
+          HAL_ERR_IO);
+    REQUIRE(hal_sim_gpio_record_start(path, HAL_SIM_TRACE_BINARY) == HAL_OK);
+    CHECK(hal_sim_gpio_record_start(path, HAL_SIM_TRACE_BINARY) == HAL_ERR_BUSY);
+    CHECK(hal_sim_gpio_record_stop(nullptr) == HAL_OK);
+  }
+
+  unlink(path);
+}
+
+TEST_CASE("Stimulus replay")
+{
+  // Stimulus file builder: "V4SI" header, then varint records
+  std::vector<uint8_t> file = {'V', '4', 'S', 'I', 1, 0, 32, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+  auto varint = [&](uint64_t v)
+  {
+    uint8_t buf[v4::hal::kVarintMaxBytes];
+    file.insert(file.end(), buf, buf + v4::hal::varint_encode(v, buf));
+  };
+  auto pin = [&](uint64_t delta, int p, int level)
+  {
+    varint(delta);
+    varint(static_cast<uint64_t>(p) << 2 | static_cast<uint64_t>(level));
+  };
+  auto uart = [&](uint64_t delta, int port, const std::string& data)
+  {
+    varint(delta);
+    varint(static_cast<uint64_t>(port) << 2 | 2);
+    varint(data.size());
+    file.insert(file.end(), data.begin(), data.end());
+  };
+  char path[] = "/tmp/v4_hal_stim_XXXXXX";
+  int fd = mkstemp(path);
+  REQUIRE(fd >= 0);
+  auto save = [&]()
+  {
+    REQUIRE(ftruncate(fd, 0) == 0);
+    REQUIRE(pwrite(fd, file.data(), file.size(), 0) == static_cast<ssize_t>(file.size()));
+  };
+
+  v4::hal::GpioPin in(24, HAL_GPIO_INPUT);
+  v4::hal::GpioPin out(25, HAL_GPIO_OUTPUT);
+  hal_sim_gpio_input(24, HAL_GPIO_LOW);
+  out.write(HAL_GPIO_LOW);
+
+  SUBCASE("Pins and UART bytes arrive on time")
+  {
+    std::atomic<int> count{0};
+    irq_hits = 0;
+    REQUIRE(hal_gpio_irq_attach(24, HAL_GPIO_IRQ_RISING, count_irq, &count) == HAL_OK);
+    hal_uart_config_t config = uart_config(115200, HAL_UART_BACKEND_NONE);
+    hal_handle_t port = hal_uart_open(2, &config);
+    REQUIRE(port);
+
+    pin(0, 24, 1);
+    uart(20000, 2, "hello");
+    pin(0, 25, 1);      // Output: ignored
+    uart(0, 3, "xy");   // Not open: dropped
+    pin(10000, 24, 0);
+    save();
+
+    uint64_t start = hal_micros();
+    REQUIRE(hal_sim_stimulus_start(path) == HAL_OK);
+    CHECK(hal_sim_stimulus_start(path) == HAL_ERR_BUSY);
+    CHECK(wait_irq_count(count, 1));
+    CHECK(irq_hits.load() == (1u << 24));
+
+    uint8_t buf[8] = {};
+    CHECK(hal_uart_read_timeout(port, buf, 5, 1000000) == 5);
+    CHECK(hal_micros() - start >= 20000);
+    CHECK(memcmp(buf, "hello", 5) == 0);
+
+    REQUIRE(hal_sim_stimulus_wait(1000) == HAL_OK);
+    CHECK(in.read() == HAL_GPIO_LOW);
+    CHECK(out.read() == HAL_GPIO_LOW);
+    hal_sim_stimulus_stats_t stats;
+    CHECK(hal_sim_stimulus_stop(&stats) == HAL_OK);
+    CHECK(stats.gpio_events == 2);
+    CHECK(stats.uart_bytes == 5);
+    CHECK(stats.ignored == 1);
+    CHECK(stats.dropped == 2);
+    CHECK(count.load() == 1);
+
+    hal_gpio_irq_detach(24);
+    hal_uart_close(port);
+  }
+
+  SUBCASE("Streams records larger than the mapping window")
+  {
+    uart(0, 3, std::string(3 << 20, 'x'));
+    pin(0, 24, 1);
+    save();
+
+    REQUIRE(hal_sim_stimulus_start(path) == HAL_OK);
+    REQUIRE(hal_sim_stimulus_wait(5000) == HAL_OK);
+    hal_sim_stimulus_stats_t stats;
+    CHECK(hal_sim_stimulus_stop(&stats) == HAL_OK);
+    CHECK(stats.dropped == (3u << 20));
+    CHECK(stats.gpio_events == 1);
+    CHECK(in.read() == HAL_GPIO_HIGH);
+  }
+
+  SUBCASE("Exact timing in virtual time")
+  {
+    hal_clock_source_t saved = hal_timer_get_source();
+    REQUIRE(hal_timer_set_source(HAL_CLOCK_VIRTUAL) == HAL_OK);
+    pin(1000000, 24, 1);
+    pin(1000000, 24, 0);
+    save();
+
+    hal_sim_time_attach();  // Hold the clock until we delay
+    uint64_t start = hal_micros();
+    REQUIRE(hal_sim_stimulus_start(path) == HAL_OK);
+    hal_delay_until_us(start + 999999);
+    CHECK(in.read() == HAL_GPIO_LOW);
+    hal_delay_until_us(start + 1000000);
+    hal_delay_until_us(start + 1999999);
+    CHECK(in.read() == HAL_GPIO_HIGH);
+    hal_delay_until_us(start + 2000000);
+    hal_delay_us(1);
+    CHECK(in.read() == HAL_GPIO_LOW);
+
+    hal_sim_time_detach();
+    hal_sim_stimulus_stats_t stats;
+    CHECK(hal_sim_stimulus_stop(&stats) == HAL_OK);
+    CHECK(stats.max_late_us == 0);
+    REQUIRE(hal_timer_set_source(saved) == HAL_OK);
+  }
+
+  SUBCASE("Recorded traces replay their levels")
+  {
+    file[2] = 'G';
+    file[3] = 'T';
+    pin(0, 24, 3);  // Direction record: skipped
+    pin(0, 24, 1);
+    save();
+
+    REQUIRE(hal_sim_stimulus_start(path) == HAL_OK);
+    REQUIRE(hal_sim_stimulus_wait(1000) == HAL_OK);
+    hal_sim_stimulus_stats_t stats;
+    CHECK(hal_sim_stimulus_stop(&stats) == HAL_OK);
+    CHECK(stats.gpio_events == 1);
+    CHECK(in.read() == HAL_GPIO_HIGH);
+  }
+
+  SUBCASE("Errors")
+  {
+    CHECK(hal_sim_stimulus_stop(nullptr) == HAL_ERR_PARAM);
+    CHECK(hal_sim_stimulus_wait(0) == HAL_ERR_PARAM);
+    CHECK(hal_sim_stimulus_start(nullptr) == HAL_ERR_PARAM);
+    CHECK(hal_sim_stimulus_start("/nonexistent/stimulus") == HAL_ERR_IO);
+
+    file[0] = 'X';
+    save();
+    CHECK(hal_sim_stimulus_start(path) == HAL_ERR_IO);
+
+    file[0] = 'V';
+    uart(0, 2, "abc");
+    file.pop_back();  // Truncated payload
+    save();
+    REQUIRE(hal_sim_stimulus_start(path) == HAL_OK);
+    REQUIRE(hal_sim_stimulus_wait(1000) == HAL_OK);
+    CHECK(hal_sim_stimulus_stop(nullptr) == HAL_ERR_IO);
+  }
+
+  close(fd);
+  unlink(path);
+}
+
+TEST_CASE("SYS dispatch")
+{
+  // Minimal VM data stack applying the table's stack effects in bulk
+  hal_sys_cell_t stack[16];
+  int sp = 0;
+  auto sys = [&](uint8_t id)
+  {
+    const hal_sys_entry_t& e = hal_sys_table[id];
+    REQUIRE(e.fn);
+    REQUIRE(sp >= e.in);
+    sp -= e.in;
+    e.fn(&stack[sp]);
+    sp += e.out;
+  };
+  auto pop = [&]() { return stack[--sp]; };
+
+  SUBCASE("Table layout")
+  {
+    int assigned = 0;
+    for (const hal_sys_entry_t& e : hal_sys_table)
+      assigned += e.fn != nullptr;
+    int defined = 0;
+#define HAL_SYS(name, id, in, out, effect) defined++;
+#include "v4/hal_sys.def"
+#undef HAL_SYS
+    CHECK(assigned == defined);
+    CHECK(hal_sys_table[HAL_SYS_GPIO_READ].in == 1);
+    CHECK(hal_sys_table[HAL_SYS_GPIO_READ].out == 2);
+    CHECK(std::string(hal_sys_table[HAL_SYS_MICROS].name) == "MICROS");
+    CHECK(std::string(hal_sys_table[0x22].effect) == "( ms -- )");
+    CHECK(hal_sys_table[0x30].fn == nullptr);
+
+    hal_sys_cell_t args[2] = {};
+    CHECK(hal_sys_call(0x30, args) == HAL_ERR_NOTSUP);
+    CHECK(hal_sys_call(HAL_SYS_MILLIS, args) == HAL_OK);
+  }
+
+  SUBCASE("GPIO")
+  {
+    stack[sp++] = 24;
+    stack[sp++] = 1;  // OUTPUT in SYS numbering
+    sys(HAL_SYS_GPIO_INIT);
+    CHECK(pop() == HAL_OK);
+
+    stack[sp++] = 24;
+    stack[sp++] = 1;
+    sys(HAL_SYS_GPIO_WRITE);
+    CHECK(pop() == HAL_OK);
+
+    stack[sp++] = 24;
+    sys(HAL_SYS_GPIO_READ);
+    CHECK(pop() == HAL_OK);
+    CHECK(pop() == 1);
+    CHECK(sp == 0);
+
+    stack[sp++] = 24;
+    stack[sp++] = 9;
+    sys(HAL_SYS_GPIO_INIT);
+    CHECK(pop() == HAL_ERR_PARAM);
+  }
+
+  SUBCASE("Timer")
+  {
+    uint64_t before = hal_micros();
+    sys(HAL_SYS_MICROS);
+    uint32_t hi = static_cast<uint32_t>(pop());
+    uint32_t lo = static_cast<uint32_t>(pop());
+    uint64_t us = (static_cast<uint64_t>(hi) << 32) | lo;
+    CHECK(us >= before);
+    CHECK(us <= hal_micros());
+
+    stack[sp++] = 2;
+    sys(HAL_SYS_DELAY_MS);
+    CHECK(sp == 0);
+  }
+
+  SUBCASE("Batch")
+  {
+    const hal_op_t ops[] = {
+        {HAL_SYS_GPIO_INIT, {25, 1}},  {HAL_SYS_GPIO_WRITE, {25, 1}},
+        {HAL_SYS_DELAY_US, {5, 0}},    {HAL_SYS_GPIO_READ, {25, 0}},
+        {HAL_SYS_GPIO_WRITE, {25, 0}}, {HAL_SYS_GPIO_READ, {25, 0}},
+    };
+    hal_sys_cell_t results[8] = {};
+    REQUIRE(hal_submit_batch(ops, 6, results) == 7);
+    const hal_sys_cell_t expected[] = {HAL_OK, HAL_OK, 1, HAL_OK, HAL_OK, 0, HAL_OK};
+    for (int i = 0; i < 7; i++)
+      CHECK(results[i] == expected[i]);
+
+    // Nothing runs if any op is unassigned
+    const hal_op_t bad[] = {{HAL_SYS_GPIO_WRITE, {25, 1}}, {0x30, {0, 0}}};
+    CHECK(hal_submit_batch(bad, 2, results) == HAL_ERR_NOTSUP);
+    hal_gpio_value_t value;
+    CHECK(hal_gpio_read(25, &value) == HAL_OK);
+    CHECK(value == HAL_GPIO_LOW);
+
+    CHECK(hal_submit_batch(nullptr, 1, results) == HAL_ERR_PARAM);
+    CHECK(hal_submit_batch(ops, 0, nullptr) == 0);
+  }
+
+  SUBCASE("Batch runs inside the critical section between delays")
+  {
+    REQUIRE(hal_gpio_mode(26, HAL_GPIO_OUTPUT) == HAL_OK);
+    REQUIRE(hal_gpio_write(26, HAL_GPIO_LOW) == HAL_OK);
+    const hal_op_t ops[] = {
+        {HAL_SYS_GPIO_WRITE, {26, 1}},
+        {HAL_SYS_GPIO_WRITE, {26, 0}},
+        {HAL_SYS_GPIO_WRITE, {26, 1}},
+        {HAL_SYS_DELAY_MS, {200, 0}},
+        {HAL_SYS_GPIO_WRITE, {26, 0}},
+    };
+
+    // The first three writes are atomic, so a critical section never sees
+    // the pin low while it is still pulsing; the delay releases the
+    // section, so entering it does not wait for the whole batch
+    hal_gpio_value_t seen = HAL_GPIO_LOW;
+    uint32_t waited = 0;
+    std::thread observer(
+        [&seen, &waited]()
+        {
+          hal_gpio_value_t v = HAL_GPIO_LOW;
+          uint32_t start = hal_millis();
+          while (hal_gpio_read(26, &v) == HAL_OK && v == HAL_GPIO_LOW &&
+                 hal_millis() - start < 1000)
+            std::this_thread::yield();
+          uint32_t entered = hal_millis();
+          hal_critical_enter();
+          waited = hal_millis() - entered;
+          hal_gpio_read(26, &seen);
+          hal_critical_exit();
+        });
+    hal_sys_cell_t results[4];
+    CHECK(hal_submit_batch(ops, 5, results) == 4);
+    observer.join();
+    CHECK(seen == HAL_GPIO_HIGH);
+    CHECK(waited < 150);
+  }
+
+  SUBCASE("UART without UART_INIT")
+  {
+    stack[sp++] = 5;
+    sys(HAL_SYS_UART_GETC);
+    CHECK(pop() == HAL_ERR_NODEV);
+    pop();
+
+    stack[sp++] = -1;
+    stack[sp++] = 'A';
+    sys(HAL_SYS_UART_PUTC);
+    CHECK(pop() == HAL_ERR_NODEV);
+  }
+}
+
+TEST_CASE("Contexts")
+{
+  SUBCASE("Boards are isolated")
+  {
+    CHECK(hal_get_capabilities()->has_contexts);
+    v4::hal::Context a;
+    v4::hal::Context b;
+    CHECK(hal_context_current() == nullptr);
+    {
+      v4::hal::ContextBinding bind(a);
+      CHECK(hal_context_current() == a.get());
+      v4::hal::GpioPin led(5, HAL_GPIO_OUTPUT);
+      led.write(HAL_GPIO_HIGH);
+    }
+    CHECK(hal_context_current() == nullptr);
+    {
+      v4::hal::ContextBinding bind(b);
+      v4::hal::GpioPin led(5, HAL_GPIO_INPUT);
+      CHECK(led.read() == HAL_GPIO_LOW);
+      CHECK(hal_gpio_write(5, HAL_GPIO_HIGH) == HAL_ERR_PARAM);  // Input on this board
+    }
+    CHECK(hal_context_bind(a.get()) == nullptr);
+    CHECK(v4::hal::gpio_read_bank(0) == (1u << 5));
+    CHECK(hal_context_bind(nullptr) == a.get());
+  }
+
+  SUBCASE("Interrupts dispatch in their context")
+  {
+    struct Seen
+    {
+      std::atomic<int> count{0};
+      std::atomic<hal_context_t*> ctx{nullptr};
+    } seen;
+    auto on_edge = [](int, void* user_data)
+    {
+      auto* s = static_cast<Seen*>(user_data);
+      s->ctx = hal_context_current();
+      s->count++;
+    };
+    v4::hal::Context a;
+    v4::hal::Context b;
+
+    v4::hal::ContextBinding bind(a);
+    v4::hal::GpioPin in(6, HAL_GPIO_INPUT);
+    REQUIRE(hal_gpio_irq_attach(6, HAL_GPIO_IRQ_RISING, on_edge, &seen) == HAL_OK);
+    {
+      v4::hal::ContextBinding other(b);
+      CHECK(hal_gpio_irq_attach(6, HAL_GPIO_IRQ_RISING, on_edge, &seen) == HAL_OK);
+      REQUIRE(hal_gpio_irq_detach(6) == HAL_OK);
+      hal_sim_gpio_input(6, HAL_GPIO_HIGH);
+    }
+    hal_sim_gpio_input(6, HAL_GPIO_HIGH);
+    CHECK(wait_irq_count(seen.count, 1));
+    v4::hal::delay_ms(20);
+    CHECK(seen.count.load() == 1);
+    CHECK(seen.ctx.load() == a.get());
+    REQUIRE(hal_gpio_irq_detach(6) == HAL_OK);
+  }
+
+  SUBCASE("Boards share one interrupt dispatcher")
+  {
+    constexpr int kBoards = 200;
+    struct Board
+    {
+      hal_context_t* ctx = nullptr;
+      std::atomic<int> hits{0};
+      std::atomic<bool> in_context{true};
+    };
+    std::vector<Board> boards(kBoards);
+    auto on_edge = [](int, void* user_data)
+    {
+      auto* b = static_cast<Board*>(user_data);
+      if (hal_context_current() != b->ctx)
+        b->in_context = false;
+      b->hits++;
+    };
+    auto threads = []()
+    {
+      int n = 0;
+#ifdef __linux__
+      if (DIR* dir = opendir("/proc/self/task"))
+      {
+        while (struct dirent* e = readdir(dir))
+          n += (e->d_name[0] != '.');
+        closedir(dir);
+      }
+#endif
+      return n;
+    };
+
+    int before = threads();
+    bool attached = true;
+    for (Board& b : boards)
+    {
+      b.ctx = hal_context_create();
+      REQUIRE(b.ctx);
+      v4::hal::ContextBinding bind(b.ctx);
+      hal_gpio_mode(6, HAL_GPIO_INPUT);
+      attached = hal_gpio_irq_attach(6, HAL_GPIO_IRQ_RISING, on_edge, &b) == HAL_OK &&
+                 attached;
+      hal_sim_gpio_input(6, HAL_GPIO_HIGH);
+    }
+    CHECK(attached);
+    CHECK(threads() - before <= 1);  // The dispatcher, if nothing started it yet
+
+    bool all_fired = true;
+    bool all_in_context = true;
+    for (Board& b : boards)
+    {
+      all_fired = wait_irq_count(b.hits, 1) && all_fired;
+      all_in_context = b.in_context.load() && all_in_context;
+      v4::hal::ContextBinding bind(b.ctx);
+      hal_gpio_irq_detach(6);
+    }
+    CHECK(all_fired);
+    CHECK(all_in_context);
+
+    bool all_destroyed = true;
+    for (Board& b : boards)
+      all_destroyed = hal_context_destroy(b.ctx) == HAL_OK && all_destroyed;
+    CHECK(all_destroyed);
+  }
+
+  SUBCASE("Critical sections are per context")
+  {
+    v4::hal::Context a;
+    v4::hal::Context b;
+    std::atomic<bool> entered{false};
+    auto enter_in = [&](hal_context_t* ctx)
+    {
+      v4::hal::ContextBinding bind(ctx);
+      v4::hal::CriticalSection cs;
+      entered = true;
+    };
+
+    v4::hal::ContextBinding bind(a);
+    hal_critical_enter();
+    std::thread other(enter_in, b.get());
+    other.join();  // Would deadlock if b shared a's lock
+    CHECK(entered.load());
+
+    entered = false;
+    std::thread same(enter_in, a.get());
+    v4::hal::delay_ms(20);
+    CHECK_FALSE(entered.load());
+    hal_critical_exit();
+    same.join();
+    CHECK(entered.load());
+  }
+
+  SUBCASE("Timer callbacks run in their creator's context")
+  {
+    v4::hal::Context a;
+    std::atomic<hal_context_t*> seen{nullptr};
+    auto on_expiry = [](hal_handle_t, void* user_data)
+    {
+      auto* seen = static_cast<std::atomic<hal_context_t*>*>(user_data);
+      seen->store(hal_context_current());
+    };
+
+    v4::hal::ContextBinding bind(a);
+    v4::hal::SoftTimer timer(on_expiry, &seen);
+    timer.start(1000);
+    for (int i = 0; i < 1000 && !seen.load(); i++)
+      v4::hal::delay_ms(1);
+    CHECK(seen.load() == a.get());
+  }
+
+  SUBCASE("Thousands of boards")
+  {
+    constexpr int kBoards = 2000;
+    constexpr int kThreads = 8;
+    std::vector<hal_context_t*> boards(kBoards);
+    bool all_created = true;
+    for (auto& ctx : boards)
+      all_created = (ctx = hal_context_create()) != nullptr && all_created;
+    REQUIRE(all_created);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; t++)
+    {
+      threads.emplace_back(
+          [&, t]()
+          {
+            for (int i = t; i < kBoards; i += kThreads)
+            {
+              hal_context_bind(boards[i]);
+              hal_gpio_mode(1, HAL_GPIO_OUTPUT);
+              hal_gpio_write(1, (i & 1) ? HAL_GPIO_HIGH : HAL_GPIO_LOW);
+              hal_gpio_toggle(1);
+            }
+            hal_context_bind(nullptr);
+          });
+    }
+    for (auto& th : threads)
+      th.join();
+
+    bool all_toggled = true;
+    for (int i = 0; i < kBoards; i++)
+    {
+      hal_context_bind(boards[i]);
+      hal_gpio_value_t value;
+      hal_gpio_read(1, &value);
+      all_toggled = all_toggled && value == ((i & 1) ? HAL_GPIO_LOW : HAL_GPIO_HIGH);
+    }
+    hal_context_bind(nullptr);
+    CHECK(all_toggled);
+
+    bool all_destroyed = true;
+    for (hal_context_t* ctx : boards)
+      all_destroyed = all_destroyed && hal_context_destroy(ctx) == HAL_OK;
+    CHECK(all_destroyed);
+  }
+
+  SUBCASE("Destroy")
+  {
+    CHECK(hal_context_destroy(nullptr) == HAL_ERR_PARAM);
+    hal_context_t* ctx = hal_context_create();
+    REQUIRE(ctx);
+
+    char path[] = "/tmp/v4_hal_ctx_XXXXXX";
+    int fd = mkstemp(path);
+    REQUIRE(fd >= 0);
+    close(fd);
+    hal_context_bind(ctx);
+    REQUIRE(hal_sim_gpio_record_start(path, HAL_SIM_TRACE_BINARY) == HAL_OK);
+    CHECK(hal_context_destroy(ctx) == HAL_ERR_BUSY);
+    hal_context_bind(nullptr);
+
+    CHECK(hal_context_destroy(ctx) == HAL_OK);
+    CHECK(hal_sim_gpio_record_stop(nullptr) == HAL_ERR_PARAM);  // Stopped with it
+    unlink(path);
+  }
+
+  SUBCASE("SYS UART handles are per context")
+  {
+    auto on = [](hal_context_t* ctx, uint8_t id, hal_sys_cell_t a, hal_sys_cell_t b)
+    {
+      hal_sys_cell_t cells[HAL_SYS_MAX_CELLS] = {a, b};
+      hal_context_t* previous = hal_context_bind(ctx);
+      hal_sys_call(id, cells);
+      hal_context_bind(previous);
+      return cells[hal_sys_table[id].out - 1];  // err is pushed last
+    };
+
+    hal_context_t* a = hal_context_create();
+    hal_context_t* b = hal_context_create();
+    REQUIRE(a);
+    REQUIRE(b);
+    CHECK(on(a, HAL_SYS_UART_INIT, 1, 115200) == HAL_OK);
+    CHECK(on(b, HAL_SYS_UART_INIT, 1, 115200) == HAL_OK);
+    CHECK(on(a, HAL_SYS_UART_GETC, 1, 0) == HAL_ERR_TIMEOUT);  // Open, no data
+    CHECK(on(nullptr, HAL_SYS_UART_GETC, 1, 0) == HAL_ERR_NODEV);
+
+    CHECK(hal_context_destroy(a) == HAL_OK);  // Closes its UART_INIT handle
+    CHECK(on(b, HAL_SYS_UART_GETC, 1, 0) == HAL_ERR_TIMEOUT);
+    CHECK(hal_context_destroy(b) == HAL_OK);
+  }
+
+  SUBCASE("Destroy waits for UART handles and timers")
+  {
+    hal_context_t* ctx = hal_context_create();
+    REQUIRE(ctx);
+    hal_context_bind(ctx);
+    hal_uart_config_t config = uart_config(115200, HAL_UART_BACKEND_NONE);
+    hal_handle_t port = hal_uart_open(1, &config);
+    hal_handle_t timer = hal_timer_create([](hal_handle_t, void*) {}, nullptr);
+    hal_context_bind(nullptr);
+    REQUIRE(port);
+    REQUIRE(timer);
+
+    CHECK(hal_context_destroy(ctx) == HAL_ERR_BUSY);
+    CHECK(hal_uart_close(port) == HAL_OK);
+    CHECK(hal_context_destroy(ctx) == HAL_ERR_BUSY);
+    CHECK(hal_timer_delete(timer) == HAL_OK);
+    CHECK(hal_context_destroy(ctx) == HAL_OK);
+  }
+
+  SUBCASE("Destroy waits for every thread bound to the context")
+  {
+    hal_context_t* ctx = hal_context_create();
+    REQUIRE(ctx);
+    std::atomic<int> stage{0};
+    std::thread user([&] {
+      v4::hal::ContextBinding bind(ctx);
+      stage = 1;
+      while (stage.load() != 2)
+        hal_gpio_write(3, HAL_GPIO_HIGH);
+    });
+    while (stage.load() != 1)
+      std::this_thread::yield();
+
+    CHECK(hal_context_destroy(ctx) == HAL_ERR_BUSY);
+    stage = 2;
+    user.join();
+    CHECK(hal_context_destroy(ctx) == HAL_OK);
+  }
 }
 
 TEST_CASE("Console I/O utilities")
@@ -194,4 +2140,62 @@ TEST_CASE("Console I/O utilities")
     // Don't actually call this in test as it may block
     // Just verify it compiles
   }
+
+  SUBCASE("Buffered mode")
+  {
+    char path[] = "/tmp/v4_hal_console_XXXXXX";
+    int fd = mkstemp(path);
+    REQUIRE(fd >= 0);
+    unlink(path);
+    CHECK(hal_console_flush() == HAL_OK);  // Earlier writes go to the real stdout
+    fflush(stdout);
+    int saved = dup(STDOUT_FILENO);
+    dup2(fd, STDOUT_FILENO);
+
+    CHECK(hal_console_set_mode(static_cast<hal_console_mode_t>(7)) == HAL_ERR_PARAM);
+    CHECK_NOTHROW(v4::hal::console_set_mode(HAL_CONSOLE_BUFFERED));
+
+    // More than the default ring holds, so writers also wait for the flusher
+    std::string expected;
+    bool accepted = true;
+    for (int i = 0; expected.size() < 256 * 1024; i++)
+    {
+      std::string line = "line " + std::to_string(i) + "\n";
+      accepted = accepted && v4::hal::console_write(
+                                 reinterpret_cast<const uint8_t*>(line.data()),
+                                 line.size()) == static_cast<int>(line.size());
+      expected += line;
+    }
+    CHECK(accepted);
+    CHECK_NOTHROW(v4::hal::console_flush());
+    CHECK(lseek(fd, 0, SEEK_END) == static_cast<off_t>(expected.size()));
+
+    // An idle flusher is woken by the next write without an explicit flush
+    v4::hal::delay_ms(20);
+    const uint8_t tail[] = "tail\n";
+    CHECK(v4::hal::console_write(tail, 5) == 5);
+    expected += "tail\n";
+    auto written = [&]() { return static_cast<size_t>(lseek(fd, 0, SEEK_END)); };
+    for (int i = 0; i < 500 && written() < expected.size(); i++)
+      v4::hal::delay_ms(1);
+    CHECK(written() == expected.size());
+
+    CHECK_NOTHROW(v4::hal::console_set_mode(HAL_CONSOLE_DIRECT));
+    CHECK(v4::hal::console_write(tail, 5) == 5);
+    expected += "tail\n";
+    CHECK(hal_console_flush() == HAL_OK);
+
+    dup2(saved, STDOUT_FILENO);
+    close(saved);
+#if V4_HAL_POSIX_CONSOLE_BUFFERED
+    CHECK_NOTHROW(v4::hal::console_set_mode(HAL_CONSOLE_BUFFERED));  // hal_init() default
+#endif
+
+    std::string actual(expected.size() + 1, '\0');
+    ssize_t got = pread(fd, &actual[0], actual.size(), 0);
+    CHECK(got == static_cast<ssize_t>(expected.size()));
+    actual.resize(expected.size());
+    CHECK(actual == expected);
+    close(fd);
+  }
 }